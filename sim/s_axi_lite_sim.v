@@ -7,7 +7,20 @@ module s_axi_lite_sim #(
     parameter LOG_BYTE_W   = $clog2(BYTE_WIDTH),
 
     parameter DEV_SIZE     = 4,
-    parameter DEV_ADDR     = $clog2(DEV_SIZE) + LOG_BYTE_W
+    parameter DEV_ADDR     = $clog2(DEV_SIZE) + LOG_BYTE_W,
+
+    // Memory image, one DATA_WIDTH word per line as written by bin2hex.py;
+    // empty for the built-in copy program
+    parameter INIT_FILE    = "",
+
+    // UART0 registers. Accesses in this window never reach the memory:
+    // writes are dropped (the testbench snoops TX FIFO writes off the bus)
+    // and every read returns UART_STATUS, by default TX and RX FIFO empty.
+    // Off by default, as the built-in copy program reads its source
+    // through the 0xFF000000 alias
+    parameter UART_BASE    = 32'hFF00_0000,
+    parameter UART_SIZE    = 32'h0000_0000,
+    parameter UART_STATUS  = 32'h0000_000A
 ) (
     // Shared Clock and Sync Active-Low Reset
     input  wire                     aclk,
@@ -45,38 +58,31 @@ module s_axi_lite_sim #(
 
     reg  [DATA_WIDTH-1:0] mm_dev [0:DEV_SIZE-1];
     
-//    integer              file_handle;
-//    integer              addr_idx;
-//    localparam FILENAME   = "simple_boot.hex";
-    
     initial begin
-//        file_handle = $fopen(FILENAME, "r");
-//        for (addr_idx = 0; !$feof(file_handle); addr_idx=addr_idx+1) begin
-//            $fscanf(file_handle, "%h", mm_dev[addr_idx]);
-//        end
-//        $fclose(file_handle);
-
-
-        // The following is a simple memory copy program
-        // to test the PL/DDR memory transactions.
-        mm_dev[32'h00][31: 0] = 32'h3c20ff00;
-        mm_dev[32'h00][63:32] = 32'h3c405100;
-        mm_dev[32'h01][31: 0] = 32'h3940002D;
-        mm_dev[32'h01][63:32] = 32'h39600038;
-        mm_dev[32'h02][31: 0] = 32'h7c61562a;
-        mm_dev[32'h02][63:32] = 32'h7c625fea;
-        mm_dev[32'h03][31: 0] = 32'h48000000;
-        mm_dev[32'h03][63:32] = 32'h00000000;
-        mm_dev[32'h04][31: 0] = 32'hxxxxxxxx;
-        mm_dev[32'h04][63:32] = 32'hxxxxxxxx;
+        if (INIT_FILE != "") begin
+            $readmemh(INIT_FILE, mm_dev);
+        end else begin
+            // The following is a simple memory copy program
+            // to test the PL/DDR memory transactions.
+            mm_dev[32'h00][31: 0] = 32'h3c20ff00;
+            mm_dev[32'h00][63:32] = 32'h3c405100;
+            mm_dev[32'h01][31: 0] = 32'h3940002D;
+            mm_dev[32'h01][63:32] = 32'h39600038;
+            mm_dev[32'h02][31: 0] = 32'h7c61562a;
+            mm_dev[32'h02][63:32] = 32'h7c625fea;
+            mm_dev[32'h03][31: 0] = 32'h48000000;
+            mm_dev[32'h03][63:32] = 32'h00000000;
+            mm_dev[32'h04][31: 0] = 32'hxxxxxxxx;
+            mm_dev[32'h04][63:32] = 32'hxxxxxxxx;
         
-        mm_dev[32'h05][31: 0] = 32'h33221100;
-        mm_dev[32'h05][63:32] = 32'h77665544;
-        mm_dev[32'h06][31: 0] = 32'hBBAA9988;
-        mm_dev[32'h06][63:32] = 32'hFFEEDDCC;
+            mm_dev[32'h05][31: 0] = 32'h33221100;
+            mm_dev[32'h05][63:32] = 32'h77665544;
+            mm_dev[32'h06][31: 0] = 32'hBBAA9988;
+            mm_dev[32'h06][63:32] = 32'hFFEEDDCC;
         
-        mm_dev[32'h07][31: 0] = 32'hxxxxxxxx;
-        mm_dev[32'h07][63:32] = 32'hxxxxxxxx;
+            mm_dev[32'h07][31: 0] = 32'hxxxxxxxx;
+            mm_dev[32'h07][63:32] = 32'hxxxxxxxx;
+        end
     end
 
     // ---------------------------------------------------------------------
@@ -94,6 +100,12 @@ module s_axi_lite_sim #(
     reg  [DEV_ADDR-1:0] araddr_latched;
     wire [DEV_ADDR-1:LOG_BYTE_W] araddr_word = araddr_latched[DEV_ADDR-1:LOG_BYTE_W];
 
+    // UART window decode, latched with the address
+    reg  aw_uart;
+    reg  ar_uart;
+    wire aw_in_uart = (s_axi_awaddr >= UART_BASE) && (s_axi_awaddr - UART_BASE < UART_SIZE);
+    wire ar_in_uart = (s_axi_araddr >= UART_BASE) && (s_axi_araddr - UART_BASE < UART_SIZE);
+
     integer i;
 
     // ---------------------------------------------------------------------
@@ -114,11 +126,13 @@ module s_axi_lite_sim #(
             // internal latches/flags
             aw_en           <= 1'b0;
             awaddr_latched  <= {DEV_ADDR{1'b0}};
+            aw_uart         <= 1'b0;
             w_en            <= 1'b0;
             wdata_latched   <= {DATA_WIDTH{1'b0}};
             wstrb_latched   <= {BYTE_WIDTH{1'b0}};
             ar_en           <= 1'b0;
             araddr_latched  <= {DEV_ADDR{1'b0}};
+            ar_uart         <= 1'b0;
         end else begin
             // default pulse-based ready deassertions
             s_axi_awready <= 1'b0;
@@ -132,6 +146,7 @@ module s_axi_lite_sim #(
                 // Accept address (pulse s_axi_awready this cycle)
                 s_axi_awready   <= 1'b1;
                 awaddr_latched  <= s_axi_awaddr[DEV_ADDR-1:0];
+                aw_uart         <= aw_in_uart;
                 aw_en           <= 1'b1;
             end
 
@@ -152,9 +167,10 @@ module s_axi_lite_sim #(
             // master accepts it (s_axi_bready).
             // -----------------------------------------------------------------
             if (aw_en && w_en && !s_axi_bvalid) begin
-                // decode latched address
-                for (i=0; i<BYTE_WIDTH; i=i+1)
-                    if (wstrb_latched[i]) mm_dev[awaddr_word][i*8 +: 8] <= wdata_latched[i*8 +: 8];
+                // decode latched address; UART writes are dropped
+                if (!aw_uart)
+                    for (i=0; i<BYTE_WIDTH; i=i+1)
+                        if (wstrb_latched[i]) mm_dev[awaddr_word][i*8 +: 8] <= wdata_latched[i*8 +: 8];
 
                 // produce write response OKAY
                 s_axi_bvalid <= 1'b1;
@@ -176,6 +192,7 @@ module s_axi_lite_sim #(
             if (s_axi_arvalid && !ar_en && !s_axi_arready) begin
                 s_axi_arready   <= 1'b1;
                 araddr_latched  <= s_axi_araddr[DEV_ADDR-1:0];
+                ar_uart         <= ar_in_uart;
                 ar_en           <= 1'b1;
             end
 
@@ -183,7 +200,12 @@ module s_axi_lite_sim #(
             // READ DATA (R) acceptance: produce RDATA/RVALID
             // -----------------------------------------------------------------
             if (ar_en && !s_axi_rvalid) begin
-                s_axi_rdata <= mm_dev[araddr_word];
+                // The status goes on every 32-bit lane, so it reads back
+                // whatever the register's offset within the bus word
+                if (ar_uart)
+                    s_axi_rdata <= {(DATA_WIDTH/32){UART_STATUS}};
+                else
+                    s_axi_rdata <= mm_dev[araddr_word];
                 
                 // provide read data and response (OKAY)
                 s_axi_rvalid <= 1'b1;
@@ -10,7 +10,19 @@ module tb_main;
     localparam S_AXI_DATA_WIDTH = 32;
     localparam S_AXI_BYTE_WIDTH = S_AXI_DATA_WIDTH / 8;
     
+`ifdef MW_SIM_BENCH
+    // Run sw/mw_bench (make SIM=1) from mw_bench.hex in the simulator's
+    // working directory, echoing its console, instead of the copy program
+    localparam DEV_SIZE   = 32768;          // 256KB: image, buffers and stack
+    localparam INIT_FILE  = "mw_bench.hex";
+    localparam RUN_TIME   = 20_000_000;     // ns; the bench stops sooner
+    localparam UART_SIZE  = 32'h0000_1000;  // UART0 decoded, off memory
+`else
     localparam DEV_SIZE   = 1024;
+    localparam INIT_FILE  = "";
+    localparam RUN_TIME   = 10000;
+    localparam UART_SIZE  = 32'h0000_0000;  // The copy program reads the alias
+`endif
 
     // Clock and Reset
     reg                         aclk;
@@ -115,7 +127,9 @@ module tb_main;
         .ADDR_WIDTH     (ADDR_WIDTH         ),
         .DATA_WIDTH     (DATA_WIDTH         ),
         
-        .DEV_SIZE       (DEV_SIZE           )
+        .DEV_SIZE       (DEV_SIZE           ),
+        .INIT_FILE      (INIT_FILE          ),
+        .UART_SIZE      (UART_SIZE          )
     ) s_axi_lite_sim_inst (
         .aclk           (aclk               ),
         .aresetn        (aresetn            ),
@@ -182,6 +196,30 @@ module tb_main;
         end
     endtask
 
+`ifdef MW_SIM_BENCH
+    // ---------- Console: bytes written to the UART0 TX FIFO ----------
+    // mw_bench built with SIM=1 writes them without polling the status
+    // register, and ends with EOT once every result is out. s_axi_lite_sim
+    // decodes the UART window, so these writes never land in its memory
+    localparam UART_FIFO_ADDR = 32'hFF00_0030;
+
+    reg  uart_aw = 1'b0;
+    wire uart_aw_now = m2s_axi_awvalid && s2m_axi_awready && (m2s_axi_awaddr == UART_FIFO_ADDR);
+
+    always @(posedge aclk) begin
+        if (m2s_axi_awvalid && s2m_axi_awready)
+            uart_aw <= uart_aw_now;
+        if (m2s_axi_wvalid && s2m_axi_wready && (uart_aw || uart_aw_now)) begin
+            uart_aw <= 1'b0;
+            if (m2s_axi_wdata[7:0] == 8'h04) begin
+                $display("\n[tb_main] mw_bench finished at %0t ns", $time);
+                $finish;
+            end
+            $write("%c", m2s_axi_wdata[7:0]);
+        end
+    end
+`endif
+
     // Clock Generation
     initial begin
         aclk = 0;
@@ -203,7 +241,7 @@ module tb_main;
         write_slave_reg(32'hA000_0004, 32'h2000_0000);
         write_slave_reg(32'hA000_0000, 32'h0000_0001);
         
-        #10000;
+        #(RUN_TIME);
         $finish;
     end
       
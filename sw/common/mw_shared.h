@@ -0,0 +1,262 @@
+#ifndef __MW_SHARED_H
+#define __MW_SHARED_H
+
+#include <stdint.h>
+
+/*
+ * DRAM area shared by the A53 bootloader, the Microwatt firmware and Linux
+ *
+ * MW_SHARED_BASE is a Microwatt real address. The A53 sees it at
+ * PS_DRAM_BASE_OFFSET + MW_SHARED_BASE. It sits above the 256MB handed to
+ * Linux (phys_mem_size = 0x10000000), so the kernel never allocates it;
+ * user space can read it through /dev/mem. If the kernel memory node is
+ * ever grown past it, the area must be added to /reserved-memory.
+ */
+
+#define MW_SHARED_BASE			0x1FF00000UL
+#define MW_SHARED_SIZE			0x00100000UL	/* 1MB */
+#define MW_LINUX_MEM_SIZE		0x10000000UL	/* Memory handed to Linux */
+
+/* Offsets of the individual blocks inside the shared area */
+#define MW_SHARED_BOOT_STATS_OFFSET	0x00000000UL
+#define MW_SHARED_WARM_OFFSET		0x00001000UL
+#define MW_SHARED_BOOT_ITEMS_OFFSET	0x00002000UL
+#define MW_SHARED_BOOT_INFO_OFFSET	0x00003000UL
+#define MW_SHARED_BULK_OFFSET		0x00004000UL
+#define MW_SHARED_CONSOLE_OFFSET	0x00010000UL
+#define MW_SHARED_PROFILE_OFFSET	0x000A0000UL
+#define MW_SHARED_PROFILE_SIZE		0x00060000UL	/* Up to the end of the area */
+
+/*
+ * Boot-phase timing, written by the A53 bootloader before Microwatt is
+ * released. Times are ticks of the A53 generic counter (CNTPCT_EL0) at
+ * cntfrq Hz.
+ */
+
+#define MW_BOOT_STATS_MAGIC		0x5453574DU	/* "MWST" */
+#define MW_BOOT_STATS_VERSION		3U
+
+/* mw_boot_stats.flags */
+#define MW_BOOT_FLAG_WARM		(1U << 0)	/* Restored from the warm snapshot */
+
+enum {
+	MW_BOOT_PHASE_FW_COPY = 0,	/* Firmware copy into DRAM */
+	MW_BOOT_PHASE_SD_INIT,		/* SD controller and card init */
+	MW_BOOT_PHASE_SD_READ,		/* Card reads, including streamed images */
+	MW_BOOT_PHASE_EXTRACT,		/* ELF copy, decompression, .bss clear */
+	MW_BOOT_PHASE_RELEASE,		/* Microwatt configuration and release */
+	MW_BOOT_PHASE_SNAPSHOT,		/* Warm-restart snapshot save after a cold boot */
+	MW_BOOT_PHASE_COUNT
+};
+
+typedef struct {
+	uint64_t ticks;			/* Counter ticks spent in the phase */
+	uint64_t bytes;			/* Bytes moved, 0 if not a data phase */
+} mw_boot_phase;
+
+typedef struct {
+	uint32_t magic;			/* MW_BOOT_STATS_MAGIC */
+	uint32_t version;		/* MW_BOOT_STATS_VERSION */
+	uint32_t flags;			/* MW_BOOT_FLAG_* */
+	uint32_t reserved;
+	uint64_t cntfrq;		/* Counter frequency in Hz */
+	uint64_t start;			/* Counter value when the bootloader started */
+	uint64_t release;		/* Counter value when Microwatt was released */
+	mw_boot_phase phase[MW_BOOT_PHASE_COUNT];
+} mw_boot_stats;
+
+/*
+ * Warm-restart record, owned by the A53 bootloader. After a cold boot it
+ * describes a pristine copy of the loaded segments kept in PS DRAM outside
+ * the Microwatt/Linux memory. A later run of the bootloader restores that
+ * copy instead of reading the SD card. Clearing magic (e.g. with devmem
+ * from Linux) forces the next run to boot cold from the card.
+ *
+ * hdr[] lists the metadata the cold boot read from the card (boot header,
+ * manifest, kernel header, digest sidecar) with the CRC-32C of each. The
+ * checksums in that metadata cover the whole image, so a warm restart
+ * re-reads it and boots cold when anything differs.
+ */
+
+#define MW_WARM_MAGIC			0x4D52574DU	/* "MWRM" */
+#define MW_WARM_MAX_SEGMENTS		16U
+#define MW_WARM_MAX_HEADERS		4U
+
+typedef struct {
+	uint32_t sector;		/* First card sector */
+	uint32_t count;			/* Sectors read */
+	uint32_t crc;			/* CRC-32C of those sectors */
+	uint32_t reserved;
+} mw_warm_header;
+
+typedef struct {
+	uint64_t dst;			/* A53 address the segment is loaded at */
+	uint64_t file_size;		/* Bytes kept in the snapshot */
+	uint64_t mem_size;		/* Bytes in memory, including .bss */
+} mw_warm_segment;
+
+typedef struct {
+	uint32_t magic;			/* MW_WARM_MAGIC when the snapshot is valid */
+	uint32_t seg_count;
+	uint64_t snapshot;		/* A53 address of the snapshot */
+	uint64_t snapshot_size;
+	uint32_t snapshot_crc;		/* CRC-32C of the snapshot */
+	uint32_t record_crc;		/* CRC-32 of this record, field zeroed */
+	uint32_t hdr_count;
+	uint32_t reserved;
+	mw_warm_header hdr[MW_WARM_MAX_HEADERS];
+	mw_warm_segment seg[MW_WARM_MAX_SEGMENTS];
+} mw_warm_record;
+
+/*
+ * Where the bootloader put each part of the boot, written on every cold
+ * boot. A plain kernel image gives a single MW_BOOT_ITEM_KERNEL item;
+ * a boot manifest adds the device tree and initramfs. Addresses are
+ * Microwatt real addresses.
+ */
+
+#define MW_BOOT_ITEMS_MAGIC		0x5449574DU	/* "MWIT" */
+#define MW_BOOT_MAX_ITEMS		8U
+
+#define MW_BOOT_ITEM_KERNEL		1U	/* addr is the entry point */
+#define MW_BOOT_ITEM_DTB		2U
+#define MW_BOOT_ITEM_INITRD		3U
+
+typedef struct {
+	uint32_t type;			/* MW_BOOT_ITEM_* */
+	uint32_t reserved;
+	uint64_t addr;
+	uint64_t size;			/* Bytes, 0 if not known */
+} mw_boot_item;
+
+typedef struct {
+	uint32_t magic;			/* MW_BOOT_ITEMS_MAGIC */
+	uint32_t count;
+	mw_boot_item item[MW_BOOT_MAX_ITEMS];
+} mw_boot_items;
+
+/*
+ * Kernel handoff for the Microwatt firmware, written by the A53 bootloader
+ * before every release, warm restarts included. The firmware enters the
+ * kernel at entry with r3 = dtb, r4 = entry and r5 = 0. Without
+ * MW_BOOT_INFO_AUTOBOOT it waits for a key on the console first. A firmware
+ * that finds no valid block falls back to its built-in kernel address.
+ * Addresses are Microwatt real addresses.
+ */
+
+#define MW_BOOT_INFO_MAGIC		0x4F48574DU	/* "MWHO" */
+
+/* mw_boot_info.flags */
+#define MW_BOOT_INFO_AUTOBOOT		(1U << 0)	/* Enter the kernel without waiting */
+
+typedef struct {
+	uint32_t magic;			/* MW_BOOT_INFO_MAGIC */
+	uint32_t flags;			/* MW_BOOT_INFO_* */
+	uint64_t entry;			/* Kernel entry point */
+	uint64_t dtb;			/* Device tree, 0 if the kernel carries its own */
+} mw_boot_info;
+
+/*
+ * Memory console: a byte ring that Microwatt software writes its console
+ * output to, and that the A53 bootloader drains to its stdout (UART or
+ * JTAG) once Microwatt is running. The writer never waits for the serial
+ * line, only for ring space.
+ *
+ * The A53 sets up the header before releasing Microwatt. A writer owns
+ * head and the A53 owns tail. Both are free-running byte counts, taken
+ * modulo size to index data. Each sits in its own cache line, since
+ * neither side's caches are coherent with the other:
+ * - a writer stores the bytes, orders them (sync) and then advances
+ *   head. It reads tail with a cache-inhibited load.
+ * - the A53 invalidates head and the data before it reads them. It
+ *   flushes tail after it advances it.
+ * Any writer can use the ring, e.g. a Linux udbg backend, as long as
+ * only one of them writes at a time. Clearing magic stops the service.
+ */
+
+#define MW_CONSOLE_MAGIC		0x4E4F434DU	/* "MCON" */
+#define MW_CONSOLE_DATA_SIZE		0x00080000U	/* 512KB, a power of two */
+#define MW_CONSOLE_LINE			64U		/* Largest cache line of either side */
+
+typedef struct {
+	uint32_t magic;			/* MW_CONSOLE_MAGIC when the A53 drains the ring */
+	uint32_t size;			/* Bytes in data, a power of two */
+	uint8_t pad0[MW_CONSOLE_LINE - 8];
+	uint32_t head;			/* Bytes ever written, owned by the writer */
+	uint8_t pad1[MW_CONSOLE_LINE - 4];
+	uint32_t tail;			/* Bytes ever drained, owned by the A53 */
+	uint8_t pad2[MW_CONSOLE_LINE - 4];
+	uint8_t data[MW_CONSOLE_DATA_SIZE];
+} mw_console;
+
+/*
+ * Bulk-init mailbox: Microwatt software hands large zero fills and copies
+ * of its own memory to the A53, which stores straight to DRAM instead of
+ * paying an AXI-Lite round trip per access. The bootloader runs with its
+ * D-cache off, so that is a doubleword store at a time, not line bursts.
+ * One request at a time.
+ *
+ * The A53 sets up the header before releasing Microwatt and then serves
+ * the mailbox for good. The requester owns the request line and the A53
+ * the reply line; like the console ring, each side reads the other's line
+ * without its cache:
+ * - the requester fills in op, dst, src and len, orders them (sync) and
+ *   then increments seq. It polls done until it equals seq, reads status
+ *   and invalidates its cached copy of dst (dcbf) before using it.
+ * - the A53 does the job, writes status and then sets done to seq.
+ * dst, src and len are Microwatt real addresses and bytes; the whole of
+ * both ranges must lie below MW_LINUX_MEM_SIZE and copies must not overlap.
+ * Requests smaller than MW_BULK_MIN_BYTES are cheaper done in place.
+ */
+
+#define MW_BULK_MAGIC			0x4B4C424DU	/* "MBLK" */
+#define MW_BULK_MIN_BYTES		16384U
+
+#define MW_BULK_OP_ZERO			1U	/* Zero len bytes at dst */
+#define MW_BULK_OP_COPY			2U	/* Copy len bytes from src to dst */
+
+typedef struct {
+	uint32_t magic;			/* MW_BULK_MAGIC while the A53 serves it */
+	uint8_t pad0[MW_CONSOLE_LINE - 4];
+	uint32_t seq;			/* Requests ever posted, owned by the requester */
+	uint32_t op;			/* MW_BULK_OP_* */
+	uint64_t dst;
+	uint64_t src;			/* MW_BULK_OP_COPY only */
+	uint64_t len;
+	uint8_t pad1[MW_CONSOLE_LINE - 32];
+	uint32_t done;			/* Last request finished, owned by the A53 */
+	int32_t status;			/* 0, or -1 for a request it refused */
+	uint8_t pad2[MW_CONSOLE_LINE - 8];
+} mw_bulk;
+
+/*
+ * Sampling profile, written by the Microwatt firmware. Every decrementer
+ * tick records the interrupted address (SRR0) and the six PMU counters.
+ * Counter deltas between samples show what ran in between. The firmware
+ * sets up the header when it starts profiling and then only appends. The
+ * block is read after the fact, e.g. dumped through /dev/mem or JTAG and
+ * turned into a flat profile by sw/mw_welcome/profile.py.
+ */
+
+#define MW_PROFILE_MAGIC		0x4652504DU	/* "MPRF" */
+
+typedef struct {
+	uint64_t pc;			/* SRR0 at the tick */
+	uint32_t pmc[6];		/* PMC1-6; PMC5 counts instructions, PMC6 cycles */
+} mw_profile_sample;
+
+typedef struct {
+	uint32_t magic;			/* MW_PROFILE_MAGIC */
+	uint32_t period;		/* Timebase ticks between samples */
+	uint32_t capacity;		/* Entries in sample[] */
+	uint32_t count;			/* Samples taken, at most capacity */
+	uint32_t dropped;		/* Ticks that found the buffer full */
+	uint32_t reserved;
+	uint64_t mmcr1;			/* Events PMC1-4 counted */
+	mw_profile_sample sample[];
+} mw_profile;
+
+#define MW_PROFILE_CAPACITY		((MW_SHARED_PROFILE_SIZE - sizeof(mw_profile)) / \
+					 sizeof(mw_profile_sample))
+
+#endif /* __MW_SHARED_H */
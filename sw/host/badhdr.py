@@ -0,0 +1,54 @@
+#!/usr/bin/python3
+#
+# Corrupt mw_image header for the loader checks (make check)
+#
+#   badhdr.py short|overlap in.img out.img
+#
+# Rewrites the header of an mwpack image and seals it again with a valid
+# hdr_crc, so only the loader's layout checks can refuse it:
+#   short    hdr_sectors one sector too small for the chunk table
+#   overlap  the first chunk starts inside the header sectors
+
+import struct
+import sys
+import zlib
+
+SECTOR = 512
+HDR = struct.Struct('<IHHIIIIIIQ')	# mw_image_header up to entry
+SEG_SIZE = 40
+MAX_SEGMENTS = 16
+CHUNK = struct.Struct('<IIII')
+CHUNKS_OFF = HDR.size + SEG_SIZE * MAX_SEGMENTS
+MAGIC = 0x4942574D
+
+
+def main():
+    if len(sys.argv) != 4 or sys.argv[1] not in ('short', 'overlap'):
+        sys.exit('usage: badhdr.py short|overlap in.img out.img')
+    kind, src, dst = sys.argv[1:]
+
+    with open(src, 'rb') as f:
+        image = bytearray(f.read())
+    (magic, version, comp, hdr_sectors, seg_count, chunk_count, chunk_size,
+     _, reserved, entry) = HDR.unpack_from(image)
+    if magic != MAGIC:
+        sys.exit('%s: not an mw_image' % src)
+
+    if kind == 'short':
+        table_end = CHUNKS_OFF + CHUNK.size * chunk_count
+        hdr_sectors = (table_end + SECTOR - 1) // SECTOR - 1
+    else:
+        sector, stored, raw, crc = CHUNK.unpack_from(image, CHUNKS_OFF)
+        CHUNK.pack_into(image, CHUNKS_OFF, hdr_sectors - 1, stored, raw, crc)
+
+    HDR.pack_into(image, 0, magic, version, comp, hdr_sectors, seg_count, chunk_count,
+                  chunk_size, 0, reserved, entry)
+    crc = zlib.crc32(bytes(image[:hdr_sectors * SECTOR])) & 0xFFFFFFFF
+    HDR.pack_into(image, 0, magic, version, comp, hdr_sectors, seg_count, chunk_count,
+                  chunk_size, crc, reserved, entry)
+    with open(dst, 'wb') as f:
+        f.write(image)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,7 @@
+#ifndef BSPCONFIG_H
+#define BSPCONFIG_H
+
+#define EL3		1
+#define EL1_NONSECURE	0
+
+#endif /* BSPCONFIG_H */
@@ -0,0 +1,8 @@
+#ifndef SLEEP_H
+#define SLEEP_H
+
+/* Delays advance the model clock instead of the host's */
+int host_usleep(unsigned long useconds);
+#define usleep(us)	host_usleep(us)
+
+#endif /* SLEEP_H */
@@ -0,0 +1,19 @@
+#ifndef XIL_ASSERT_H
+#define XIL_ASSERT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "xil_types.h"
+
+/* A failed driver assertion is a bug in the caller; stop right there */
+#define Xil_AssertNonvoid(Expression) \
+	do { \
+		if (!(Expression)) { \
+			fprintf(stderr, "%s:%d: assertion '%s' failed\n", \
+				__FILE__, __LINE__, #Expression); \
+			abort(); \
+		} \
+	} while (0)
+#define Xil_AssertVoid(Expression)	Xil_AssertNonvoid(Expression)
+
+#endif /* XIL_ASSERT_H */
@@ -0,0 +1,10 @@
+#ifndef XIL_CACHE_H
+#define XIL_CACHE_H
+
+#include "xil_types.h"
+
+/* The model's DMA writes host memory directly; there is nothing to maintain */
+#define Xil_DCacheFlushRange(Addr, Len)		((void)(Addr), (void)(Len))
+#define Xil_DCacheInvalidateRange(Addr, Len)	((void)(Addr), (void)(Len))
+
+#endif /* XIL_CACHE_H */
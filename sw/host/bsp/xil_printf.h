@@ -0,0 +1,8 @@
+#ifndef XIL_PRINTF_H
+#define XIL_PRINTF_H
+
+#include <stdio.h>
+
+#define xil_printf printf
+
+#endif /* XIL_PRINTF_H */
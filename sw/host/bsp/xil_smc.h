@@ -0,0 +1,6 @@
+#ifndef XIL_SMC_H
+#define XIL_SMC_H
+
+#include "xil_types.h"
+
+#endif /* XIL_SMC_H */
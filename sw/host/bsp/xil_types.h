@@ -0,0 +1,30 @@
+/*
+ * Host stand-in for the Xilinx standalone BSP, just enough to build the
+ * vendored sd_card_driver against sdhci_model.c. See sdhci_bsp.c.
+ */
+#ifndef XIL_TYPES_H
+#define XIL_TYPES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef uintptr_t UINTPTR;
+typedef intptr_t INTPTR;
+
+#define TRUE		1U
+#define FALSE		0U
+
+#define XIL_COMPONENT_IS_READY		0x11111111U
+#define XIL_COMPONENT_IS_STARTED	0x22222222U
+
+#define INLINE inline
+
+#endif /* XIL_TYPES_H */
@@ -0,0 +1,19 @@
+#ifndef XIL_UTIL_H
+#define XIL_UTIL_H
+
+#include "xil_types.h"
+
+/*
+ * Polls a register until (value & EventMask) == Event, for up to Timeout
+ * microseconds of model time. Returns XST_SUCCESS or XST_FAILURE.
+ */
+u32 Xil_WaitForEvent(UINTPTR RegAddr, u32 EventMask, u32 Event, u32 Timeout);
+
+/*
+ * Polls a register until any of WaitEvents is set, for up to Timeout
+ * microseconds of model time. The masked value is returned in *Events.
+ */
+u32 Xil_WaitForEvents(UINTPTR EventsRegAddr, u32 EventsMask, u32 WaitEvents,
+		      u32 Timeout, u32 *Events);
+
+#endif /* XIL_UTIL_H */
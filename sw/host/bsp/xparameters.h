@@ -0,0 +1,24 @@
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+
+/* SD1 of the ZCU104, as the bootloader's BSP configures it */
+#define XPAR_XSDPS_NUM_INSTANCES		1
+#define XPAR_XSDPS_0_DEVICE_ID			0
+#define XPAR_XSDPS_0_BASEADDR			0xFF170000U
+#define XPAR_XSDPS_0_SDIO_CLK_FREQ_HZ		187498123
+#define XPAR_XSDPS_0_HAS_CD			1
+#define XPAR_XSDPS_0_HAS_WP			1
+#define XPAR_XSDPS_0_BUS_WIDTH			4
+#define XPAR_XSDPS_0_MIO_BANK			1
+#define XPAR_XSDPS_0_HAS_EMIO			0
+#define XPAR_XSDPS_0_SLOT_TYPE			0
+#define XPAR_XSDPS_0_IS_CACHE_COHERENT		0
+#define XPAR_XSDPS_0_CLK_50_SDR_ITAP_DLY	0
+#define XPAR_XSDPS_0_CLK_50_SDR_OTAP_DLY	0
+#define XPAR_XSDPS_0_CLK_50_DDR_ITAP_DLY	0
+#define XPAR_XSDPS_0_CLK_50_DDR_OTAP_DLY	0
+#define XPAR_XSDPS_0_CLK_100_SDR_OTAP_DLY	0
+#define XPAR_XSDPS_0_CLK_200_SDR_OTAP_DLY	0
+#define XPAR_XSDPS_0_CLK_200_DDR_OTAP_DLY	0
+
+#endif /* XPARAMETERS_H */
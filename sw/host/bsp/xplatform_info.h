@@ -0,0 +1,9 @@
+#ifndef XPLATFORM_INFO_H
+#define XPLATFORM_INFO_H
+
+#include "xil_io.h"
+#include "xparameters.h"
+
+#define XPS_SYS_CTRL_BASEADDR	0xFF180000U	/* IOU_SLCR, tap delays and DLL reset */
+
+#endif /* XPLATFORM_INFO_H */
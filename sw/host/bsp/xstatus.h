@@ -0,0 +1,12 @@
+#ifndef XSTATUS_H
+#define XSTATUS_H
+
+#include "xil_types.h"
+
+#define XST_SUCCESS		0L
+#define XST_FAILURE		1L
+#define XST_DEVICE_IS_STARTED	5L
+#define XST_DMA_ERROR		9L
+#define XST_DEVICE_BUSY		21L
+
+#endif /* XSTATUS_H */
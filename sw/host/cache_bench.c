@@ -0,0 +1,268 @@
+/*
+ * cache_bench - run the bootloader's SD read-ahead cache (sd_cache.c) on a PC.
+ *
+ *   cache_bench [-b MB/s] [-l latency_us] [-c lines] [-w window] card.img
+ *
+ * The cache sits over a simulated card as in bootloader.c, and every
+ * read through it is checked against the card image. Three runs:
+ *
+ *   sequential  the first 4MB in 4KB requests, as a header walk would.
+ *               Fills must double up to max_ahead lines, and each sector
+ *               must come from the card only once.
+ *   metadata    the boot header, digest sidecar and manifest parts read
+ *               over and over. After the first round every read must hit.
+ *   lru         one hot region read between a rotation of more cold ones
+ *               than there are lines. The hot one must never be evicted.
+ *
+ * Each run reports the cache statistics and the card commands and time
+ * it took, next to what the same reads cost without the cache. Runs whose
+ * requests would all bypass the cache are left out, and the metadata run
+ * is only checked when its regions fit in the lines.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sd_cache.h"
+#include "mw_image.h"
+#include "host_card.h"
+
+#define SEQ_BYTES		0x400000U	/* Sequential run length */
+#define SEQ_REQ			8U		/* Sectors per sequential request */
+#define META_ROUNDS		16U
+#define LRU_ROUNDS		8U
+
+typedef struct {
+	uint32_t sector;
+	uint32_t count;
+} region;
+
+/* Small reads of a manifest boot: header, kernel header, digest, parts */
+static const region meta[] = {
+	{ 0, 1 },
+	{ 2048, MW_IMAGE_HDR_MAX_SECTORS },
+	{ 2048 + MW_DIGEST_DEF_SECTOR, MW_DIGEST_SECTORS },
+	{ 6144, 4 },
+	{ 8192, 4 },
+};
+
+static host_card card, ref;
+static sd_cache cache;
+static uint8_t *cache_mem;
+static uint8_t buf[SD_CACHE_MAX_LINES * 64 * LOADER_SECTOR_SIZE];
+static uint8_t want[sizeof(buf)];
+static int failed;
+
+static void reset(uint32_t lines, uint32_t window)
+{
+	card.reads = 0;
+	card.bytes = 0;
+	if (sd_cache_init(&cache, &card.dev, cache_mem, lines, window, 0) != 0) {
+		fprintf(stderr, "sd_cache_init: bad geometry\n");
+		exit(2);
+	}
+}
+
+/* Reads through the cache and checks the data against the card image */
+static void cached_read(uint32_t sector, uint32_t count)
+{
+	if (cache.dev.read(&cache.dev, sector, count, buf) != 0 ||
+	    ref.dev.read(&ref.dev, sector, count, want) != 0) {
+		fprintf(stderr, "read of %u sectors at %u failed\n", count, sector);
+		exit(1);
+	}
+	if (memcmp(buf, want, (size_t)count * LOADER_SECTOR_SIZE) != 0) {
+		fprintf(stderr, "read of %u sectors at %u returned wrong data\n", count, sector);
+		failed = 1;
+	}
+}
+
+static void expect(const char *run, const char *what, int ok)
+{
+	if (!ok) {
+		printf("%-10s FAILED: %s\n", run, what);
+		failed = 1;
+	}
+}
+
+static void report(const char *run, uint64_t t0, uint64_t requests, uint64_t uncached_ns)
+{
+	sd_cache_stats *s = &cache.stats;
+
+	printf("%-10s %6u %6u %6u %6u %8u %6llu %6llu %9.2f %9.2f\n", run,
+	       (unsigned int)s->hits, (unsigned int)s->misses, (unsigned int)s->bypassed,
+	       (unsigned int)s->fills, (unsigned int)s->fill_sectors,
+	       (unsigned long long)card.reads, (unsigned long long)requests,
+	       (double)(host_time_ns() - t0) / 1e6, (double)uncached_ns / 1e6);
+}
+
+/* Card time of one uncached command of count sectors */
+static uint64_t uncached_ns(uint32_t count)
+{
+	uint64_t ns = card.latency_ns;
+
+	if (card.bandwidth != 0)
+		ns += (uint64_t)count * LOADER_SECTOR_SIZE * 1000000000ULL / card.bandwidth;
+	return ns;
+}
+
+static void run_sequential(uint32_t lines, uint32_t window)
+{
+	uint32_t total = SEQ_BYTES / LOADER_SECTOR_SIZE;
+	uint32_t fills = 0, covered = 0, n = 1;
+	uint64_t t0, plain = 0, requests = 0;
+
+	if (SEQ_REQ >= window)
+		return;
+
+	reset(lines, window);
+	t0 = host_time_ns();
+	for (uint32_t s = 0; s < total; s += SEQ_REQ) {
+		cached_read(s, SEQ_REQ);
+		plain += uncached_ns(SEQ_REQ);
+		requests++;
+	}
+	report("sequential", t0, requests, plain);
+
+	/* Fills of 1, 2, 4, ... lines, then max_ahead lines each */
+	while (covered < total) {
+		covered += n * window;
+		fills++;
+		n = n * 2 < cache.max_ahead ? n * 2 : cache.max_ahead;
+	}
+	expect("sequential", "fills do not double up to max_ahead", cache.stats.fills == fills);
+	expect("sequential", "sectors read from the card more than once",
+	       cache.stats.fill_sectors == covered);
+}
+
+static void run_metadata(uint32_t lines, uint32_t window)
+{
+	uint32_t n = sizeof(meta) / sizeof(meta[0]);
+	uint32_t cached = 0;
+	uint64_t t0, plain = 0, requests = 0;
+
+	reset(lines, window);
+	t0 = host_time_ns();
+	for (uint32_t r = 0; r < META_ROUNDS; r++) {
+		for (uint32_t i = 0; i < n; i++) {
+			cached_read(meta[i].sector, meta[i].count);
+			plain += uncached_ns(meta[i].count);
+			requests++;
+		}
+	}
+	report("metadata", t0, requests, plain);
+
+	/* Reads of a window or more bypass the cache; the rest must stay */
+	for (uint32_t i = 0; i < n; i++)
+		cached += meta[i].count < window;
+	if (cached > lines)
+		return;
+	expect("metadata", "metadata was read from the card more than once",
+	       cache.stats.misses == cached && cache.stats.fills == cached);
+	expect("metadata", "repeated reads missed",
+	       cache.stats.hits == (META_ROUNDS - 1) * cached);
+}
+
+static void run_lru(uint32_t lines, uint32_t window)
+{
+	uint32_t cold = lines + 2;
+	uint32_t hot_misses = 0;
+	uint64_t t0, plain = 0, requests = 0;
+
+	if (window == 1)
+		return;
+	reset(lines, window);
+	t0 = host_time_ns();
+	for (uint32_t r = 0; r < LRU_ROUNDS; r++) {
+		for (uint32_t i = 0; i < cold; i++) {
+			uint32_t misses = cache.stats.misses;
+
+			/* Every region in a window of its own, never adjacent */
+			cached_read(0, 1);
+			if (r != 0 || i != 0)
+				hot_misses += cache.stats.misses - misses;
+			cached_read((2 + 2 * i) * window, 1);
+			plain += 2 * uncached_ns(1);
+			requests += 2;
+		}
+	}
+	report("lru", t0, requests, plain);
+
+	expect("lru", "the hot line was evicted", hot_misses == 0);
+	expect("lru", "cold lines hit although more than the cache",
+	       cache.stats.misses == 1 + LRU_ROUNDS * cold);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-b MB/s] [-l latency_us] [-c lines] [-w window] card.img\n"
+		"  -b  simulated card bandwidth in MB/s, 0 for none (default 25)\n"
+		"  -l  simulated latency per read command in us (default 100)\n"
+		"  -c  cache lines (default 8, as SD_CACHE_LINES)\n"
+		"  -w  sectors per line (default 64, as SD_CACHE_WINDOW)\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t bandwidth = 25000000ULL;
+	uint64_t latency_ns = 100000ULL;
+	uint32_t lines = 8;
+	uint32_t window = 64;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:l:c:w:")) != -1) {
+		switch (opt) {
+		case 'b':
+			bandwidth = (uint64_t)(strtod(optarg, NULL) * 1000000.0);
+			break;
+		case 'l':
+			latency_ns = (uint64_t)(strtod(optarg, NULL) * 1000.0);
+			break;
+		case 'c':
+			lines = (uint32_t)strtoul(optarg, NULL, 0);
+			if (lines < 2 || lines > SD_CACHE_MAX_LINES)
+				usage(argv[0]);
+			break;
+		case 'w':
+			window = (uint32_t)strtoul(optarg, NULL, 0);
+			if (window == 0 || window > 64)
+				usage(argv[0]);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (argc - optind != 1)
+		usage(argv[0]);
+
+	/* 4096 sectors per command, the driver's 2MB; the reference is free */
+	if (host_card_open(&card, argv[optind], 4096, bandwidth, latency_ns) != 0 ||
+	    host_card_open(&ref, argv[optind], 4096, 0, 0) != 0)
+		return 1;
+	cache_mem = malloc((size_t)lines * window * LOADER_SECTOR_SIZE);
+	if (!cache_mem) {
+		perror("alloc");
+		return 1;
+	}
+
+	printf("%u lines of %u sectors, max_ahead %u\n", lines, window,
+	       lines / 2 ? lines / 2 : 1);
+	printf("%-10s %6s %6s %6s %6s %8s %6s %6s %9s %9s\n", "run", "hits", "misses",
+	       "bypass", "fills", "sectors", "cmds", "reqs", "ms", "ms uncached");
+	run_sequential(lines, window);
+	run_metadata(lines, window);
+	run_lru(lines, window);
+
+	host_card_close(&card);
+	host_card_close(&ref);
+	free(cache_mem);
+	if (failed)
+		return 1;
+	printf("all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,138 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host_card.h"
+
+static uint64_t sim_ns;		/* Simulated DMA time charged so far */
+
+uint64_t host_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec + sim_ns;
+}
+
+/* Reads len bytes; the card is bigger than the image, the rest reads as zeros */
+static int card_pread(host_card *card, uint32_t sector, size_t len, uint8_t *p)
+{
+	off_t off = (off_t)sector * LOADER_SECTOR_SIZE;
+	ssize_t got;
+
+	while (len > 0) {
+		got = pread(card->fd, p, len, off);
+		if (got < 0)
+			return -1;
+		if (got == 0)
+			break;
+		p += got;
+		off += got;
+		len -= (size_t)got;
+	}
+	for (size_t i = 0; i < len; i++)
+		p[i] = 0;
+
+	return 0;
+}
+
+/* Simulated time of one command moving len bytes */
+static uint64_t card_dma_ns(host_card *card, uint64_t len)
+{
+	uint64_t ns = card->latency_ns;
+
+	if (card->bandwidth != 0)
+		ns += len * 1000000000ULL / card->bandwidth;
+	return ns;
+}
+
+static int host_card_read(mw_blkdev *dev, uint32_t sector, uint32_t count, void *buf)
+{
+	host_card *card = (host_card *)dev;
+	size_t len = (size_t)count * LOADER_SECTOR_SIZE;
+
+	if (count == 0 || count > dev->max_sectors)
+		return -1;
+	if (card_pread(card, sector, len, buf) != 0)
+		return -1;
+
+	card->reads++;
+	card->bytes += len;
+	sim_ns += card_dma_ns(card, len);
+
+	return 0;
+}
+
+/*
+ * The data is in place as soon as start_sg() returns; only the simulated
+ * DMA time runs in the background. wait_sg() charges whatever of it the
+ * caller's own work has not already covered.
+ */
+static int host_card_start_sg(mw_blkdev *dev, const mw_blk_sg *sg, uint32_t count)
+{
+	host_card *card = (host_card *)dev;
+	uint64_t len = 0;
+
+	if (count == 0 || card->busy_until != 0)
+		return -1;
+	for (uint32_t i = 0; i < count; i++) {
+		if (sg[i].len == 0 || (sg[i].len % LOADER_SECTOR_SIZE) != 0 ||
+		    sg[i].sector != sg[0].sector + len / LOADER_SECTOR_SIZE)
+			return -1;
+		if (card_pread(card, sg[i].sector, sg[i].len, (uint8_t *)sg[i].buf) != 0)
+			return -1;
+		len += sg[i].len;
+	}
+
+	card->reads++;
+	card->bytes += len;
+	card->busy_until = host_time_ns() + card_dma_ns(card, len);
+
+	return 0;
+}
+
+static int host_card_wait_sg(mw_blkdev *dev)
+{
+	host_card *card = (host_card *)dev;
+	uint64_t now = host_time_ns();
+
+	if (card->busy_until == 0)
+		return -1;
+	if (now < card->busy_until) {
+		card->stall_ns += card->busy_until - now;
+		sim_ns += card->busy_until - now;
+	}
+	card->busy_until = 0;
+
+	return 0;
+}
+
+int host_card_open(host_card *card, const char *path, uint32_t max_sectors,
+	uint64_t bandwidth, uint64_t latency_ns)
+{
+	card->fd = open(path, O_RDONLY);
+	if (card->fd < 0) {
+		perror(path);
+		return -1;
+	}
+
+	card->dev.max_sectors = max_sectors;
+	card->dev.read = host_card_read;
+	card->dev.start_sg = host_card_start_sg;
+	card->dev.wait_sg = host_card_wait_sg;
+	card->dev.priv = card;
+	card->bandwidth = bandwidth;
+	card->latency_ns = latency_ns;
+	card->reads = 0;
+	card->bytes = 0;
+	card->busy_until = 0;
+	card->stall_ns = 0;
+
+	return 0;
+}
+
+void host_card_close(host_card *card)
+{
+	close(card->fd);
+}
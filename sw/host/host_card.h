@@ -0,0 +1,48 @@
+#ifndef __HOST_CARD_H
+#define __HOST_CARD_H
+
+#include <stdint.h>
+#include "elf_loader.h"
+
+/*
+ * File-backed SD card for the host build
+ *
+ * Sectors come from a card image file (e.g. the boot.img written with dd).
+ * Each read completes at once, but is charged a simulated DMA time of
+ * latency_ns plus the bytes at bandwidth bytes/s. The charge goes onto
+ * the host clock returned by host_time_ns(), so the loader's phase timing
+ * sees the card as if it ran at the configured speed.
+ *
+ * Scatter-gather reads (start_sg) run that time in the background: the
+ * work the loader does before wait_sg() hides it, and only the rest is
+ * charged, as a stall. This is how the pipelined loaders overlap the
+ * card with CRC checks and decompression on the board.
+ */
+
+typedef struct {
+	mw_blkdev dev;			/* Must stay first */
+	int fd;
+	uint64_t bandwidth;		/* Bytes per second, 0 for no delay */
+	uint64_t latency_ns;		/* Per command */
+	uint64_t reads;			/* Commands issued */
+	uint64_t bytes;			/* Bytes transferred */
+	uint64_t busy_until;		/* End of the start_sg() in flight, 0 if none */
+	uint64_t stall_ns;		/* Time wait_sg() spent waiting */
+} host_card;
+
+/**
+ * @brief	Opens a card image.
+ *
+ * @return	0 if successful, -1 otherwise.
+ */
+int host_card_open(host_card *card, const char *path, uint32_t max_sectors,
+	uint64_t bandwidth, uint64_t latency_ns);
+
+void host_card_close(host_card *card);
+
+/**
+ * @brief	Host clock in ns, including the simulated DMA time so far.
+ */
+uint64_t host_time_ns(void);
+
+#endif /* __HOST_CARD_H */
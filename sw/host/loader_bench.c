@@ -0,0 +1,374 @@
+/*
+ * loader_bench - run the bootloader's load paths on a PC and time each phase.
+ *
+ *   loader_bench [-b MB/s] [-l latency_us] [-m max_sectors] [-n runs]
+ *                [-x file.elf] card.img
+ *
+ * card.img is what would be written to the SD card. Like the bootloader,
+ * the bench looks at sector 0: an mw_image container is streamed through
+ * the image pipeline; a plain ELF is read through the verified pipeline
+ * when a digest sidecar sits at MW_DIGEST_DEF_SECTOR. Without one its
+ * segments are read straight into place when the layout allows it, and
+ * otherwise the file is read whole, then extracted. A boot manifest has its raw parts read through the blob
+ * pipeline and its kernel loaded as above. The card reads are charged the simulated bandwidth and
+ * per-command latency, the pipelined ones in the background of the work
+ * done meanwhile; the rest is timed on the host CPU. A DRAM buffer stands
+ * in for the Microwatt memory and every segment is checked to land inside
+ * it. The report matches the table the bootloader prints.
+ *
+ * With -x, the loaded memory is compared with the PT_LOAD segments of
+ * file.elf, .bss included, after the last run.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "elf_loader.h"
+#include "image_loader.h"
+#include "mw_shared.h"
+#include "host_card.h"
+
+#define OS_SIZE_BYTES		0x00700000UL	/* As in bootloader.c */
+#define HOST_DRAM_SIZE		MW_SHARED_BASE	/* Microwatt memory below the shared area */
+#define BOOT_HDR_SECTORS	MW_IMAGE_HDR_MAX_SECTORS
+#define ELF_MAX_SG_SEGMENTS	16U		/* As in bootloader.c */
+
+static mw_boot_stats stats;
+static uint8_t *dram;
+static uint8_t *staging;	/* ELF_OS_BASE_OFFSET area: the file being read */
+static uint8_t *stage;		/* The pipeline's two staging buffers */
+static uint8_t hdr_buf[BOOT_HDR_SECTORS * LOADER_SECTOR_SIZE];
+static uint8_t digest_buf[MW_DIGEST_SECTORS * LOADER_SECTOR_SIZE];
+
+static const char *const phase_name[MW_BOOT_PHASE_COUNT] = {
+	"fw copy", "sd init", "sd read", "extract", "release", "snapshot"
+};
+
+// --- Hooks for elf_loader.c ---
+
+static void check_range(uintptr_t dst, size_t len)
+{
+	if (dst < (uintptr_t)dram || dst + len > (uintptr_t)dram + HOST_DRAM_SIZE) {
+		fprintf(stderr, "segment at 0x%llx (%zu bytes) is outside the Microwatt DRAM\n",
+			(unsigned long long)(dst - (uintptr_t)dram), len);
+		exit(1);
+	}
+}
+
+void loader_copy(uintptr_t dst, uintptr_t src, size_t len)
+{
+	check_range(dst, len);
+	if (src == 0)
+		memset((void *)dst, 0, len);
+	else
+		memcpy((void *)dst, (const void *)src, len);
+}
+
+void loader_note_segment(uintptr_t dst, uint64_t file_size, uint64_t mem_size)
+{
+	(void)file_size;
+	check_range(dst, mem_size);
+}
+
+uint64_t loader_time(void)
+{
+	return host_time_ns();
+}
+
+void loader_phase_end(uint32_t phase, uint64_t start, uint64_t bytes)
+{
+	stats.phase[phase].ticks += host_time_ns() - start;
+	stats.phase[phase].bytes += bytes;
+}
+
+// --- Boot paths, chosen as in load_kernel_from_sd() ---
+
+static const char *const path_name[] = {
+	"image", "verified ELF", "direct ELF", "buffered ELF"
+};
+
+enum { PATH_IMAGE, PATH_VERIFIED, PATH_DIRECT, PATH_BUFFERED };
+
+static uint32_t blobs;		/* Manifest parts loaded besides the kernel */
+
+static int read_header(mw_blkdev *dev, uint32_t sector, uint32_t count, void *buf)
+{
+	uint64_t t0 = loader_time();
+
+	if (dev->read(dev, sector, count, buf) != 0)
+		return -1;
+	loader_phase_end(MW_BOOT_PHASE_SD_READ, t0, (uint64_t)count * LOADER_SECTOR_SIZE);
+	return 0;
+}
+
+/*
+ * Reads an elf_direct_sg() list. The board hands it to XSdPs_ReadSG(),
+ * which issues one command per run of entries that follow each other on
+ * the card; so does this.
+ */
+static int read_sg_list(mw_blkdev *dev, const mw_blk_sg *sg, uint32_t count)
+{
+	uint64_t t0 = loader_time();
+	uint64_t bytes = 0;
+	uint32_t run;
+
+	for (uint32_t i = 0; i < count; i += run) {
+		uint32_t next = sg[i].sector + sg[i].len / LOADER_SECTOR_SIZE;
+
+		for (run = 1; i + run < count && sg[i + run].sector == next; run++)
+			next += sg[i + run].len / LOADER_SECTOR_SIZE;
+		if (dev->start_sg(dev, &sg[i], run) != 0 || dev->wait_sg(dev) != 0)
+			return -1;
+	}
+	for (uint32_t i = 0; i < count; i++)
+		bytes += sg[i].len;
+	loader_phase_end(MW_BOOT_PHASE_SD_READ, t0, bytes);
+	return 0;
+}
+
+/* Loads the kernel whose first sectors are in hdr_buf */
+static int boot_kernel(mw_blkdev *dev, uint32_t sector, int *path)
+{
+	mw_digest *dg = (mw_digest *)digest_buf;
+
+	if (((mw_image_header *)hdr_buf)->magic == MW_IMAGE_MAGIC) {
+		*path = PATH_IMAGE;
+		return load_image_from_blkdev(dev, (uintptr_t)dram, (mw_image_header *)hdr_buf,
+					      sector, (uintptr_t)stage);
+	}
+
+	if (read_header(dev, sector + MW_DIGEST_DEF_SECTOR, MW_DIGEST_SECTORS, digest_buf) != 0)
+		return -1;
+	if (dg->magic == MW_DIGEST_MAGIC) {
+		*path = PATH_VERIFIED;
+		if (check_digest(dg, OS_SIZE_BYTES) != 0 ||
+		    read_elf_verified(dev, dg, (uintptr_t)staging, sector, (uintptr_t)stage) != 0)
+			return -1;
+	} else {
+		mw_blk_sg sg[ELF_MAX_SG_SEGMENTS];
+		uint32_t count;
+		int status;
+
+		status = elf_direct_sg((uintptr_t)dram, (uintptr_t)hdr_buf, sizeof(hdr_buf), sector,
+				       sg, ELF_MAX_SG_SEGMENTS, &count);
+		if (status == 0) {
+			*path = PATH_DIRECT;
+			if (read_sg_list(dev, sg, count) != 0)
+				return -1;
+			elf_direct_finish((uintptr_t)dram, (uintptr_t)hdr_buf);
+			return 0;
+		}
+		if (status != LOADER_NOT_DIRECT)
+			return -1;
+		*path = PATH_BUFFERED;
+		if (read_elf_from_blkdev(dev, (uintptr_t)staging, OS_SIZE_BYTES, sector) != 0)
+			return -1;
+	}
+
+	return load_and_run_elf((uintptr_t)dram, (uintptr_t)staging);
+}
+
+static int boot_manifest(mw_blkdev *dev, int *path)
+{
+	mw_manifest mf = *(mw_manifest *)hdr_buf;
+
+	if (mf.entry_count > MW_MANIFEST_MAX_ENTRIES)
+		return -1;
+	blobs = 0;
+	for (uint32_t i = 0; i < mf.entry_count; i++) {
+		mw_manifest_entry *e = &mf.entry[i];
+		uint32_t crc;
+
+		if (e->type == MW_MANIFEST_KERNEL) {
+			if (read_header(dev, e->sector, BOOT_HDR_SECTORS, hdr_buf) != 0 ||
+			    boot_kernel(dev, e->sector, path) != 0)
+				return -1;
+			continue;
+		}
+		if (!mw_range_ok(e->load_addr, e->size) ||
+		    read_blob_from_blkdev(dev, (uintptr_t)dram + e->load_addr, e->size, e->sector,
+					  (uintptr_t)stage, &crc) != 0)
+			return -1;
+		if (crc != e->crc) {
+			fprintf(stderr, "CRC mismatch in manifest part %u\n", i);
+			return -1;
+		}
+		loader_note_segment((uintptr_t)dram + e->load_addr, e->size, e->size);
+		blobs++;
+	}
+
+	return 0;
+}
+
+static int boot(mw_blkdev *dev, int *path)
+{
+	if (read_header(dev, 0, BOOT_HDR_SECTORS, hdr_buf) != 0)
+		return -1;
+	if (((mw_manifest *)hdr_buf)->magic == MW_MANIFEST_MAGIC)
+		return boot_manifest(dev, path);
+	return boot_kernel(dev, 0, path);
+}
+
+/* Checks the loaded memory against the PT_LOAD segments of an ELF file */
+static int compare_elf(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *elf;
+	long size;
+	Elf64_Ehdr *ehdr;
+	uint64_t checked = 0;
+	uint32_t segs = 0;
+
+	if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0) {
+		perror(path);
+		return -1;
+	}
+	elf = malloc((size_t)size);
+	rewind(f);
+	if (elf == NULL || fread(elf, 1, (size_t)size, f) != (size_t)size) {
+		perror(path);
+		return -1;
+	}
+	fclose(f);
+
+	ehdr = (Elf64_Ehdr *)elf;
+	if ((size_t)size < sizeof(*ehdr) || ehdr->e_ident[0] != ELFMAG0 ||
+	    ehdr->e_phoff + (uint64_t)ehdr->e_phnum * sizeof(Elf64_Phdr) > (uint64_t)size) {
+		fprintf(stderr, "%s: not an ELF file\n", path);
+		return -1;
+	}
+
+	for (int i = 0; i < ehdr->e_phnum; i++) {
+		Elf64_Phdr *ph = (Elf64_Phdr *)(elf + ehdr->e_phoff) + i;
+		uint8_t *mem = dram + ph->p_vaddr;
+
+		if (ph->p_type != PT_LOAD)
+			continue;
+		if (ph->p_offset + ph->p_filesz > (uint64_t)size ||
+		    ph->p_vaddr + ph->p_memsz > HOST_DRAM_SIZE ||
+		    memcmp(mem, elf + ph->p_offset, ph->p_filesz) != 0) {
+			fprintf(stderr, "segment %d at 0x%llx differs from %s\n", i,
+				(unsigned long long)ph->p_vaddr, path);
+			return -1;
+		}
+		for (uint64_t j = ph->p_filesz; j < ph->p_memsz; j++) {
+			if (mem[j] != 0) {
+				fprintf(stderr, "segment %d: .bss byte at 0x%llx is not zero\n", i,
+					(unsigned long long)(ph->p_vaddr + j));
+				return -1;
+			}
+		}
+		checked += ph->p_memsz;
+		segs++;
+	}
+	free(elf);
+
+	printf("compare: %u segments, %llu bytes match %s\n", segs,
+	       (unsigned long long)checked, path);
+	return 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-b MB/s] [-l latency_us] [-m max_sectors] [-n runs] [-x file.elf]\n"
+		"       card.img\n"
+		"  -b  simulated card bandwidth in MB/s, 0 for none (default 25)\n"
+		"  -l  simulated latency per read command in us (default 100)\n"
+		"  -m  largest read in sectors (default 4096, the driver's 2MB)\n"
+		"  -n  number of boots to average over (default 1)\n"
+		"  -x  compare the loaded memory with this ELF file\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t bandwidth = 25000000ULL;
+	uint64_t latency_ns = 100000ULL;
+	uint32_t max_sectors = 4096;
+	uint32_t runs = 1;
+	const char *compare = NULL;
+	host_card card;
+	int path = PATH_BUFFERED;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:l:m:n:x:")) != -1) {
+		switch (opt) {
+		case 'b':
+			bandwidth = (uint64_t)(strtod(optarg, NULL) * 1000000.0);
+			break;
+		case 'l':
+			latency_ns = (uint64_t)(strtod(optarg, NULL) * 1000.0);
+			break;
+		case 'm':
+			max_sectors = (uint32_t)strtoul(optarg, NULL, 0);
+			if (max_sectors == 0)
+				usage(argv[0]);
+			break;
+		case 'n':
+			runs = (uint32_t)strtoul(optarg, NULL, 0);
+			if (runs == 0)
+				usage(argv[0]);
+			break;
+		case 'x':
+			compare = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (argc - optind != 1)
+		usage(argv[0]);
+
+	if (host_card_open(&card, argv[optind], max_sectors, bandwidth, latency_ns) != 0)
+		return 1;
+
+	/* Reserve the address space only; pages appear as segments land */
+	dram = mmap(NULL, HOST_DRAM_SIZE, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	staging = malloc(OS_SIZE_BYTES + LOADER_SECTOR_SIZE);
+	stage = malloc(2 * LOADER_STAGE_SIZE);
+	if (dram == MAP_FAILED || !staging || !stage) {
+		perror("alloc");
+		return 1;
+	}
+
+	for (uint32_t r = 0; r < runs; r++) {
+		if (boot(&card.dev, &path) != 0) {
+			fprintf(stderr, "%s: boot failed\n", argv[optind]);
+			return 1;
+		}
+	}
+
+	if (compare != NULL && compare_elf(compare) != 0)
+		return 1;
+
+	printf("\npath: %s", path_name[path]);
+	if (blobs != 0)
+		printf(" + %u manifest parts", blobs);
+	printf("\n");
+	printf("%-10s %12s %10s %9s\n", "phase", "time (us)", "bytes", "MB/s");
+	for (uint32_t i = 0; i < MW_BOOT_PHASE_COUNT; i++) {
+		mw_boot_phase *p = &stats.phase[i];
+		double mbps = p->ticks ? (double)p->bytes * 1000.0 / (double)p->ticks : 0.0;
+
+		if (p->ticks == 0 && p->bytes == 0)
+			continue;
+		printf("%-10s %12llu %10llu %9.2f\n", phase_name[i],
+		       (unsigned long long)(p->ticks / 1000 / runs),
+		       (unsigned long long)(p->bytes / runs), mbps);
+	}
+	printf("card: %llu reads, %llu bytes, %llu us stalled over %u runs\n",
+	       (unsigned long long)card.reads, (unsigned long long)card.bytes,
+	       (unsigned long long)(card.stall_ns / 1000), runs);
+
+	host_card_close(&card);
+	free(staging);
+	free(stage);
+	munmap(dram, HOST_DRAM_SIZE);
+	return 0;
+}
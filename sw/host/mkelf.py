@@ -0,0 +1,81 @@
+#!/usr/bin/python3
+#
+# Synthetic ppc64le ELF for the loader checks (make check)
+#
+#   mkelf.py [--odd] out.elf
+#
+# Writes an ELF64 with four PT_LOAD segments shaped like a kernel: text
+# that compresses, data that does not, both with a .bss tail that takes
+# the last sector's padding, another segment and a .bss-only one. Sizes
+# are not multiples of the sector or chunk size. By default every segment
+# starts on a sector boundary in the file and a word boundary in memory,
+# so the loaders read raw chunks in place and the bootloader reads the
+# plain ELF straight into its segments; with --odd they do not, which
+# forces the staged and buffered paths.
+
+import sys
+import random
+import struct
+
+EHDR = struct.Struct('<16sHHIQQQIHHHHHH')
+PHDR = struct.Struct('<IIQQQQQQ')
+EM_PPC64 = 21
+PT_LOAD = 1
+
+# (vaddr, file bytes, .bss bytes, content)
+SEGMENTS = [
+    (0x00000000, 0x1234AB, 0x1155, 'text'),
+    (0x00200000, 0x0C0101, 0x2345, 'random'),
+    (0x00400000, 0x011111, 0x7001, 'text'),
+    (0x00600000, 0x000000, 0x8000, None),
+]
+
+
+def content(kind, size, rng):
+    if kind == 'random':
+        return bytes(rng.getrandbits(8) for _ in range(size))
+    # Instruction-like words with a few random fields: compresses about 2:1
+    out = bytearray()
+    while len(out) < size:
+        out += struct.pack('<I', 0x38600000 | rng.getrandbits(12))
+        out += b'\x60\x00\x00\x00' * rng.randint(0, 3)
+    return bytes(out[:size])
+
+
+def main():
+    args = sys.argv[1:]
+    odd = '--odd' in args
+    args = [a for a in args if a != '--odd']
+    if len(args) != 1:
+        sys.exit('usage: mkelf.py [--odd] out.elf')
+
+    rng = random.Random(0x4D57)
+    phoff = EHDR.size
+    offset = 0x1000
+    phdrs = []
+    data = []
+    for vaddr, filesz, bss, kind in SEGMENTS:
+        if odd:
+            vaddr += 2
+            offset += 0x33
+        phdrs.append(PHDR.pack(PT_LOAD, 7, offset if filesz else 0, vaddr, vaddr,
+                               filesz, filesz + bss, 0x10000))
+        if filesz:
+            data.append((offset, content(kind, filesz, rng)))
+            offset = (offset + filesz + 0xFFF) & ~0xFFF
+
+    ident = b'\x7fELF' + bytes([2, 1, 1]) + bytes(9)
+    ehdr = EHDR.pack(ident, 2, EM_PPC64, 1, SEGMENTS[0][0] + (2 if odd else 0),
+                     phoff, 0, 2, EHDR.size, PHDR.size, len(phdrs), 0, 0, 0)
+
+    image = bytearray(offset)
+    image[0:len(ehdr)] = ehdr
+    image[phoff:phoff + PHDR.size * len(phdrs)] = b''.join(phdrs)
+    for off, seg in data:
+        image[off:off + len(seg)] = seg
+    with open(args[0], 'wb') as f:
+        f.write(image)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,426 @@
+/*
+ * sdhci_bench - run sd_card_driver against the SDHCI model and count what
+ * each read path costs on the bus.
+ *
+ *   sdhci_bench [-c cmd_us] [-a access_us] [-p stop_us] [-r reg_ns] [-b MB/s] [-s sectors]
+ *               [-t MB] [-w work_us] [-e] [-f] [-u] [-x] card.img
+ *
+ * The driver sources are the bootloader's own, built against the stub BSP
+ * in bsp/. Each test reads the first -t MB of the card in the given way and
+ * checks every byte against card.img; times are model time, so they show
+ * what the board would see for the configured card rather than how fast
+ * the PC runs the driver.
+ *
+ * With -w the bench also reads chunk by chunk with an item_done step per
+ * chunk, first serially, then with the next read started before it, and
+ * reports how much of the work the transfer in flight hid.
+ *
+ * With -u the card is a UHS-I one and the slot is configured as 1.8 V
+ * capable, so initialization switches voltage with CMD11 and tunes for
+ * SDR104. -x makes tuning fail in SDR104 and SDR50; with -f the bench
+ * then shows XSdPs_SelectBusSpeed walking down to DDR50.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "xsdps.h"
+#include "sleep.h"
+#include "sdhci_model.h"
+
+#define DESC_LINES		112U	/* SD_DESC_LINES in bootloader.c */
+#define FRAG_SIZE		4096U	/* ReadSG fragment, one page */
+#define CHECK_SECTORS		8U	/* Blocks SelectBusSpeed reads back */
+
+static XSdPs sd;
+static XSdPs_Adma2Descriptor64 desc_tbl[DESC_LINES] __attribute__ ((aligned(32)));
+static sdhci_model model;
+static int image_fd;
+
+typedef struct {
+	uint64_t t0;
+	sdhci_stats s0;
+} bench_mark;
+
+static void mark(bench_mark *b)
+{
+	b->t0 = sdhci_model_now();
+	b->s0 = model.stats;
+}
+
+static void report(const char *name, const bench_mark *b, uint64_t bytes)
+{
+	uint64_t ns = sdhci_model_now() - b->t0;
+	uint64_t cmds = model.stats.cmds - b->s0.cmds;
+	uint64_t over_ns = (model.stats.cmd_ns - b->s0.cmd_ns) +
+			   (model.stats.access_ns - b->s0.access_ns);
+	double mb = (double)bytes / 1048576.0;
+
+	printf("%-16s %8.2f %10llu %8.2f %8llu %9.1f %10.1f\n", name, mb,
+	       (unsigned long long)(ns / 1000),
+	       ns ? (double)bytes * 1000.0 / (double)ns : 0.0,
+	       (unsigned long long)cmds, mb > 0 ? (double)cmds / mb : 0.0,
+	       mb > 0 ? (double)over_ns / 1000.0 / mb : 0.0);
+}
+
+/* Compares a buffer with the image; the card reads as zeros past its end */
+static void verify(const char *name, uint32_t sector, const uint8_t *buf, uint32_t len)
+{
+	static uint8_t ref[FRAG_SIZE];
+
+	for (uint32_t off = 0; off < len; off += sizeof(ref)) {
+		uint32_t n = len - off < sizeof(ref) ? len - off : (uint32_t)sizeof(ref);
+		ssize_t got = pread(image_fd, ref, n, (off_t)sector * SDHCI_SECTOR_SIZE + off);
+
+		if (got < 0)
+			got = 0;
+		memset(ref + got, 0, n - (uint32_t)got);
+		if (memcmp(ref, buf + off, n) != 0) {
+			fprintf(stderr, "%s: data mismatch at sector %u\n", name,
+				sector + off / SDHCI_SECTOR_SIZE);
+			exit(1);
+		}
+	}
+}
+
+static void fail(const char *what)
+{
+	fprintf(stderr, "%s failed (model time %llu us)\n", what,
+		(unsigned long long)(sdhci_model_now() / 1000));
+	exit(1);
+}
+
+// --- Tests ---
+
+/* One CMD17 per sector */
+static void bench_single(uint8_t *buf, uint32_t sectors)
+{
+	bench_mark b;
+
+	mark(&b);
+	for (uint32_t s = 0; s < sectors; s++) {
+		if (XSdPs_ReadPolled(&sd, s, 1, buf) != XST_SUCCESS)
+			fail("CMD17 read");
+		verify("single", s, buf, SDHCI_SECTOR_SIZE);
+	}
+	report("single-block", &b, (uint64_t)sectors * SDHCI_SECTOR_SIZE);
+}
+
+/* CMD18 of chunk sectors, as the loader reads */
+static void bench_multi(uint8_t *buf, uint32_t sectors, uint32_t chunk)
+{
+	bench_mark b;
+
+	mark(&b);
+	for (uint32_t s = 0; s < sectors; s += chunk) {
+		uint32_t n = sectors - s < chunk ? sectors - s : chunk;
+
+		if (XSdPs_ReadPolled(&sd, s, n, buf) != XST_SUCCESS)
+			fail("CMD18 read");
+		verify("multi", s, buf, n * SDHCI_SECTOR_SIZE);
+	}
+	report("multi-block", &b, (uint64_t)sectors * SDHCI_SECTOR_SIZE);
+}
+
+/*
+ * Page fragments of each chunk, scattered backwards through the buffer so
+ * that every fragment needs its own descriptor. With interleave the even
+ * pages are listed before the odd ones, so no two entries follow each
+ * other on the card and every page becomes a command of its own.
+ */
+static void bench_sg(const char *name, uint8_t *buf, uint32_t sectors, uint32_t chunk,
+		     int interleave)
+{
+	uint32_t per_frag = FRAG_SIZE / SDHCI_SECTOR_SIZE;
+	uint32_t max_frags = chunk / per_frag;
+	XSdPs_SgEntry *sg = calloc(max_frags, sizeof(*sg));
+	bench_mark b;
+
+	mark(&b);
+	for (uint32_t s = 0; s < sectors; s += chunk) {
+		uint32_t n = sectors - s < chunk ? sectors - s : chunk;
+		uint32_t frags = n / per_frag;
+		uint32_t i = 0;
+
+		for (int pass = 0; pass < (interleave ? 2 : 1); pass++) {
+			for (uint32_t f = (uint32_t)pass; f < frags; f += interleave ? 2U : 1U) {
+				sg[i].Sector = s + f * per_frag;
+				sg[i].Buff = (UINTPTR)(buf + (size_t)(frags - 1 - f) * FRAG_SIZE);
+				sg[i].Length = FRAG_SIZE;
+				i++;
+			}
+		}
+		if (XSdPs_ReadSG(&sd, sg, frags) != XST_SUCCESS)
+			fail("ReadSG");
+		for (uint32_t f = 0; f < frags; f++)
+			verify(name, s + f * per_frag, buf + (size_t)(frags - 1 - f) * FRAG_SIZE,
+			       FRAG_SIZE);
+	}
+	report(name, &b, (uint64_t)sectors * SDHCI_SECTOR_SIZE);
+	free(sg);
+}
+
+static uint64_t host_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void chunk_start(uint8_t *buf, uint32_t sector, uint32_t count)
+{
+	XSdPs_SgEntry sg = {
+		.Sector = sector,
+		.Buff = (UINTPTR)buf,
+		.Length = count * SDHCI_SECTOR_SIZE,
+	};
+
+	if (XSdPs_StartReadSG(&sd, &sg, 1) != XST_SUCCESS)
+		fail("StartReadSG");
+}
+
+/* Returns the model time spent waiting */
+static uint64_t chunk_wait(void)
+{
+	uint64_t t0 = sdhci_model_now();
+	s32 Status;
+
+	while ((Status = XSdPs_CheckReadTransfer(&sd)) == XST_DEVICE_BUSY)
+		usleep(1);
+	if (Status != XST_SUCCESS)
+		fail("CheckReadTransfer");
+	return sdhci_model_now() - t0;
+}
+
+/*
+ * The loader's item_done for a chunk: check it, then spend work_us on it.
+ * The check runs on the PC and its time is charged to the model as it
+ * was spent, so a read in flight moves on under it as under the work.
+ */
+static void chunk_done(const char *name, uint32_t sector, const uint8_t *buf,
+		       uint32_t count, uint32_t work_us)
+{
+	uint64_t t0 = host_ns();
+
+	verify(name, sector, buf, count * SDHCI_SECTOR_SIZE);
+	sdhci_model_delay(host_ns() - t0 + (uint64_t)work_us * 1000ULL);
+}
+
+/*
+ * Reads chunk after chunk with item_done on each. The serial run waits
+ * for a chunk before its item_done; the async run starts the next chunk
+ * first, as blk_pipe_run does, so the card fills one buffer while the
+ * CPU works on the other.
+ */
+static void bench_overlap(uint8_t *buf[2], uint32_t sectors, uint32_t chunk, uint32_t work_us)
+{
+	uint64_t stall[2] = { 0, 0 };
+	uint64_t took[2];
+	bench_mark b;
+	int cur = 0;
+
+	mark(&b);
+	for (uint32_t s = 0; s < sectors; s += chunk) {
+		uint32_t n = sectors - s < chunk ? sectors - s : chunk;
+
+		chunk_start(buf[0], s, n);
+		stall[0] += chunk_wait();
+		chunk_done("serial", s, buf[0], n, work_us);
+	}
+	took[0] = sdhci_model_now() - b.t0;
+	report("read+work", &b, (uint64_t)sectors * SDHCI_SECTOR_SIZE);
+
+	mark(&b);
+	chunk_start(buf[cur], 0, sectors < chunk ? sectors : chunk);
+	for (uint32_t s = 0; s < sectors; s += chunk) {
+		uint32_t n = sectors - s < chunk ? sectors - s : chunk;
+		uint32_t next = s + n;
+
+		stall[1] += chunk_wait();
+		if (next < sectors)
+			chunk_start(buf[cur ^ 1], next,
+				    sectors - next < chunk ? sectors - next : chunk);
+		chunk_done("async", s, buf[cur], n, work_us);
+		cur ^= 1;
+	}
+	took[1] = sdhci_model_now() - b.t0;
+	report("async+work", &b, (uint64_t)sectors * SDHCI_SECTOR_SIZE);
+
+	printf("overlap: waited %llu us serial, %llu us async; %llu us of item_done hidden\n",
+	       (unsigned long long)(stall[0] / 1000), (unsigned long long)(stall[1] / 1000),
+	       (unsigned long long)(took[0] > took[1] ? (took[0] - took[1]) / 1000 : 0));
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-c cmd_us] [-a access_us] [-p stop_us] [-r reg_ns] [-b MB/s] [-s sectors]\n"
+		"          [-t MB] [-w work_us] [-e] [-f] [-u] [-x] card.img\n"
+		"  -c  card latency per command in us (default 2)\n"
+		"  -a  card access time before read data in us (default 100)\n"
+		"  -p  card busy time after CMD12 in us (default 20)\n"
+		"  -r  time per register access in ns (default 0)\n"
+		"  -b  card read limit in MB/s, 0 for the bus rate (default 0)\n"
+		"  -s  sectors per multi-block read (default 4096, the loader's 2MB)\n"
+		"  -t  MB read by each test (default 16)\n"
+		"  -w  CPU work per chunk in us for the overlap test (default 0: skip)\n"
+		"  -e  card without CMD23 support\n"
+		"  -f  pick the bus speed with XSdPs_SelectBusSpeed after init\n"
+		"  -u  UHS-I card (1.8 V, SDR50, SDR104, DDR50) in a 1.8 V capable slot\n"
+		"  -x  tuning never locks in SDR104 and SDR50\n",
+		prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	/* By XSdPs Mode, as bootloader.c reports it */
+	static const char *const mode_name[] = {
+		"SDR12", "SDR25", "SDR50", "SDR104", "DDR50", "HS", "default", "HS200"
+	};
+	uint64_t cmd_ns = 2000ULL;
+	uint64_t access_ns = 100000ULL;
+	uint64_t stop_ns = 20000ULL;
+	uint64_t reg_ns = 0;
+	uint64_t card_bw = 0;
+	uint32_t chunk = 4096;
+	uint32_t total_mb = 16;
+	uint32_t work_us = 0;
+	int cmd23 = 1;
+	int select_speed = 0;
+	int uhs = 0;
+	int tune_fail = 0;
+	XSdPs_Config *cfg;
+	uint8_t *buf[2];
+	bench_mark b;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:a:p:r:b:s:t:w:efux")) != -1) {
+		switch (opt) {
+		case 'c':
+			cmd_ns = (uint64_t)(strtod(optarg, NULL) * 1000.0);
+			break;
+		case 'a':
+			access_ns = (uint64_t)(strtod(optarg, NULL) * 1000.0);
+			break;
+		case 'p':
+			stop_ns = (uint64_t)(strtod(optarg, NULL) * 1000.0);
+			break;
+		case 'r':
+			reg_ns = strtoull(optarg, NULL, 0);
+			break;
+		case 'b':
+			card_bw = (uint64_t)(strtod(optarg, NULL) * 1000000.0);
+			break;
+		case 's':
+			chunk = (uint32_t)strtoul(optarg, NULL, 0);
+			if (chunk == 0 || chunk % (FRAG_SIZE / SDHCI_SECTOR_SIZE) != 0 ||
+			    chunk > DESC_LINES * (XSDPS_DESC_MAX_LENGTH / SDHCI_SECTOR_SIZE))
+				usage(argv[0]);
+			break;
+		case 't':
+			total_mb = (uint32_t)strtoul(optarg, NULL, 0);
+			if (total_mb == 0)
+				usage(argv[0]);
+			break;
+		case 'w':
+			work_us = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			cmd23 = 0;
+			break;
+		case 'f':
+			select_speed = 1;
+			break;
+		case 'u':
+			uhs = 1;
+			break;
+		case 'x':
+			tune_fail = 1;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (argc - optind != 1)
+		usage(argv[0]);
+
+	cfg = XSdPs_LookupConfig(XPAR_XSDPS_0_DEVICE_ID);
+	if (cfg == NULL || sdhci_model_open(&model, argv[optind], cfg->BaseAddress) != 0)
+		return 1;
+	image_fd = model.fd;
+	model.cmd_ns = cmd_ns;
+	model.access_ns = access_ns;
+	model.stop_ns = stop_ns;
+	model.reg_ns = reg_ns;
+	model.card_bw = card_bw;
+	model.cmd23 = (uint8_t)cmd23;
+	if (uhs) {
+		/* The driver only asks for 1.8 V in a slot configured 8 bits wide */
+		cfg->BusWidth = XSDPS_WIDTH_8;
+		model.s18 = 1;
+		model.speed_support = UHS_SDR12_SUPPORT | UHS_SDR25_SUPPORT |
+				      UHS_SDR50_SUPPORT | UHS_SDR104_SUPPORT |
+				      UHS_DDR50_SUPPORT;
+	}
+	if (tune_fail)
+		model.tune_fail = UHS_SDR50_SUPPORT | UHS_SDR104_SUPPORT;
+	/* The driver only sets the upper SAR word on aarch64 */
+	model.dma_hi = (uint32_t)((uint64_t)(uintptr_t)desc_tbl >> 32);
+
+	buf[0] = aligned_alloc(64, (size_t)chunk * SDHCI_SECTOR_SIZE);
+	buf[1] = aligned_alloc(64, (size_t)chunk * SDHCI_SECTOR_SIZE);
+	if (!buf[0] || !buf[1]) {
+		perror("alloc");
+		return 1;
+	}
+
+	mark(&b);
+	if (XSdPs_CfgInitialize(&sd, cfg, cfg->BaseAddress) != XST_SUCCESS)
+		fail("XSdPs_CfgInitialize");
+	if (XSdPs_CardInitialize(&sd) != XST_SUCCESS)
+		fail("XSdPs_CardInitialize");
+	if (XSdPs_SetAdma2DescrTbl(&sd, desc_tbl, DESC_LINES) != XST_SUCCESS)
+		fail("XSdPs_SetAdma2DescrTbl");
+	if (select_speed &&
+	    XSdPs_SelectBusSpeed(&sd, 0, CHECK_SECTORS, buf[0], buf[1]) != XST_SUCCESS)
+		fail("XSdPs_SelectBusSpeed");
+	printf("init: %llu us, %llu commands (%llu CMD19), bus %u Hz, %u-bit, %s, %s\n",
+	       (unsigned long long)((sdhci_model_now() - b.t0) / 1000),
+	       (unsigned long long)model.stats.cmds, (unsigned long long)model.stats.cmd[19],
+	       (unsigned)sd.BusSpeed, (unsigned)sd.BusWidth == XSDPS_4_BIT_WIDTH ? 4U : 1U,
+	       model.card_1v8 ? "1.8 V" : "3.3 V",
+	       sd.Mode < sizeof(mode_name) / sizeof(mode_name[0]) ? mode_name[sd.Mode] : "?");
+
+	uint32_t sectors = total_mb * (1048576U / SDHCI_SECTOR_SIZE);
+	uint32_t sg_chunk;
+
+	printf("\n%-16s %8s %10s %8s %8s %9s %10s\n", "test", "MB", "time (us)",
+	       "MB/s", "cmds", "cmds/MB", "ovh us/MB");
+	bench_single(buf[0], sectors / 64 < 2048 ? sectors / 64 : 2048);
+	bench_multi(buf[0], sectors, chunk);
+	/* One descriptor per page: the table limits how much a list can cover */
+	sg_chunk = chunk < DESC_LINES * (FRAG_SIZE / SDHCI_SECTOR_SIZE) ?
+		   chunk : DESC_LINES * (FRAG_SIZE / SDHCI_SECTOR_SIZE);
+	bench_sg("sg contiguous", buf[0], sectors, sg_chunk, 0);
+	bench_sg("sg interleaved", buf[0], sectors, sg_chunk, 1);
+	if (work_us != 0)
+		bench_overlap(buf, sectors, chunk, work_us);
+
+	printf("\ncard: %llu commands (%llu CMD18, %llu CMD17, %llu auto CMD12, "
+	       "%llu auto CMD23), %llu descriptors, %llu errors\n",
+	       (unsigned long long)model.stats.cmds, (unsigned long long)model.stats.cmd[18],
+	       (unsigned long long)model.stats.cmd[17],
+	       (unsigned long long)model.stats.auto_cmd12,
+	       (unsigned long long)model.stats.auto_cmd23,
+	       (unsigned long long)model.stats.descs, (unsigned long long)model.stats.errors);
+
+	sdhci_model_close(&model);
+	free(buf[0]);
+	free(buf[1]);
+	return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Host implementations of the BSP calls sd_card_driver makes
+ *
+ * Register accesses go to the SDHCI model; anything else is a driver bug
+ * on the host and stops the run. Delays and polls spend model time, so
+ * a timeout is as long as it would be on the board.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "xil_io.h"
+#include "xil_util.h"
+#include "xstatus.h"
+#include "sleep.h"
+#include "sdhci_model.h"
+
+static u64 reg_read(UINTPTR Addr, unsigned int Size)
+{
+	uint64_t Val;
+
+	if (!sdhci_model_read(Addr, Size, &Val)) {
+		fprintf(stderr, "read%u from unmodelled address 0x%llx\n",
+			Size * 8, (unsigned long long)Addr);
+		abort();
+	}
+	return Val;
+}
+
+static void reg_write(UINTPTR Addr, unsigned int Size, u64 Value)
+{
+	if (!sdhci_model_write(Addr, Size, Value)) {
+		fprintf(stderr, "write%u of 0x%llx to unmodelled address 0x%llx\n",
+			Size * 8, (unsigned long long)Value, (unsigned long long)Addr);
+		abort();
+	}
+}
+
+u8 Xil_In8(UINTPTR Addr) { return (u8)reg_read(Addr, 1); }
+u16 Xil_In16(UINTPTR Addr) { return (u16)reg_read(Addr, 2); }
+u32 Xil_In32(UINTPTR Addr) { return (u32)reg_read(Addr, 4); }
+u64 Xil_In64(UINTPTR Addr) { return reg_read(Addr, 8); }
+void Xil_Out8(UINTPTR Addr, u8 Value) { reg_write(Addr, 1, Value); }
+void Xil_Out16(UINTPTR Addr, u16 Value) { reg_write(Addr, 2, Value); }
+void Xil_Out32(UINTPTR Addr, u32 Value) { reg_write(Addr, 4, Value); }
+void Xil_Out64(UINTPTR Addr, u64 Value) { reg_write(Addr, 8, Value); }
+
+int host_usleep(unsigned long useconds)
+{
+	sdhci_model_delay((uint64_t)useconds * 1000ULL);
+	return 0;
+}
+
+/* Skips ahead to the next model event, at most the time left and at least 1us */
+static void poll_wait(uint64_t deadline)
+{
+	uint64_t now = sdhci_model_now();
+	uint64_t step = sdhci_model_next_event();
+
+	if (step < 1000ULL)
+		step = 1000ULL;
+	if (now + step > deadline)
+		step = deadline > now ? deadline - now : 0;
+	sdhci_model_delay(step);
+}
+
+u32 Xil_WaitForEvent(UINTPTR RegAddr, u32 EventMask, u32 Event, u32 Timeout)
+{
+	uint64_t deadline = sdhci_model_now() + (uint64_t)Timeout * 1000ULL;
+
+	for (;;) {
+		if ((Xil_In32(RegAddr) & EventMask) == Event)
+			return XST_SUCCESS;
+		if (sdhci_model_now() >= deadline)
+			return XST_FAILURE;
+		poll_wait(deadline);
+	}
+}
+
+u32 Xil_WaitForEvents(UINTPTR EventsRegAddr, u32 EventsMask, u32 WaitEvents,
+		      u32 Timeout, u32 *Events)
+{
+	uint64_t deadline = sdhci_model_now() + (uint64_t)Timeout * 1000ULL;
+
+	for (;;) {
+		*Events = Xil_In32(EventsRegAddr) & EventsMask;
+		if ((*Events & WaitEvents) != 0U)
+			return XST_SUCCESS;
+		if (sdhci_model_now() >= deadline)
+			return XST_FAILURE;
+		poll_wait(deadline);
+	}
+}
@@ -0,0 +1,902 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "xsdps_hw.h"
+#include "sdhci_model.h"
+
+#define SDHCI_WINDOW		0x300U		/* Registers and PHY control */
+#define SLCR_BASE		0xFF180000U	/* Tap delays and DLL reset land here */
+#define SLCR_SIZE		0x1000U
+
+/* Transfer Mode bits 3:2 select the automatic command (SDHCI 3.0) */
+#define TM_AUTO_CMD_MASK	0x000CU
+#define TM_AUTO_CMD12		0x0004U
+#define TM_AUTO_CMD23		0x0008U
+
+/* Card states in the R1 status */
+#define CARD_IDLE		0U
+#define CARD_READY		1U
+#define CARD_IDENT		2U
+#define CARD_STBY		3U
+#define CARD_TRAN		4U
+#define CARD_DATA		5U
+
+#define R1_READY_FOR_DATA	(1U << 8)
+#define R1_APP_CMD		(1U << 5)
+#define OCR_BUSY		0x80000000U	/* Set when power-up is done */
+#define OCR_CCS			0x40000000U
+#define OCR_VDD_27_36		0x00FF8000U
+#define OCR_S18			0x01000000U	/* S18R from the host, S18A from the card */
+
+#define CARD_RCA		0xE624U
+#define CLK_OFF_TIMEOUT_NS	1000000ULL	/* Command timeout with no SD clock */
+#define VOLT_SWITCH_NS		5000000ULL	/* SD clock off for the 1.8 V switch */
+
+/* CMD6 group 1 functions */
+#define FN_SDR50		2
+#define FN_SDR104		3
+
+#define SDR25_MAX_HZ		50000000ULL	/* Fastest clock that needs no tuning */
+#define TUNE_LOCK_BLOCKS	8U		/* Tuning blocks until the sampling point locks */
+#define TUNE_MAX_BLOCKS		40U		/* The controller gives up after these */
+
+static sdhci_model *model;
+static uintptr_t model_base;
+
+// --- Register file helpers ---
+
+static uint32_t reg_get(sdhci_model *m, unsigned int off, unsigned int size)
+{
+	uint32_t v = 0;
+
+	for (unsigned int i = 0; i < size; i++)
+		v |= (uint32_t)m->reg[off + i] << (8 * i);
+	return v;
+}
+
+static void reg_put(sdhci_model *m, unsigned int off, unsigned int size, uint32_t v)
+{
+	for (unsigned int i = 0; i < size; i++)
+		m->reg[off + i] = (uint8_t)(v >> (8 * i));
+}
+
+static void raise_irq(sdhci_model *m, uint16_t norm, uint16_t err)
+{
+	norm &= reg_get(m, XSDPS_NORM_INTR_STS_EN_OFFSET, 2);
+	err &= reg_get(m, XSDPS_ERR_INTR_STS_EN_OFFSET, 2);
+	reg_put(m, XSDPS_NORM_INTR_STS_OFFSET, 2,
+		reg_get(m, XSDPS_NORM_INTR_STS_OFFSET, 2) | norm);
+	reg_put(m, XSDPS_ERR_INTR_STS_OFFSET, 2,
+		reg_get(m, XSDPS_ERR_INTR_STS_OFFSET, 2) | err);
+	if (err != 0)
+		m->stats.errors++;
+}
+
+static void reset_regs(sdhci_model *m)
+{
+	memset(m->reg, 0, sizeof(m->reg));
+	reg_put(m, XSDPS_CAPS_OFFSET, 4,
+		(200U << 8) | XSDPS_CAP_ADMA2_MASK | XSDPS_CAP_HIGH_SPEED_MASK |
+		XSDPS_CAP_SDMA_MASK | XSDPS_CAP_VOLT_3V3_MASK |
+		XSDPS_CAP_VOLT_1V8_MASK | XSDPS_CAP_SYS_BUS_64_MASK);
+	reg_put(m, XSDPS_CAPS_EXT_OFFSET, 4,
+		XSDPS_ECAPS_SDR50_MASK | XSDPS_ECAPS_SDR104_MASK | XSDPS_ECAPS_DDR50_MASK);
+	reg_put(m, XSDPS_HOST_CTRL_VER_OFFSET, 2, 0x1000U | XSDPS_HC_SPEC_V3);
+	m->cmd.active = 0;
+	m->dat.active = 0;
+}
+
+static void card_reset(sdhci_model *m)
+{
+	m->card_state = CARD_IDLE;
+	m->rca = 0;
+	m->app_cmd = 0;
+	m->acmd41_count = 0;
+	m->card_width = 1;
+	m->card_hs = 0;
+	m->preset_count = 0;
+}
+
+// --- Bus timing ---
+
+static uint64_t sd_clock(sdhci_model *m)
+{
+	uint32_t cc = reg_get(m, XSDPS_CLK_CTRL_OFFSET, 2);
+	uint32_t div;
+
+	if ((cc & XSDPS_CC_INT_CLK_EN_MASK) == 0 || (cc & XSDPS_CC_SD_CLK_EN_MASK) == 0)
+		return 0;
+	div = ((cc >> XSDPS_CC_DIV_SHIFT) & XSDPS_CC_SDCLK_FREQ_SEL_MASK) |
+	      (((cc >> XSDPS_CC_EXT_DIV_SHIFT) & XSDPS_CC_SDCLK_FREQ_SEL_EXT_MASK) << 8);
+	return div ? m->base_clock_hz / (2 * div) : m->base_clock_hz;
+}
+
+static int host_width(sdhci_model *m)
+{
+	uint32_t hc1 = reg_get(m, XSDPS_HOST_CTRL1_OFFSET, 1);
+
+	if (hc1 & XSDPS_HC_EXT_BUS_WIDTH)
+		return 8;
+	return (hc1 & XSDPS_HC_WIDTH_MASK) ? 4 : 1;
+}
+
+static int host_1v8(sdhci_model *m)
+{
+	return (reg_get(m, XSDPS_HOST_CTRL2_OFFSET, 2) & XSDPS_HC2_1V8_EN_MASK) != 0;
+}
+
+static int host_ddr(sdhci_model *m)
+{
+	return (reg_get(m, XSDPS_HOST_CTRL2_OFFSET, 2) & XSDPS_HC2_UHS_MODE_MASK) ==
+	       XSDPS_HC2_UHS_MODE_DDR50_MASK;
+}
+
+/* Fastest SD clock the card takes in its current CMD6 access mode */
+static uint64_t card_max_clock(sdhci_model *m)
+{
+	static const uint64_t max_hz[] = {
+		25000000ULL, 50000000ULL, 100000000ULL, 208000000ULL, 50000000ULL
+	};
+
+	return m->card_hs < 5 ? max_hz[m->card_hs] : max_hz[0];
+}
+
+/* Command and response bits on the CMD line, plus the card's turnaround */
+static uint64_t cmd_time(sdhci_model *m, uint64_t clk, uint32_t resp_sel)
+{
+	uint64_t bits = 48 + 8;
+
+	if (resp_sel == XSDPS_CMD_RESP_L136_MASK)
+		bits += 136;
+	else if (resp_sel != XSDPS_CMD_RESP_NONE_MASK)
+		bits += 48;
+	return m->cmd_ns + bits * 1000000000ULL / clk;
+}
+
+static uint64_t data_time(sdhci_model *m, uint64_t clk, uint32_t bytes, uint32_t blocks)
+{
+	int width = host_width(m);
+	/* Per block: start bit, CRC16 and end bit on every line */
+	uint64_t cycles = (uint64_t)bytes * 8 / (uint64_t)width + (uint64_t)blocks * 18;
+	uint64_t ns;
+
+	if (host_ddr(m))
+		cycles /= 2;
+	ns = cycles * 1000000000ULL / clk;
+	if (m->card_bw != 0 && (uint64_t)bytes * 1000000000ULL / m->card_bw > ns)
+		ns = (uint64_t)bytes * 1000000000ULL / m->card_bw;
+	return ns;
+}
+
+// --- Card ---
+
+static uint32_t card_status(sdhci_model *m)
+{
+	return (m->card_state << 9) | R1_READY_FOR_DATA | (m->app_cmd ? R1_APP_CMD : 0);
+}
+
+/* Packs a 128-bit register, sent MSB first, into RESP0-3 without its CRC byte */
+static void pack_r2(uint32_t resp[4], const uint8_t reg128[16])
+{
+	uint8_t b[16] = { 0 };
+
+	for (int k = 0; k < 15; k++)
+		b[14 - k] = reg128[k];
+	for (int i = 0; i < 4; i++)
+		resp[i] = (uint32_t)b[4 * i] | ((uint32_t)b[4 * i + 1] << 8) |
+			  ((uint32_t)b[4 * i + 2] << 16) | ((uint32_t)b[4 * i + 3] << 24);
+}
+
+static void card_csd(sdhci_model *m, uint32_t resp[4])
+{
+	uint32_t c_size = (m->capacity + 1023) / 1024 - 1;
+	uint8_t csd[16] = {
+		0x40, 0x0E, 0x00, 0x32, 0x5B, 0x59, 0x00,
+		(uint8_t)((c_size >> 16) & 0x3F), (uint8_t)(c_size >> 8), (uint8_t)c_size,
+		0x7F, 0x80, 0x0A, 0x40, 0x00, 0x01
+	};
+
+	pack_r2(resp, csd);
+}
+
+static void card_cid(uint32_t resp[4])
+{
+	static const uint8_t cid[16] = {
+		0x4D, 'M', 'W', 'S', 'D', 'M', 'D', 'L',
+		0x10, 0x12, 0x34, 0x56, 0x78, 0x01, 0xAA, 0x01
+	};
+
+	pack_r2(resp, cid);
+}
+
+/* The tuning block a card sends for CMD19 on a 4-bit bus */
+static const uint8_t tuning_block[64] = {
+	0xFF, 0x0F, 0xFF, 0x00, 0xFF, 0xCC, 0xC3, 0xCC,
+	0xC3, 0x3C, 0xCC, 0xFF, 0xFE, 0xFF, 0xFE, 0xEF,
+	0xFF, 0xDF, 0xFF, 0xDD, 0xFF, 0xFB, 0xFF, 0xFB,
+	0xBF, 0xFF, 0x7F, 0xFF, 0x77, 0xF7, 0xBD, 0xEF,
+	0xFF, 0xF0, 0xFF, 0xF0, 0x0F, 0xFC, 0xCC, 0x3C,
+	0xCC, 0x33, 0xCC, 0xCF, 0xFF, 0xEF, 0xFF, 0xEE,
+	0xFF, 0xFD, 0xFF, 0xFD, 0xDF, 0xFF, 0xBF, 0xFF,
+	0xBB, 0xFF, 0xF7, 0xFF, 0xF7, 0x7F, 0x7B, 0xDE,
+};
+
+static void card_switch(sdhci_model *m, uint32_t arg)
+{
+	uint32_t fn = arg & 0xFU;
+	uint8_t *s = m->dat.buf;
+
+	memset(s, 0, 64);
+	s[1] = 200;				/* Max current, mA */
+	for (int g = 2; g < 12; g += 2) {
+		s[g] = 0x80;			/* Groups 6-2: default and no-influence */
+		s[g + 1] = 0x01;
+	}
+	s[12] = 0x80;
+	s[13] = m->speed_support;		/* Group 1: access mode */
+	if (fn == 0xFU) {
+		fn = (uint32_t)m->card_hs;
+	} else if (fn > 7U || (m->speed_support & (1U << fn)) == 0 ||
+		   (fn >= FN_SDR50 && !m->card_1v8)) {
+		fn = 0xFU;			/* UHS-I modes need 1.8 V signalling */
+	} else if (arg & 0x80000000U) {
+		m->card_hs = (int)fn;
+	}
+	s[16] = (uint8_t)fn;
+	s[17] = 1;				/* Data structure version */
+}
+
+/*
+ * Runs one command through the card. Returns 0 when the card answers, with
+ * the response in resp, or -1 for no response (a command timeout). For data
+ * commands the data source is set up in m->dat.
+ */
+static int card_cmd(sdhci_model *m, uint32_t idx, uint32_t arg, uint32_t resp[4])
+{
+	int app = m->app_cmd;
+	uint32_t rca_arg = arg >> 16;
+
+	m->app_cmd = 0;
+	m->stats.cmds++;
+	if (app)
+		m->stats.acmd[idx]++;
+	else
+		m->stats.cmd[idx]++;
+	memset(resp, 0, 4 * sizeof(uint32_t));
+
+	if (app) {
+		switch (idx) {
+		case 41:
+			if (m->card_state != CARD_IDLE && m->card_state != CARD_READY)
+				return -1;
+			resp[0] = OCR_VDD_27_36;
+			if ((arg & OCR_VDD_27_36) != 0 && ++m->acmd41_count >= 2) {
+				resp[0] |= OCR_BUSY | OCR_CCS;
+				/* A card already at 1.8 V does not ask again */
+				if (m->s18 && (arg & OCR_S18) != 0 && !m->card_1v8)
+					resp[0] |= OCR_S18;
+				m->card_state = CARD_READY;
+			}
+			return 0;
+		case 6:
+			if (m->card_state != CARD_TRAN)
+				return -1;
+			m->card_width = (arg & 3U) == 2U ? 4 : 1;
+			resp[0] = card_status(m);
+			return 0;
+		case 13:
+		case 51:
+			if (m->card_state != CARD_TRAN)
+				return -1;
+			memset(m->dat.buf, 0, sizeof(m->dat.buf));
+			if (idx == 51) {
+				m->dat.buf[0] = 0x02;	/* SCR 0, spec 2.00 */
+				m->dat.buf[1] = 0x35;	/* 1 and 4 bit */
+				m->dat.buf[2] = 0x80;	/* Spec 3.0x */
+				m->dat.buf[3] = m->cmd23 ? 0x02 : 0x00;
+			} else {
+				m->dat.buf[0] = m->card_width == 4 ? 0x80 : 0x00;
+			}
+			m->dat.from_card = 0;
+			resp[0] = card_status(m);
+			return 0;
+		default:
+			break;
+		}
+		/* Anything else falls back to the plain command */
+	}
+
+	switch (idx) {
+	case 0:
+		card_reset(m);
+		return 0;
+	case 2:
+		if (m->card_state != CARD_READY)
+			return -1;
+		m->card_state = CARD_IDENT;
+		card_cid(resp);
+		return 0;
+	case 3:
+		if (m->card_state != CARD_IDENT && m->card_state != CARD_STBY)
+			return -1;
+		m->card_state = CARD_STBY;
+		m->rca = CARD_RCA;
+		resp[0] = (m->rca << 16) | (m->card_state << 9) | R1_READY_FOR_DATA;
+		return 0;
+	case 6:
+		if (m->card_state != CARD_TRAN)
+			return -1;
+		card_switch(m, arg);
+		m->dat.from_card = 0;
+		resp[0] = card_status(m);
+		return 0;
+	case 7:
+		if (rca_arg != m->rca || m->rca == 0) {
+			if (rca_arg == 0 && m->card_state == CARD_TRAN)
+				m->card_state = CARD_STBY;
+			return -1;
+		}
+		resp[0] = card_status(m);
+		m->card_state = CARD_TRAN;
+		return 0;
+	case 8:
+		if (m->card_state != CARD_IDLE)
+			return -1;
+		resp[0] = arg & 0xFFFU;
+		return 0;
+	case 9:
+		if (m->card_state != CARD_STBY || rca_arg != m->rca)
+			return -1;
+		card_csd(m, resp);
+		return 0;
+	case 11:
+		if (!m->s18 || m->card_1v8 || m->card_state != CARD_READY)
+			return -1;
+		m->volt_switch = 1;
+		resp[0] = card_status(m);
+		return 0;
+	case 12:
+		if (m->card_state != CARD_DATA)
+			return -1;
+		m->card_state = CARD_TRAN;
+		resp[0] = card_status(m);
+		return 0;
+	case 13:
+		if (rca_arg != m->rca || m->rca == 0)
+			return -1;
+		resp[0] = card_status(m);
+		return 0;
+	case 16:
+		if (m->card_state != CARD_TRAN || arg != SDHCI_SECTOR_SIZE)
+			return -1;
+		resp[0] = card_status(m);
+		return 0;
+	case 17:
+	case 18:
+		if (m->card_state != CARD_TRAN)
+			return -1;
+		resp[0] = card_status(m);
+		m->dat.from_card = 1;
+		m->dat.sector = arg;
+		m->card_state = CARD_DATA;
+		return 0;
+	case 19:
+		if (m->card_state != CARD_TRAN || !m->card_1v8 ||
+		    (m->card_hs != FN_SDR50 && m->card_hs != FN_SDR104))
+			return -1;
+		memcpy(m->dat.buf, tuning_block, sizeof(tuning_block));
+		m->dat.from_card = 0;
+		resp[0] = card_status(m);
+		return 0;
+	case 23:
+		if (!m->cmd23 || m->card_state != CARD_TRAN)
+			return -1;
+		m->preset_count = arg & 0xFFFFU;
+		resp[0] = card_status(m);
+		return 0;
+	case 55:
+		if (m->rca != 0 ? rca_arg != m->rca : rca_arg != 0)
+			return -1;
+		m->app_cmd = 1;
+		resp[0] = card_status(m);
+		return 0;
+	default:
+		/* CMD1, CMD5, writes, ...: not for this card */
+		return -1;
+	}
+}
+
+// --- ADMA2 ---
+
+static void copy_data(sdhci_model *m, uint8_t *dst, uint32_t off, uint32_t len)
+{
+	if (!m->dat.from_card) {
+		for (uint32_t i = 0; i < len; i++)
+			dst[i] = off + i < sizeof(m->dat.buf) ? m->dat.buf[off + i] : 0;
+		return;
+	}
+
+	/* The card is bigger than the image; the rest reads as zeros */
+	off_t pos = (off_t)m->dat.sector * SDHCI_SECTOR_SIZE + off;
+	while (len > 0) {
+		ssize_t got = pread(m->fd, dst, len, pos);
+		if (got <= 0)
+			break;
+		dst += got;
+		pos += got;
+		len -= (uint32_t)got;
+	}
+	memset(dst, 0, len);
+}
+
+/*
+ * Walks the descriptor chain until upto bytes of the data have been
+ * written, carrying on from where the last call stopped; returns error
+ * status bits.
+ */
+static uint16_t adma_run(sdhci_model *m, uint32_t upto)
+{
+	int dma64 = (reg_get(m, XSDPS_HOST_CTRL1_OFFSET, 1) & XSDPS_HC_DMA_MASK) ==
+		    XSDPS_HC_DMA_ADMA2_64_MASK;
+
+	while (m->dat.done < upto) {
+		const uint8_t *d = (const uint8_t *)(uintptr_t)m->dat.desc;
+		uint16_t attr = (uint16_t)(d[0] | (d[1] << 8));
+		uint32_t len = (uint32_t)(d[2] | (d[3] << 8));
+		uint64_t addr = 0;
+		uint32_t n;
+
+		memcpy(&addr, d + 4, dma64 ? 8 : 4);
+		if (m->dat.desc_off == 0) {
+			/* A chain that links back on itself */
+			if (m->dat.descs++ >= 65536)
+				return XSDPS_INTR_ERR_ADMA_MASK;
+			m->stats.descs++;
+		}
+		if ((attr & XSDPS_DESC_VALID) == 0)
+			return XSDPS_INTR_ERR_ADMA_MASK;
+
+		switch (attr & 0x30U) {
+		case 0x30U:				/* Link */
+			m->dat.desc = addr;
+			continue;
+		case XSDPS_DESC_TRAN:
+			if (len == 0)
+				len = XSDPS_DESC_MAX_LENGTH;
+			n = len - m->dat.desc_off;
+			if (n > upto - m->dat.done)
+				n = upto - m->dat.done;
+			copy_data(m, (uint8_t *)(uintptr_t)(addr + m->dat.desc_off), m->dat.done, n);
+			m->dat.done += n;
+			m->dat.desc_off += n;
+			/* The rest of this descriptor waits for its blocks */
+			if (m->dat.desc_off < len && m->dat.done < m->dat.bytes)
+				return 0;
+			break;
+		default:				/* Nop */
+			break;
+		}
+		m->dat.desc_off = 0;
+		/* The chain ended before the block count did */
+		if ((attr & XSDPS_DESC_END) && m->dat.done < m->dat.bytes)
+			return XSDPS_INTR_ERR_ADMA_MASK;
+		m->dat.desc += dma64 ? 12 : 8;
+	}
+
+	return 0;
+}
+
+// --- Controller ---
+
+/*
+ * One tuning block has arrived. The sampling point locks after
+ * TUNE_LOCK_BLOCKS good ones; after TUNE_MAX_BLOCKS the controller gives
+ * up. Either way Execute Tuning clears, and Sampling Clock Select tells
+ * the driver which it was.
+ */
+static void tune_block(sdhci_model *m)
+{
+	uint32_t hc2 = reg_get(m, XSDPS_HOST_CTRL2_OFFSET, 2);
+
+	if ((hc2 & XSDPS_HC2_EXEC_TNG_MASK) == 0)
+		return;
+	m->tune_blocks++;
+	if (m->cmd.tune_ok && m->tune_blocks >= TUNE_LOCK_BLOCKS)
+		hc2 = (hc2 & ~XSDPS_HC2_EXEC_TNG_MASK) | XSDPS_HC2_SAMP_CLK_SEL_MASK;
+	else if (m->tune_blocks >= TUNE_MAX_BLOCKS)
+		hc2 &= ~(XSDPS_HC2_EXEC_TNG_MASK | XSDPS_HC2_SAMP_CLK_SEL_MASK);
+	reg_put(m, XSDPS_HOST_CTRL2_OFFSET, 2, hc2);
+}
+
+static void model_update(sdhci_model *m)
+{
+	if (m->cmd.active && m->now >= m->cmd.due) {
+		m->cmd.active = 0;
+		if (m->cmd.err) {
+			raise_irq(m, 0, m->cmd.err);
+		} else if (m->cmd.tuning) {
+			/* No Command Complete for a tuning block, only Buffer Read Ready */
+			tune_block(m);
+			raise_irq(m, XSDPS_INTR_BRR_MASK, 0);
+		} else {
+			for (int i = 0; i < 4; i++)
+				reg_put(m, XSDPS_RESP0_OFFSET + 4 * i, 4, m->cmd.resp[i]);
+			raise_irq(m, XSDPS_INTR_CC_MASK, 0);
+		}
+	}
+
+	/* Blocks whose bus time has passed are in memory already */
+	if (m->dat.active && m->dat.err == 0 && m->dat.block_ns != 0 && m->now > m->dat.start) {
+		uint64_t upto = (m->now - m->dat.start) / m->dat.block_ns * m->dat.blksz;
+
+		m->dat.err = adma_run(m, upto < m->dat.bytes ? (uint32_t)upto : m->dat.bytes);
+	}
+
+	if (m->dat.active && m->now >= m->dat.due) {
+		m->dat.active = 0;
+		if (m->dat.err == 0)
+			m->dat.err = adma_run(m, m->dat.bytes);
+		if (m->dat.err == 0)
+			m->stats.bytes += m->dat.bytes;
+		if (m->dat.auto_resp)
+			reg_put(m, XSDPS_RESP3_OFFSET, 4, m->dat.auto_resp);
+		if (m->dat.stop && m->card_state == CARD_DATA)
+			m->card_state = CARD_TRAN;
+		if (m->dat.err)
+			raise_irq(m, 0, m->dat.err);
+		else
+			raise_irq(m, XSDPS_INTR_TC_MASK, 0);
+	}
+}
+
+static void issue_command(sdhci_model *m)
+{
+	uint32_t tm = reg_get(m, XSDPS_XFER_MODE_OFFSET, 2);
+	uint32_t cr = reg_get(m, XSDPS_CMD_OFFSET, 2);
+	uint32_t idx = (cr >> 8) & 0x3FU;
+	uint32_t resp_sel = cr & XSDPS_CMD_RESP_SEL_MASK;
+	int data = (cr & XSDPS_DAT_PRESENT_SEL_MASK) != 0;
+	int multi = (tm & XSDPS_TM_MUL_SIN_BLK_SEL_MASK) != 0;
+	uint64_t clk = sd_clock(m);
+	uint64_t t = m->now;
+	uint32_t blocks;
+	uint32_t blksz;
+	uint32_t resp[4];
+	uint64_t max_clk = card_max_clock(m);	/* A CMD6 switch applies after its data */
+	uint32_t dma_sel = reg_get(m, XSDPS_HOST_CTRL1_OFFSET, 1) & XSDPS_HC_DMA_MASK;
+	uint32_t sar_hi = reg_get(m, XSDPS_ADMA_SAR_EXT_OFFSET, 4);
+	uint64_t ct;
+
+	/* The driver checks the inhibit bits; a command now would be lost */
+	if (m->cmd.active || (data && m->dat.active)) {
+		m->stats.errors++;
+		return;
+	}
+
+	m->cmd.active = 1;
+	m->cmd.err = 0;
+	m->cmd.tuning = 0;
+	if (clk == 0) {
+		m->cmd.due = t + CLK_OFF_TIMEOUT_NS;
+		m->cmd.err = XSDPS_INTR_ERR_CT_MASK;
+		return;
+	}
+
+	if (data && multi && (tm & TM_AUTO_CMD_MASK) == TM_AUTO_CMD23) {
+		ct = cmd_time(m, clk, XSDPS_CMD_RESP_L48_MASK);
+		m->stats.auto_cmd23++;
+		m->stats.cmd_ns += ct;
+		t += ct;
+		if (card_cmd(m, 23, reg_get(m, XSDPS_ARGMT2_LO_OFFSET, 4), resp) != 0) {
+			m->cmd.due = t;
+			m->cmd.err = XSDPS_INTR_ERR_AUTO_CMD12_MASK;
+			return;
+		}
+	}
+
+	ct = cmd_time(m, clk, resp_sel);
+	if (idx == 12)
+		ct += m->stop_ns;
+	m->stats.cmd_ns += ct;
+	t += ct;
+	m->cmd.due = t;
+	if (card_cmd(m, idx, reg_get(m, XSDPS_ARGMT_OFFSET, 4), m->cmd.resp) != 0) {
+		m->cmd.err = XSDPS_INTR_ERR_CT_MASK;
+		return;
+	}
+	if (!data)
+		return;
+
+	blksz = reg_get(m, XSDPS_BLK_SIZE_OFFSET, 2) & XSDPS_BLK_SIZE_MASK;
+
+	/* A tuning block goes to the sampling logic, not to the ADMA */
+	if (idx == 19 &&
+	    (reg_get(m, XSDPS_HOST_CTRL2_OFFSET, 2) & XSDPS_HC2_EXEC_TNG_MASK) != 0) {
+		ct = data_time(m, clk, blksz, 1);
+		m->stats.data_ns += ct;
+		m->cmd.due = t + ct;
+		m->cmd.tuning = 1;
+		m->cmd.tune_ok = (m->tune_fail & (1U << m->card_hs)) == 0 &&
+				 blksz == sizeof(m->dat.buf) && host_1v8(m) &&
+				 host_width(m) == m->card_width && clk <= max_clk;
+		return;
+	}
+
+	/* Data phase */
+	if (!multi)
+		blocks = 1;
+	else if (tm & XSDPS_TM_BLK_CNT_EN_MASK)
+		blocks = reg_get(m, XSDPS_BLK_CNT_OFFSET, 2);
+	else
+		blocks = m->preset_count;
+
+	m->dat.active = 1;
+	m->dat.err = 0;
+	m->dat.bytes = blocks * blksz;
+	m->dat.stop = !multi || m->preset_count != 0;
+	m->dat.auto_resp = 0;
+	m->dat.blksz = blksz;
+	m->dat.done = 0;
+	m->dat.desc = ((uint64_t)(sar_hi ? sar_hi : m->dma_hi) << 32) |
+		      reg_get(m, XSDPS_ADMA_SAR_OFFSET, 4);
+	m->dat.desc_off = 0;
+	m->dat.descs = 0;
+	m->preset_count = 0;
+
+	if (m->dat.from_card) {
+		m->stats.reads++;
+		m->stats.access_ns += m->access_ns;
+		t += m->access_ns;
+		if (blksz != SDHCI_SECTOR_SIZE || blocks == 0 ||
+		    (uint64_t)m->dat.sector + blocks > m->capacity)
+			m->dat.err = XSDPS_INTR_ERR_DT_MASK;
+	}
+	if ((tm & XSDPS_TM_DMA_EN_MASK) == 0 || (tm & XSDPS_TM_DAT_DIR_SEL_MASK) == 0)
+		m->dat.err = XSDPS_INTR_ERR_DT_MASK;	/* Only DMA reads are modelled */
+	if (host_width(m) != m->card_width || clk > max_clk || host_1v8(m) != m->card_1v8)
+		m->dat.err = XSDPS_INTR_ERR_DCRC_MASK;
+	/* Past SDR25 clocks the data is only sampled right once tuned */
+	if (clk > SDR25_MAX_HZ && !host_ddr(m) &&
+	    (reg_get(m, XSDPS_HOST_CTRL2_OFFSET, 2) & XSDPS_HC2_SAMP_CLK_SEL_MASK) == 0)
+		m->dat.err = XSDPS_INTR_ERR_DCRC_MASK;
+	if (m->dat.err == 0 && dma_sel != XSDPS_HC_DMA_ADMA2_64_MASK &&
+	    dma_sel != XSDPS_HC_DMA_ADMA2_32_MASK)
+		m->dat.err = XSDPS_INTR_ERR_ADMA_MASK;	/* SDMA/ADMA1 not modelled */
+
+	ct = data_time(m, clk, m->dat.bytes, blocks);
+	m->stats.data_ns += ct;
+	m->dat.start = t;
+	m->dat.block_ns = blocks != 0 ? ct / blocks : 0;
+	t += ct;
+
+	if (multi && (tm & TM_AUTO_CMD_MASK) == TM_AUTO_CMD12) {
+		ct = cmd_time(m, clk, XSDPS_CMD_RESP_L48_BSY_CHK_MASK) + m->stop_ns;
+		m->stats.auto_cmd12++;
+		m->stats.cmd_ns += ct;
+		t += ct;
+		/* The card is still in the data state until the transfer ends */
+		if (m->dat.stop)
+			m->dat.err |= XSDPS_INTR_ERR_AUTO_CMD12_MASK;
+		m->stats.cmds++;
+		m->stats.cmd[12]++;
+		m->dat.auto_resp = (CARD_TRAN << 9) | R1_READY_FOR_DATA;
+		m->dat.stop = 1;
+	}
+	m->dat.due = t;
+}
+
+static void write_byte(sdhci_model *m, unsigned int off, uint8_t v)
+{
+	switch (off) {
+	case XSDPS_NORM_INTR_STS_OFFSET:
+	case XSDPS_NORM_INTR_STS_OFFSET + 1:
+	case XSDPS_ERR_INTR_STS_OFFSET:
+	case XSDPS_ERR_INTR_STS_OFFSET + 1:
+		m->reg[off] &= (uint8_t)~v;		/* Write 1 to clear */
+		break;
+	case XSDPS_SW_RST_OFFSET:
+		if (v & XSDPS_SWRST_ALL_MASK) {
+			reset_regs(m);
+		} else {
+			if (v & XSDPS_SWRST_CMD_LINE_MASK)
+				m->cmd.active = 0;
+			if (v & XSDPS_SWRST_DAT_LINE_MASK)
+				m->dat.active = 0;
+		}
+		break;
+	case XSDPS_CLK_CTRL_OFFSET:
+		/* The internal clock is stable as soon as it is enabled */
+		v &= (uint8_t)~XSDPS_CC_INT_CLK_STABLE_MASK;
+		if (v & XSDPS_CC_INT_CLK_EN_MASK)
+			v |= XSDPS_CC_INT_CLK_STABLE_MASK;
+		m->reg[off] = v;
+		/*
+		 * After CMD11 the card waits for the SD clock to stop, then
+		 * for it to come back at 1.8 V no sooner than VOLT_SWITCH_NS
+		 * later. Anything else leaves it stuck until a power cycle.
+		 */
+		if (m->volt_switch == 1 && (v & XSDPS_CC_SD_CLK_EN_MASK) == 0) {
+			m->volt_switch = 2;
+			m->volt_due = m->now + VOLT_SWITCH_NS;
+		} else if (m->volt_switch == 2 && (v & XSDPS_CC_SD_CLK_EN_MASK) != 0) {
+			if (host_1v8(m) && m->now >= m->volt_due) {
+				m->card_1v8 = 1;
+				m->volt_switch = 0;
+			} else {
+				m->volt_switch = 3;
+			}
+		}
+		break;
+	case XSDPS_HOST_CTRL2_OFFSET:
+		/* Starting a tuning run drops the sampling clock it tunes */
+		if ((v & XSDPS_HC2_EXEC_TNG_MASK) != 0 &&
+		    (m->reg[off] & XSDPS_HC2_EXEC_TNG_MASK) == 0) {
+			v &= (uint8_t)~XSDPS_HC2_SAMP_CLK_SEL_MASK;
+			m->tune_blocks = 0;
+		}
+		m->reg[off] = v;
+		break;
+	case XSDPS_POWER_CTRL_OFFSET:
+		if ((v & XSDPS_PC_BUS_PWR_MASK) == 0) {
+			card_reset(m);
+			m->card_1v8 = 0;
+			m->volt_switch = 0;
+		}
+		m->reg[off] = v;
+		break;
+	default:
+		/* Responses, present state and capabilities are read-only */
+		if ((off >= XSDPS_RESP0_OFFSET && off < XSDPS_BUF_DAT_PORT_OFFSET) ||
+		    (off >= XSDPS_PRES_STATE_OFFSET && off < XSDPS_HOST_CTRL1_OFFSET) ||
+		    (off >= XSDPS_CAPS_OFFSET && off < XSDPS_FE_AUTO_CMD12_EIS_OFFSET) ||
+		    off >= XSDPS_SLOT_INTR_STS_OFFSET)
+			break;
+		m->reg[off] = v;
+		break;
+	}
+}
+
+static void refresh_status(sdhci_model *m)
+{
+	uint32_t ps = XSDPS_PSR_CARD_INSRT_MASK | XSDPS_PSR_CARD_STABLE_MASK |
+		      XSDPS_PSR_CARD_DPL_MASK | XSDPS_PSR_WPS_PL_MASK |
+		      XSDPS_PSR_DAT30_SG_LVL_MASK | XSDPS_PSR_CMD_SG_LVL_MASK;
+	uint32_t norm = reg_get(m, XSDPS_NORM_INTR_STS_OFFSET, 2) & ~XSDPS_INTR_ERR_MASK;
+
+	/* The card drives CMD and DAT[3:0] low during the voltage switch */
+	if (m->volt_switch != 0)
+		ps &= ~(XSDPS_PSR_DAT30_SG_LVL_MASK | XSDPS_PSR_CMD_SG_LVL_MASK);
+	if (m->cmd.active)
+		ps |= XSDPS_PSR_INHIBIT_CMD_MASK;
+	if (m->dat.active)
+		ps |= XSDPS_PSR_INHIBIT_DAT_MASK | XSDPS_PSR_DAT_ACTIVE_MASK |
+		      XSDPS_PSR_RD_ACTIVE_MASK;
+	reg_put(m, XSDPS_PRES_STATE_OFFSET, 4, ps);
+
+	/* The error summary bit follows the error status register */
+	if (reg_get(m, XSDPS_ERR_INTR_STS_OFFSET, 2) != 0)
+		norm |= XSDPS_INTR_ERR_MASK;
+	reg_put(m, XSDPS_NORM_INTR_STS_OFFSET, 2, norm);
+}
+
+// --- Interface ---
+
+int sdhci_model_read(uintptr_t addr, unsigned int size, uint64_t *val)
+{
+	sdhci_model *m = model;
+	uint64_t v = 0;
+
+	if (m == NULL)
+		return 0;
+	if (addr >= SLCR_BASE && addr + size <= SLCR_BASE + SLCR_SIZE) {
+		*val = m->slcr[(addr - SLCR_BASE) / 4];
+		return 1;
+	}
+	if (addr < model_base || addr + size > model_base + SDHCI_WINDOW)
+		return 0;
+
+	m->now += m->reg_ns;
+	m->stats.reg_accesses++;
+	model_update(m);
+	refresh_status(m);
+
+	unsigned int off = (unsigned int)(addr - model_base);
+	for (unsigned int i = 0; i < size; i++)
+		v |= (uint64_t)(off + i < sizeof(m->reg) ? m->reg[off + i] : 0) << (8 * i);
+	*val = v;
+	return 1;
+}
+
+int sdhci_model_write(uintptr_t addr, unsigned int size, uint64_t val)
+{
+	sdhci_model *m = model;
+
+	if (m == NULL)
+		return 0;
+	if (addr >= SLCR_BASE && addr + size <= SLCR_BASE + SLCR_SIZE) {
+		m->slcr[(addr - SLCR_BASE) / 4] = (uint32_t)val;
+		return 1;
+	}
+	if (addr < model_base || addr + size > model_base + SDHCI_WINDOW)
+		return 0;
+
+	m->now += m->reg_ns;
+	m->stats.reg_accesses++;
+	model_update(m);
+
+	unsigned int off = (unsigned int)(addr - model_base);
+	for (unsigned int i = 0; i < size; i++) {
+		if (off + i < sizeof(m->reg))
+			write_byte(m, off + i, (uint8_t)(val >> (8 * i)));
+	}
+
+	/* Writing the upper byte of the command register sends the command */
+	if (off <= XSDPS_CMD_OFFSET + 1 && off + size > XSDPS_CMD_OFFSET + 1)
+		issue_command(m);
+	return 1;
+}
+
+uint64_t sdhci_model_now(void)
+{
+	return model ? model->now : 0;
+}
+
+void sdhci_model_delay(uint64_t ns)
+{
+	if (model == NULL)
+		return;
+	model->now += ns;
+	model_update(model);
+}
+
+uint64_t sdhci_model_next_event(void)
+{
+	uint64_t next = UINT64_MAX;
+
+	if (model == NULL)
+		return next;
+	if (model->cmd.active)
+		next = model->cmd.due;
+	if (model->dat.active && model->dat.due < next)
+		next = model->dat.due;
+	if (next == UINT64_MAX)
+		return next;
+	return next > model->now ? next - model->now : 0;
+}
+
+int sdhci_model_open(sdhci_model *m, const char *path, uintptr_t base_addr)
+{
+	memset(m, 0, sizeof(*m));
+	m->fd = open(path, O_RDONLY);
+	if (m->fd < 0) {
+		perror(path);
+		return -1;
+	}
+
+	m->base_clock_hz = 187498123ULL;
+	m->cmd_ns = 2000ULL;
+	m->access_ns = 100000ULL;
+	m->stop_ns = 20000ULL;
+	m->capacity = 16U * 1024U * 1024U;	/* 8GB */
+	m->speed_support = 0x03U;		/* Default and High Speed */
+	m->cmd23 = 1;
+	m->s18 = 0;				/* 3.3 V only */
+	m->tune_fail = 0;
+	m->dma_hi = 0;
+
+	reset_regs(m);
+	card_reset(m);
+	model = m;
+	model_base = base_addr;
+
+	return 0;
+}
+
+void sdhci_model_close(sdhci_model *m)
+{
+	close(m->fd);
+	if (model == m)
+		model = NULL;
+}
@@ -0,0 +1,152 @@
+#ifndef __SDHCI_MODEL_H
+#define __SDHCI_MODEL_H
+
+#include <stdint.h>
+
+/*
+ * Host model of the ZynqMP SD controller and an SD card
+ *
+ * The vendored sd_card_driver is built for the host against the stub BSP in
+ * bsp/, whose Xil_In/Xil_Out send the SDHCI register window to this model.
+ * The model implements the Arasan SDHCI 3.0 register file, the ADMA2 engine
+ * (32- and 64-bit descriptors, TRAN/LINK/NOP, END) and an SDHC card backed
+ * by an image file: identification, CMD6 speed switching, ACMD6 bus width,
+ * CMD17/18 reads, CMD23 block counts and CMD12, plus Auto CMD12/CMD23.
+ *
+ * Time is virtual. Every command costs cmd_ns plus its bits at the SD clock
+ * the driver programmed, every read adds access_ns before the first block,
+ * and the data moves at the bus rate (clock, width, DDR) capped by the
+ * card's own limit. A read stopped by CMD12 also holds the card busy for
+ * stop_ns, which a read sized by CMD23 does not. Driver delays and polls advance the same clock, so a
+ * read that waits on Transfer Complete takes exactly as long as the bus
+ * would. Command and response registers only change when their event is
+ * due, which keeps asynchronous paths honest. Read data reaches memory a
+ * block at a time, as each block's bus time passes, so work the caller
+ * does between starting a read and waiting for it runs alongside the
+ * transfer rather than before or after it.
+ *
+ * A card with s18 set also takes the UHS-I path: it answers S18R in ACMD41,
+ * holds CMD and DAT[3:0] low after CMD11 until the host has stopped the SD
+ * clock for 5 ms and restarted it with 1.8 V signalling, and sends tuning
+ * blocks for CMD19 in SDR50/SDR104. The controller locks its sampling
+ * clock after TUNE_LOCK_BLOCKS of them, or gives up after 40 in the modes
+ * listed in tune_fail. Reads fail with a data CRC error when the signalling
+ * levels disagree or an SDR50/SDR104 clock runs untuned. Writes are refused.
+ */
+
+#define SDHCI_SECTOR_SIZE	512U
+
+typedef struct {
+	uint64_t cmds;			/* Commands on the bus, automatic ones included */
+	uint64_t cmd[64];		/* By index */
+	uint64_t acmd[64];		/* App commands by index */
+	uint64_t auto_cmd12;
+	uint64_t auto_cmd23;
+	uint64_t reads;			/* CMD17/CMD18 */
+	uint64_t bytes;			/* Moved by the ADMA */
+	uint64_t descs;			/* Descriptors fetched */
+	uint64_t errors;		/* Error interrupts raised */
+	uint64_t reg_accesses;
+	uint64_t cmd_ns;		/* Bus time spent on commands and responses */
+	uint64_t access_ns;		/* Card access time before read data */
+	uint64_t data_ns;		/* Bus time spent moving data */
+} sdhci_stats;
+
+typedef struct {
+	/* Configuration; sdhci_model_open() sets defaults, change before init */
+	uint64_t base_clock_hz;		/* SDHCI reference clock */
+	uint64_t cmd_ns;		/* Card latency per command, on top of the bits */
+	uint64_t access_ns;		/* Card latency before the first read block */
+	uint64_t stop_ns;		/* Card busy after CMD12 ends a read */
+	uint64_t card_bw;		/* Card read limit in bytes/s, 0 for the bus rate */
+	uint64_t reg_ns;		/* Charged for each register access */
+	uint32_t capacity;		/* Card size in sectors */
+	uint8_t speed_support;		/* CMD6 function group 1 support bits */
+	uint8_t cmd23;			/* SCR advertises CMD23 */
+	uint8_t s18;			/* Card switches to 1.8 V signalling (UHS-I) */
+	uint8_t tune_fail;		/* CMD6 group 1 functions whose tuning never locks */
+	uint32_t dma_hi;		/* Upper ADMA SAR word when the driver only writes the low one */
+
+	sdhci_stats stats;
+
+	/* Controller and card state; private to sdhci_model.c */
+	int fd;
+	uint64_t now;
+	uint8_t reg[0x100];
+	uint32_t slcr[0x400];
+	struct {
+		int active;
+		uint64_t due;
+		uint16_t err;
+		int tuning;		/* A tuning block; ends in Buffer Read Ready */
+		int tune_ok;		/* The block can be sampled */
+		uint32_t resp[4];
+	} cmd;
+	struct {
+		int active;
+		uint64_t due;
+		uint16_t err;
+		int from_card;		/* Sectors from the image, else buf */
+		uint32_t sector;
+		uint32_t bytes;
+		uint64_t start;		/* First block on the bus */
+		uint64_t block_ns;	/* Bus time per block */
+		uint32_t blksz;
+		uint32_t done;		/* Bytes the ADMA has written so far */
+		uint64_t desc;		/* Descriptor the ADMA is on */
+		uint32_t desc_off;	/* Bytes of it already written */
+		uint32_t descs;		/* Descriptors fetched for this transfer */
+		int stop;		/* Card leaves the data state at the end */
+		uint32_t auto_resp;	/* Auto CMD12 response, or 0 */
+		uint8_t buf[64];
+	} dat;
+	uint32_t card_state;
+	uint32_t rca;
+	int app_cmd;
+	int acmd41_count;
+	int card_width;			/* 1 or 4 */
+	int card_hs;			/* CMD6 group 1 function */
+	int card_1v8;			/* Card signals at 1.8 V */
+	int volt_switch;		/* 1: CMD11 taken, 2: SD clock stopped, 3: failed */
+	uint64_t volt_due;		/* Clock may restart at 1.8 V from here */
+	uint32_t tune_blocks;		/* In the current tuning run */
+	uint32_t preset_count;		/* From CMD23, 0 if none */
+} sdhci_model;
+
+/**
+ * @brief	Opens a card image and attaches the model to the SDHCI window.
+ *
+ * @param	base_addr: Address of the controller in the driver configuration.
+ *
+ * @return	0 if successful, -1 otherwise.
+ */
+int sdhci_model_open(sdhci_model *m, const char *path, uintptr_t base_addr);
+
+void sdhci_model_close(sdhci_model *m);
+
+/**
+ * @brief	Register access from the BSP.
+ *
+ * @return	1 if addr belongs to the model (and *val was read or written),
+ *          0 otherwise.
+ */
+int sdhci_model_read(uintptr_t addr, unsigned int size, uint64_t *val);
+int sdhci_model_write(uintptr_t addr, unsigned int size, uint64_t val);
+
+/**
+ * @brief	Model time in ns.
+ */
+uint64_t sdhci_model_now(void);
+
+/**
+ * @brief	Advances model time, completing whatever falls due.
+ */
+void sdhci_model_delay(uint64_t ns);
+
+/**
+ * @brief	Time until the next command or data event, or UINT64_MAX if
+ *          nothing is in flight.
+ */
+uint64_t sdhci_model_next_event(void);
+
+#endif /* __SDHCI_MODEL_H */
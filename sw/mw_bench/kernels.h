@@ -0,0 +1,30 @@
+#ifndef __KERNELS_H
+#define __KERNELS_H
+
+#include <stdint.h>
+
+/*
+ * Timed loops in kernels.S. Those taking n run 8 * n operations.
+ */
+
+uint64_t *mwb_chase(uint64_t *p, uint64_t n);
+uint64_t *mwb_chase_ci(uint64_t *p, uint64_t n);
+
+void mwb_read(const void *buf, uint64_t lines);
+void mwb_write(void *buf, uint64_t lines);
+
+uint64_t mwb_branch(const uint8_t *bits, uint64_t n);
+
+/* init points at the doubles { 1.0, 0.0 }; integer loops ignore it */
+typedef void mwb_op_kernel(uint64_t n, const uint64_t *init);
+
+mwb_op_kernel mwb_mulld_lat, mwb_mulld_tput;
+mwb_op_kernel mwb_mullw_lat, mwb_mullw_tput;
+mwb_op_kernel mwb_divdu_lat, mwb_divdu_tput;
+mwb_op_kernel mwb_divwu_lat, mwb_divwu_tput;
+mwb_op_kernel mwb_fadd_lat, mwb_fadd_tput;
+mwb_op_kernel mwb_fmul_lat, mwb_fmul_tput;
+mwb_op_kernel mwb_fdiv_lat, mwb_fdiv_tput;
+mwb_op_kernel mwb_fmadd_lat, mwb_fmadd_tput;
+
+#endif /* __KERNELS_H */
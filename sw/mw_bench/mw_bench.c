@@ -0,0 +1,365 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "print.h"
+#include "console.h"
+#include "io.h"
+#include "irq.h"
+#include "microwatt_soc.h"
+#include "mw_shared.h"
+#include "timebase.h"
+#include "pmu.h"
+#include "kernels.h"
+
+#define MSR_FP		0x2000UL
+
+#define LINE_SIZE	64U		/* L1 line, rtl/core.vhdl */
+#define L1_CHAIN_BYTES	2048U		/* Well inside the 8KB data cache */
+
+/*
+ * The simulation model is a few hundred KB of memory behind AXI-Lite, and
+ * every cycle costs wall-clock time, so it gets smaller buffers and fewer
+ * rounds. Both still dwarf the data cache.
+ */
+#ifdef MW_SIM
+#define BUF_BYTES	32768U
+#define BRANCH_BYTES	1024U
+#define OP_ROUNDS	64U
+#define IRQ_TRIES	4U
+#else
+#define BUF_BYTES	(4U << 20)
+#define BRANCH_BYTES	16384U
+#define OP_ROUNDS	4096U
+#define IRQ_TRIES	64U
+#endif
+
+#define SIM_EOT		0x04		/* Tells the testbench to stop */
+#define CONSOLE_LINES	16U		/* Lines per console measurement */
+
+static const char console_line[] =
+	"mw_bench: console line written through uart_write() ....\n\r";
+
+static uint64_t buf[BUF_BYTES / 8] __attribute__((aligned(LINE_SIZE)));
+static uint8_t branch_bits[BRANCH_BYTES];
+
+/* The doubles 1.0 and 0.0 */
+static const uint64_t fp_init[2] = { 0x3FF0000000000000ULL, 0 };
+
+static volatile uint64_t irq_tb;
+
+static void print_padded(const char *s, int width)
+{
+	my_printf("%-*s", width, s);
+}
+
+static void print_right(int v, int width)
+{
+	my_printf("%*d", width, v);
+}
+
+/* count / ops as x.yy */
+static void print_ratio(uint64_t count, uint64_t ops)
+{
+	uint64_t x100 = ops ? count * 100 / ops : 0;
+
+	print_right((int)(x100 / 100), 6);
+	my_printf(".%02d", (int)(x100 % 100));
+}
+
+/**
+ * @brief Prints one result row: timebase ticks (core cycles), completed
+ *        instructions, data cache misses and branch mispredictions per
+ *        operation.
+ */
+static void report(const char *name, const pmu_sample *d, uint64_t ops)
+{
+	print_padded(name, 22);
+	print_ratio(d->tb, ops);
+	print_ratio(d->pmc[PMU_INSNS], ops);
+	print_ratio(d->pmc[PMU_DC_MISSES], ops);
+	print_ratio(d->pmc[PMU_BR_MISPREDICTS], ops);
+	my_printf("\n\r");
+}
+
+static void report_bandwidth(const char *name, const pmu_sample *d, uint64_t bytes)
+{
+	uint64_t mbps = d->tb ? bytes * (TB_FREQ_HZ / 1000000UL) / d->tb : 0;
+
+	print_padded(name, 22);
+	print_right((int)mbps, 9);
+	my_printf(" MB/s, %d ticks for %d KB, %d line misses\n\r", (int)d->tb,
+		  (int)(bytes >> 10), (int)d->pmc[PMU_DC_MISSES]);
+}
+
+/**
+ * @brief Links the lines of the first bytes of buf into one cycle, visiting
+ *        them in a scrambled order so no access is next to the last.
+ * @return The head of the chain.
+ */
+static uint64_t *build_chain(uint32_t bytes)
+{
+	uint32_t lines = bytes / LINE_SIZE;	/* A power of two */
+	uint32_t step = LINE_SIZE / 8;
+
+	for (uint32_t i = 0; i < lines; i++) {
+		// 97 is odd, so i * 97 visits every line once
+		uint32_t from = (i * 97U) & (lines - 1);
+		uint32_t to = ((i + 1) * 97U) & (lines - 1);
+
+		buf[from * step] = (uint64_t)&buf[to * step];
+	}
+	return buf;
+}
+
+static void flush_buf(uint32_t bytes)
+{
+	for (uint32_t off = 0; off < bytes; off += LINE_SIZE) {
+		__asm__ volatile("dcbf 0,%0" : : "r" ((uint8_t *)buf + off) : "memory");
+	}
+	__asm__ volatile("sync" : : : "memory");
+}
+
+static void bench_latency(void)
+{
+	uint32_t lines = BUF_BYTES / LINE_SIZE;
+	pmu_sample s, e;
+	uint64_t *p;
+
+	// L1 hit: a short chain, walked once untimed to bring it in
+	p = build_chain(L1_CHAIN_BYTES);
+	p = mwb_chase(p, L1_CHAIN_BYTES / LINE_SIZE);
+	pmu_read(&s);
+	p = mwb_chase(p, OP_ROUNDS);
+	pmu_read(&e);
+	pmu_delta(&e, &s);
+	report("load L1 hit", &e, 8ULL * OP_ROUNDS);
+
+	// Cache-inhibited: the same chain, every load going out to DRAM
+	pmu_read(&s);
+	p = mwb_chase_ci(p, OP_ROUNDS / 8);
+	pmu_read(&e);
+	pmu_delta(&e, &s);
+	report("load cache-inhibited", &e, OP_ROUNDS);
+
+	// L1 miss: a chain over the whole buffer, flushed out of the cache first
+	p = build_chain(BUF_BYTES);
+	flush_buf(BUF_BYTES);
+	pmu_read(&s);
+	p = mwb_chase(p, lines / 8);
+	pmu_read(&e);
+	pmu_delta(&e, &s);
+	report("load L1 miss", &e, lines);
+}
+
+static void bench_bandwidth(void)
+{
+	uint32_t lines = BUF_BYTES / LINE_SIZE;
+	pmu_sample s, e;
+
+	flush_buf(BUF_BYTES);
+	pmu_read(&s);
+	mwb_read(buf, lines);
+	pmu_read(&e);
+	pmu_delta(&e, &s);
+	report_bandwidth("DDR read", &e, BUF_BYTES);
+
+	pmu_read(&s);
+	mwb_write(buf, lines);
+	pmu_read(&e);
+	pmu_delta(&e, &s);
+	report_bandwidth("DDR write", &e, BUF_BYTES);
+}
+
+/**
+ * @brief Times the same loop over branch_bits filled with ones, where the
+ *        forward branch is never taken and always predicted right, and with
+ *        pseudo-random bits, where about half of them are mispredicted.
+ *        The difference, over the difference in mispredictions the PMU
+ *        counted, is the cost of one.
+ */
+static void bench_branch(void)
+{
+	pmu_sample s, e, pred;
+	uint32_t lfsr = 0xACE1U;
+	uint64_t extra_misses;
+
+	for (uint32_t i = 0; i < BRANCH_BYTES; i++) {
+		branch_bits[i] = 1;
+	}
+	mwb_branch(branch_bits, BRANCH_BYTES);
+	pmu_read(&s);
+	mwb_branch(branch_bits, BRANCH_BYTES);
+	pmu_read(&pred);
+	pmu_delta(&pred, &s);
+	report("branch predictable", &pred, BRANCH_BYTES);
+
+	for (uint32_t i = 0; i < BRANCH_BYTES; i++) {
+		lfsr = (lfsr >> 1) ^ (-(lfsr & 1U) & 0xB400U);
+		branch_bits[i] = lfsr & 1U;
+	}
+	mwb_branch(branch_bits, BRANCH_BYTES);
+	pmu_read(&s);
+	mwb_branch(branch_bits, BRANCH_BYTES);
+	pmu_read(&e);
+	pmu_delta(&e, &s);
+	report("branch random", &e, BRANCH_BYTES);
+
+	extra_misses = e.pmc[PMU_BR_MISPREDICTS] - pred.pmc[PMU_BR_MISPREDICTS];
+	print_padded("mispredict cost", 22);
+	if (e.pmc[PMU_BR_MISPREDICTS] <= pred.pmc[PMU_BR_MISPREDICTS]) {
+		my_printf("      n/a, the PMU counted no extra mispredictions\n\r");
+		return;
+	}
+	print_ratio(e.tb - pred.tb, extra_misses);
+	my_printf(" cycles (%d extra mispredictions)\n\r", (int)extra_misses);
+}
+
+static void run_op(const char *name, mwb_op_kernel *fn)
+{
+	pmu_sample s, e;
+
+	fn(1, fp_init);
+	pmu_read(&s);
+	fn(OP_ROUNDS, fp_init);
+	pmu_read(&e);
+	pmu_delta(&e, &s);
+	report(name, &e, 8ULL * OP_ROUNDS);
+}
+
+static void bench_ops(void)
+{
+	uint64_t msr;
+
+	run_op("mulld latency", mwb_mulld_lat);
+	run_op("mulld throughput", mwb_mulld_tput);
+	run_op("mullw latency", mwb_mullw_lat);
+	run_op("mullw throughput", mwb_mullw_tput);
+	run_op("divdu latency", mwb_divdu_lat);
+	run_op("divdu throughput", mwb_divdu_tput);
+	run_op("divwu latency", mwb_divwu_lat);
+	run_op("divwu throughput", mwb_divwu_tput);
+
+	__asm__ volatile("mfmsr %0" : "=r" (msr));
+	__asm__ volatile("mtmsrd %0" : : "r" (msr | MSR_FP) : "memory");
+	run_op("fadd latency", mwb_fadd_lat);
+	run_op("fadd throughput", mwb_fadd_tput);
+	run_op("fmul latency", mwb_fmul_lat);
+	run_op("fmul throughput", mwb_fmul_tput);
+	run_op("fdiv latency", mwb_fdiv_lat);
+	run_op("fdiv throughput", mwb_fdiv_tput);
+	run_op("fmadd latency", mwb_fmadd_lat);
+	run_op("fmadd throughput", mwb_fmadd_tput);
+	__asm__ volatile("mtmsrd %0" : : "r" (msr) : "memory");
+}
+
+static void dec_hit(uint64_t srr0)
+{
+	(void)srr0;
+	irq_tb = mftb();
+}
+
+/**
+ * @brief Makes a decrementer interrupt pending with MSR[EE] off, then
+ *        turns EE on right after reading the timebase.
+ * @return Ticks from there to the first instruction of the C handler,
+ *         through the vector and the register saves in head.S.
+ */
+static uint64_t irq_entry_ticks(void)
+{
+	uint64_t msr = irq_save();
+	uint64_t t0;
+
+	irq_tb = 0;
+	mtdec(0);
+	while ((int32_t)mfdec() >= 0) {
+		// Pending once bit 31 is set
+	}
+	__asm__ volatile("mftb %0; mtmsrd %1,1" : "=&r" (t0) : "r" (msr | MSR_EE) : "memory");
+	while (irq_tb == 0) {
+		// The handler runs between here and mtmsrd
+	}
+	irq_restore(msr);
+	return irq_tb - t0;
+}
+
+static void bench_irq(void)
+{
+	uint64_t min = UINT64_MAX, max = 0, sum = 0;
+
+	irq_set_dec_handler(dec_hit);
+	irq_entry_ticks();
+	for (uint32_t i = 0; i < IRQ_TRIES; i++) {
+		uint64_t t = irq_entry_ticks();
+
+		min = t < min ? t : min;
+		max = t > max ? t : max;
+		sum += t;
+	}
+	irq_set_dec_handler(NULL);
+
+	print_padded("interrupt entry", 22);
+	print_right((int)min, 9);
+	my_printf(" min, %d max, %d mean cycles to the C handler\n\r", (int)max, (int)(sum / IRQ_TRIES));
+}
+
+static void console_lines(const char *name)
+{
+	uint32_t len = sizeof(console_line) - 1;
+	pmu_sample s, e;
+
+	pmu_read(&s);
+	for (uint32_t i = 0; i < CONSOLE_LINES; i++) {
+		uart_write(console_line, len);
+	}
+	pmu_read(&e);
+	pmu_delta(&e, &s);
+	report(name, &e, (uint64_t)CONSOLE_LINES * len);
+}
+
+/**
+ * @brief Times uart_write() per byte on the polled UART, which waits for
+ *        the serial line, and then on the memory console ring when the A53
+ *        serves one (mw_console in mw_shared.h), which only waits for ring
+ *        space. The bench lines themselves are the text written.
+ */
+static void bench_console(void)
+{
+	unsigned long mc = MW_SHARED_BASE + MW_SHARED_CONSOLE_OFFSET;
+
+	console_lines("console UART");
+#ifndef MW_SIM
+	if (readl(mc + offsetof(mw_console, magic)) != MW_CONSOLE_MAGIC) {
+		my_printf("console ring          n/a, the A53 serves no console ring\n\r");
+		return;
+	}
+	console_init();
+	console_lines("console ring");
+	console_shutdown();
+#else
+	(void)mc;
+#endif
+}
+
+int main(void)
+{
+	irq_init();
+	pmu_init();
+
+	my_printf("\n\rmw_bench: Microwatt micro-benchmarks, %d ticks/us\n\r",
+		  (int)(TB_FREQ_HZ / 1000000UL));
+	print_padded("", 22);
+	my_printf("   cyc/op  insn/op  miss/op mispr/op\n\r");
+
+	bench_latency();
+	bench_bandwidth();
+	bench_branch();
+	bench_ops();
+	bench_irq();
+	bench_console();
+
+	my_printf("mw_bench: done\n\r");
+#ifdef MW_SIM
+	uart_transmit_byte(SIM_EOT);
+#endif
+	return 0;
+}
@@ -0,0 +1,344 @@
+#ifdef MW_BENCH
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+#include "bench.h"
+#include "bulk.h"
+#include "print.h"
+#include "console.h"
+#include "string.h"
+#include "timebase.h"
+
+#define BENCH_MAX_SIZE		65536U
+#define BENCH_BYTES		262144U		/* Moved per measurement */
+#define BENCH_PRINTF_ROUNDS	256U
+
+static uint8_t bench_src[BENCH_MAX_SIZE + 128] __attribute__((aligned(64)));
+static uint8_t bench_dst[BENCH_MAX_SIZE + 128] __attribute__((aligned(64)));
+
+static const uint32_t bench_sizes[] = { 16, 64, 512, 4096, BENCH_MAX_SIZE };
+
+/* Destination and source offsets from a cache line boundary */
+static const struct {
+	uint32_t dst;
+	uint32_t src;
+} bench_align[] = { { 0, 0 }, { 0, 3 }, { 5, 5 }, { 7, 2 } };
+
+enum { OP_BYTE_COPY, OP_MEMCPY, OP_MEMMOVE, OP_BYTE_SET, OP_MEMSET, OP_MEMSET_ZERO,
+	OP_BULK_COPY, OP_BULK_ZERO, OP_COUNT };
+
+static const char *const op_name[OP_COUNT] = {
+	"byte copy", "memcpy", "memmove", "byte set", "memset", "memset 0",
+	"bulk copy", "bulk 0"
+};
+
+static __attribute__((noinline)) void byte_copy(uint8_t *d, const uint8_t *s, uint32_t n)
+{
+	while (n--) {
+		*d++ = *s++;
+	}
+}
+
+static __attribute__((noinline)) void byte_set(uint8_t *d, uint8_t c, uint32_t n)
+{
+	while (n--) {
+		*d++ = c;
+	}
+}
+
+/* Bytes per timebase tick, times 100 */
+static uint32_t bench_op(int op, uint32_t size, uint32_t dst_off, uint32_t src_off)
+{
+	uint8_t *d = bench_dst + dst_off;
+	uint8_t *s = bench_src + src_off;
+	uint32_t reps = BENCH_BYTES / size;
+	uint64_t t0 = 0, ticks;
+
+	for (uint32_t r = 0; r <= reps; r++) {
+		// The first round warms the caches and is not timed
+		if (r == 1) {
+			t0 = mftb();
+		}
+		switch (op) {
+		case OP_BYTE_COPY:
+			byte_copy(d, s, size);
+			break;
+		case OP_MEMCPY:
+			memcpy(d, s, size);
+			break;
+		case OP_MEMMOVE:
+			// Overlapping, one line up, so it copies backwards
+			memmove(d + 64, bench_dst + src_off, size);
+			break;
+		case OP_BYTE_SET:
+			byte_set(d, 0x5A, size);
+			break;
+		case OP_MEMSET:
+			memset(d, 0x5A, size);
+			break;
+		case OP_MEMSET_ZERO:
+			memset(d, 0, size);
+			break;
+		case OP_BULK_COPY:
+			// Through the A53 from MW_BULK_MIN_BYTES on, memcpy() below
+			bulk_copy(d, s, size);
+			break;
+		default:
+			bulk_zero(d, size);
+			break;
+		}
+	}
+	ticks = mftb() - t0;
+
+	return ticks ? (uint32_t)((uint64_t)reps * size * 100 / ticks) : 0;
+}
+
+void bench_memory(void)
+{
+	for (uint32_t i = 0; i < sizeof(bench_src); i++) {
+		bench_src[i] = (uint8_t)(i * 7 + 1);
+	}
+
+	my_printf("Memory, bytes per timebase tick (%d ticks/us):\n\r",
+		  (int)(TB_FREQ_HZ / 1000000UL));
+	my_printf("size  d/s");
+	for (int op = 0; op < OP_COUNT; op++) {
+		my_printf(" %s", op_name[op]);
+	}
+	my_printf("\n\r");
+
+	for (uint32_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+		for (uint32_t a = 0; a < sizeof(bench_align) / sizeof(bench_align[0]); a++) {
+			my_printf("%05d %d/%d", (int)bench_sizes[i], (int)bench_align[a].dst,
+				  (int)bench_align[a].src);
+			for (int op = 0; op < OP_COUNT; op++) {
+				uint32_t bpt = bench_op(op, bench_sizes[i], bench_align[a].dst,
+							bench_align[a].src);
+
+				my_printf(" %d.%02d", (int)(bpt / 100), (int)(bpt % 100));
+			}
+			my_printf("\n\r");
+		}
+	}
+}
+
+/*
+ * The formatter print.c had before, kept as the baseline: each number goes
+ * through itoa into a buffer, is reversed in place and then measured
+ * again by my_print(). %x reads a uint64_t.
+ */
+
+static print_out *legacy_out;
+
+static int legacy_strlen(const char *s)
+{
+	int i = 0;
+	while (s[i] != '\0') {
+		i++;
+	}
+	return i;
+}
+
+static void legacy_print(const char *str)
+{
+	legacy_out(str, legacy_strlen(str));
+}
+
+static void legacy_reverse(char *str)
+{
+	int i = 0;
+	int j = legacy_strlen(str) - 1;
+	char temp;
+
+	while (i < j) {
+		temp = str[i];
+		str[i] = str[j];
+		str[j] = temp;
+		i++;
+		j--;
+	}
+}
+
+static void legacy_itoa(int n, char *s, int min_len)
+{
+	int i = 0;
+	int is_negative = 0;
+
+	if (n == 0) {
+		s[i++] = '0';
+	} else if (n < 0) {
+		is_negative = 1;
+		n = -n;
+	}
+	while (n != 0) {
+		s[i++] = (n % 10) + '0';
+		n = n / 10;
+	}
+	while (i < min_len) {
+		s[i++] = '0';
+	}
+	if (is_negative) {
+		s[i++] = '-';
+	}
+	s[i] = '\0';
+	legacy_reverse(s);
+}
+
+static void legacy_uitoa_hex(uint64_t n, char *s, int min_len)
+{
+	int i = 0;
+	const char *hex_chars = "0123456789abcdef";
+
+	if (n == 0) {
+		s[i++] = '0';
+	}
+	while (n != 0) {
+		s[i++] = hex_chars[n % 16];
+		n = n / 16;
+	}
+	while (i < min_len) {
+		s[i++] = '0';
+	}
+	s[i] = '\0';
+	legacy_reverse(s);
+}
+
+static int legacy_printf(const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+
+	char buffer[21];
+	int count = 0;
+
+	for (int i = 0; format[i] != '\0'; i++) {
+		if (format[i] != '%') {
+			int start = i;
+			while (format[i + 1] != '\0' && format[i + 1] != '%') {
+				i++;
+			}
+			legacy_out(&format[start], i - start + 1);
+			count += i - start + 1;
+			continue;
+		}
+		i++;
+
+		int min_len = 0;
+		if (format[i] == '0') {
+			i++;
+		}
+		while (format[i] >= '0' && format[i] <= '9') {
+			min_len = min_len * 10 + (format[i] - '0');
+			i++;
+		}
+
+		switch (format[i]) {
+		case 'd':
+			legacy_itoa(va_arg(args, int), buffer, min_len);
+			legacy_print(buffer);
+			count += legacy_strlen(buffer);
+			break;
+		case 'x':
+			legacy_uitoa_hex(va_arg(args, uint64_t), buffer, min_len);
+			legacy_print(buffer);
+			count += legacy_strlen(buffer);
+			break;
+		case 'p':
+			legacy_print("0x");
+			count += 2;
+			legacy_uitoa_hex((uint64_t)va_arg(args, void *), buffer, 16);
+			legacy_print(buffer);
+			count += legacy_strlen(buffer);
+			break;
+		case 's': {
+			char *str = va_arg(args, char *);
+			legacy_print(str);
+			count += legacy_strlen(str);
+			break;
+		}
+		default:
+			legacy_print("%");
+			count++;
+			break;
+		}
+	}
+
+	va_end(args);
+	return count;
+}
+
+static uint32_t sink_bytes;
+
+static void sink_out(const char *buf, size_t len)
+{
+	(void)buf;
+	sink_bytes += len;
+}
+
+static int sink_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+static int sink_printf(const char *format, ...)
+{
+	va_list args;
+	int count;
+
+	va_start(args, format);
+	count = my_vprintf(sink_out, format, args);
+	va_end(args);
+	return count;
+}
+
+/* Lines like the firmware prints, the same text from both formatters */
+static __attribute__((noinline)) int printf_lines(bool legacy, uint64_t addr, int n)
+{
+	if (legacy) {
+		return legacy_printf("Executing: *(0x%08x) --> 0x%08x, DTB at 0x%08x.\n\r",
+				     addr, (uint64_t)0x48000100U, addr + 0x1F00000) +
+		       legacy_printf("Profile: %d samples every %d ticks at %p.\n\r",
+				     n, 10000, (void *)addr) +
+		       legacy_printf("%05d %d/%d %s %d.%02d\n\r", n, 7, -2, "memset 0",
+				     n / 100, n % 100);
+	}
+	return sink_printf("Executing: *(0x%08lx) --> 0x%08x, DTB at 0x%08lx.\n\r",
+			   addr, 0x48000100U, addr + 0x1F00000) +
+	       sink_printf("Profile: %d samples every %d ticks at %p.\n\r",
+			   n, 10000, (void *)addr) +
+	       sink_printf("%05d %d/%d %s %d.%02d\n\r", n, 7, -2, "memset 0",
+			   n / 100, n % 100);
+}
+
+/* Ticks per round of printf_lines() */
+static uint32_t bench_printf_one(bool legacy, uint32_t *bytes)
+{
+	uint64_t t0 = 0;
+
+	legacy_out = sink_out;
+	for (uint32_t r = 0; r <= BENCH_PRINTF_ROUNDS; r++) {
+		// The first round warms the caches and is not timed
+		if (r == 1) {
+			t0 = mftb();
+			sink_bytes = 0;
+		}
+		printf_lines(legacy, 0x30000000UL + r, (int)(r * 37));
+	}
+	*bytes = sink_bytes / BENCH_PRINTF_ROUNDS;
+	return (uint32_t)((mftb() - t0) / BENCH_PRINTF_ROUNDS);
+}
+
+void bench_printf(void)
+{
+	uint32_t bytes_old, bytes_new;
+	uint32_t t_old = bench_printf_one(true, &bytes_old);
+	uint32_t t_new = bench_printf_one(false, &bytes_new);
+
+	my_printf("printf, ticks for 3 lines of %u bytes: %u before, %u now.\n\r",
+		  bytes_new, t_old, t_new);
+	if (bytes_old != bytes_new) {
+		my_printf("printf: the formatters disagree (%u bytes before).\n\r", bytes_old);
+	}
+}
+
+
+#endif /* MW_BENCH */
@@ -0,0 +1,18 @@
+#ifndef __BENCH_H
+#define __BENCH_H
+
+/**
+ * @brief Times memcpy, memset (plain and zero) and memmove against byte
+ *        loops for a range of sizes and alignments, and prints bytes per
+ *        timebase tick. Built with MW_BENCH only.
+ */
+void bench_memory(void);
+
+/**
+ * @brief Times my_printf()'s formatter against the one it replaced on a few
+ *        typical lines, output discarded, and prints ticks per round.
+ *        Built with MW_BENCH only.
+ */
+void bench_printf(void);
+
+#endif /* __BENCH_H */
@@ -0,0 +1,79 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bulk.h"
+#include "io.h"
+#include "string.h"
+#include "mw_shared.h"
+
+#define LINE_SIZE	64U		/* L1 line, rtl/core.vhdl */
+
+static volatile mw_bulk *const bulk_box = (mw_bulk *)(MW_SHARED_BASE + MW_SHARED_BULK_OFFSET);
+
+/**
+ * @brief Posts one request and waits for the A53 to finish it. Every
+ *        mailbox access is cache-inhibited, since the A53 writes it behind
+ *        the data cache's back.
+ * @return 0 once done, or -1 if the A53 refused it or is not serving the
+ *         mailbox, and the caller has to do the job itself.
+ */
+static int bulk_request(uint32_t op, void *dst, const void *src, size_t len)
+{
+#ifdef MW_SIM
+	// The testbench memory has no A53 behind it
+	(void)op;
+	(void)dst;
+	(void)src;
+	(void)len;
+	return -1;
+#else
+	unsigned long box = (unsigned long)bulk_box;
+	uint32_t seq;
+
+	if (len < MW_BULK_MIN_BYTES ||
+	    (uintptr_t)dst + len > MW_LINUX_MEM_SIZE ||
+	    (uintptr_t)src + len > MW_LINUX_MEM_SIZE ||
+	    readl(box + offsetof(mw_bulk, magic)) != MW_BULK_MAGIC) {
+		return -1;
+	}
+
+	seq = readl(box + offsetof(mw_bulk, done)) + 1;
+	writel(op, box + offsetof(mw_bulk, op));
+	writeq((uintptr_t)dst, box + offsetof(mw_bulk, dst));
+	writeq((uintptr_t)src, box + offsetof(mw_bulk, src));
+	writeq(len, box + offsetof(mw_bulk, len));
+	writel(seq, box + offsetof(mw_bulk, seq));	// writel() orders the rest first
+
+	while (readl(box + offsetof(mw_bulk, done)) != seq) {
+		if (readl(box + offsetof(mw_bulk, magic)) != MW_BULK_MAGIC) {
+			return -1;	// Service stopped, maybe half way through
+		}
+	}
+	if ((int32_t)readl(box + offsetof(mw_bulk, status)) != 0) {
+		return -1;
+	}
+
+	// Drop whatever the cache held of dst; a write-through cache has
+	// nothing to write back, so dcbf costs no memory traffic here
+	for (uintptr_t p = (uintptr_t)dst & ~(uintptr_t)(LINE_SIZE - 1);
+	     p < (uintptr_t)dst + len; p += LINE_SIZE) {
+		__asm__ volatile("dcbf 0,%0" : : "r" (p) : "memory");
+	}
+	__asm__ volatile("sync" : : : "memory");
+	return 0;
+#endif
+}
+
+void bulk_zero(void *dst, size_t len)
+{
+	if (bulk_request(MW_BULK_OP_ZERO, dst, NULL, len) != 0) {
+		memset(dst, 0, len);
+	}
+}
+
+void bulk_copy(void *dst, const void *src, size_t len)
+{
+	if (bulk_request(MW_BULK_OP_COPY, dst, src, len) != 0) {
+		memcpy(dst, src, len);
+	}
+}
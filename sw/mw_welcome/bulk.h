@@ -0,0 +1,24 @@
+#ifndef __BULK_H
+#define __BULK_H
+
+#include <stddef.h>
+
+/*
+ * Large zero fills and copies, handed to the A53 through the mw_bulk
+ * mailbox of the shared area (mw_shared.h) when it serves one. Smaller
+ * jobs, and all of them without the mailbox, run here with memset() and
+ * memcpy().
+ */
+
+/**
+ * @brief Zeroes len bytes at dst, which must be DRAM below MW_LINUX_MEM_SIZE.
+ */
+void bulk_zero(void *dst, size_t len);
+
+/**
+ * @brief Copies len bytes from src to dst, both DRAM below MW_LINUX_MEM_SIZE.
+ *        The ranges must not overlap.
+ */
+void bulk_copy(void *dst, const void *src, size_t len);
+
+#endif /* __BULK_H */
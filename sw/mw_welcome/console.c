@@ -4,19 +4,48 @@
 #include "console.h"
 #include "microwatt_soc.h"
 #include "io.h"
+#include "irq.h"
+#include "mw_shared.h"
 
 // Helper macro for register access
 #define BASE_ADDR                   UART_BASE_ADDR
 #define READ_REG(offset)            readl(BASE_ADDR + offset)
 #define WRITE_REG(val, offset)      writeb(val, BASE_ADDR + offset)
+#define WRITE_REG32(val, offset)    writel(val, BASE_ADDR + offset)
+
+// Ring sizes, powers of two
+#define TX_RING_SIZE                4096
+#define RX_RING_SIZE                256
+
+// Free-running indices; the producer only moves head, the consumer only tail
+static uint8_t tx_ring[TX_RING_SIZE];
+static volatile uint32_t tx_head, tx_tail;
+static uint8_t rx_ring[RX_RING_SIZE];
+static volatile uint32_t rx_head, rx_tail;
+
+static bool irq_mode;   // Set by console_init(); polled I/O before that
+static bool tx_armed;   // TX-empty interrupt enabled, the handler owns the FIFO
+static uint32_t tx_trig_room;   // Free FIFO slots when TTRIG reads clear
+
+// Console ring in shared DRAM, drained by the A53, if it set one up.
+// mem_word holds the bytes of the doubleword mem_head points into, so
+// that the ring is written a doubleword, one bus beat, at a time.
+static volatile mw_console *mem_cons;
+static uint32_t mem_head;
+static uint32_t mem_tail;       // Last tail read; the ring has at least this much room
+static uint64_t mem_word;
 
 /**
  * Check if TX FIFO is full.
  * @return true if full, false otherwise.
  */
 bool uart_is_tx_fifo_full(void) {
+#ifdef MW_SIM
+    return false;  // The testbench never fills up, see uart_tx_room()
+#else
     uint32_t status = READ_REG(UART_CHANNEL_STS_OFFSET);
     return (status & UART_TX_FULL) != 0;
+#endif
 }
 
 /**
@@ -29,10 +58,149 @@ bool uart_is_rx_fifo_empty(void) {
 }
 
 /**
- * Transmit a single byte via UART (non-blocking, assumes space available).
- * Waits if TX FIFO is full.
+ * Read the channel status once and tell how many bytes surely fit in the
+ * TX FIFO: all of it when empty, the part above the trigger level while
+ * the level is below it, one byte when merely not full.
+ */
+static uint32_t uart_tx_room(void) {
+#ifdef MW_SIM
+    // The simulation testbench prints FIFO writes as they come, so the
+    // status read it answers with a constant is skipped
+    return UART_FIFO_DEPTH;
+#else
+    uint32_t status = READ_REG(UART_CHANNEL_STS_OFFSET);
+
+    if (status & UART_TX_EMPTY) {
+        return UART_FIFO_DEPTH;
+    }
+    if ((status & UART_TX_TRIG) == 0) {
+        if (tx_trig_room == 0) {
+            tx_trig_room = UART_FIFO_DEPTH - (READ_REG(UART_TX_TRIGGER_OFFSET) & 0x3F);
+        }
+        return tx_trig_room;
+    }
+    return (status & UART_TX_FULL) ? 0 : 1;
+#endif
+}
+
+/**
+ * Move bytes from the TX ring into the FIFO, in bursts sized by one status
+ * read each, until one of them runs out. Arms the TX-empty interrupt
+ * while bytes are left over, disarms it once the ring is drained. Runs
+ * with external interrupts off.
+ */
+static void tx_fill(void) {
+    while (tx_tail != tx_head) {
+        uint32_t room = uart_tx_room();
+
+        if (room == 0) {
+            break;
+        }
+        while (room > 0 && tx_tail != tx_head) {
+            WRITE_REG(tx_ring[tx_tail % TX_RING_SIZE], UART_TX_RX_FIFO_OFFSET);
+            tx_tail++;
+            room--;
+        }
+    }
+
+    if (tx_tail != tx_head) {
+        if (!tx_armed) {
+            WRITE_REG32(UART_IXR_TEMPTY, UART_INTRPT_STS_OFFSET);
+            WRITE_REG32(UART_IXR_TEMPTY, UART_INTRPT_EN_OFFSET);
+            tx_armed = true;
+        }
+    } else if (tx_armed) {
+        WRITE_REG32(UART_IXR_TEMPTY, UART_INTRPT_DIS_OFFSET);
+        tx_armed = false;
+    }
+}
+
+/**
+ * Start an idle transmitter on what is queued; an armed one gets there
+ * on its own.
+ */
+static void tx_kick(void) {
+    uint64_t msr = irq_save();
+
+    if (!tx_armed) {
+        tx_fill();
+    }
+    irq_restore(msr);
+}
+
+/**
+ * Store the doubleword of the console ring that holds byte 'pos'. The data
+ * cache is write-through, so this is one bus beat where byte stores would
+ * be eight.
+ */
+static inline void mem_cons_store(uint32_t pos) {
+    volatile uint64_t *data = (volatile uint64_t *)mem_cons->data;
+
+    data[(pos & (MW_CONSOLE_DATA_SIZE - 1)) / 8] = mem_word;
+}
+
+/**
+ * Room left in the console ring after the last tail read. One doubleword
+ * is kept free, since storing a partial one also writes the bytes after
+ * head.
+ */
+static inline uint32_t mem_cons_room(void) {
+    uint32_t used = mem_head - mem_tail;
+
+    return used < MW_CONSOLE_DATA_SIZE - 8 ? MW_CONSOLE_DATA_SIZE - 8 - used : 0;
+}
+
+/**
+ * Copy bytes into the shared-memory console ring, waiting only while it is
+ * full. Bytes are gathered into doublewords, and a partial last one is
+ * stored again once the next call completes it; the A53 reads no further
+ * than head. tail is only read, cache-inhibited because the A53 writes it
+ * behind the data cache's back, when the room seen last time runs out.
+ */
+static void mem_cons_write(const char *buf, size_t len) {
+    while (len > 0) {
+        uint32_t n = mem_cons_room();
+
+        if (n < len) {
+            mem_tail = readl((unsigned long)&mem_cons->tail);
+            n = mem_cons_room();
+            if (n == 0) {
+                continue;  // The A53 drains the ring
+            }
+        }
+        if (n > len) {
+            n = len;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t shift = (mem_head & 7) * 8;
+
+            mem_word = (mem_word & ~(0xFFULL << shift)) | ((uint64_t)(uint8_t)buf[i] << shift);
+            mem_head++;
+            if ((mem_head & 7) == 0) {
+                mem_cons_store(mem_head - 8);
+            }
+        }
+        if ((mem_head & 7) != 0) {
+            mem_cons_store(mem_head);
+        }
+        __asm__ volatile("sync" : : : "memory");  // Bytes before the index
+        mem_cons->head = mem_head;
+        buf += n;
+        len -= n;
+    }
+}
+
+/**
+ * Transmit a single byte via UART.
+ * Once the console runs on interrupts this is uart_write() of one byte.
+ * Before that it waits for FIFO space, one status read per byte.
  */
 void uart_transmit_byte(uint8_t data) {
+    if (irq_mode) {
+        uart_write((const char *)&data, 1);
+        return;
+    }
+
     // Wait until TX FIFO is not full
     while (uart_is_tx_fifo_full()) {
         // Busy wait
@@ -40,13 +208,168 @@ void uart_transmit_byte(uint8_t data) {
     WRITE_REG(data, UART_TX_RX_FIFO_OFFSET);
 }
 
+/**
+ * Transmit len bytes via UART.
+ * Once the console runs on interrupts the bytes are queued and this
+ * returns at once, unless the TX ring fills up. Before that the FIFO is
+ * filled directly, one status read per burst. With a shared-memory ring
+ * the bytes go there instead and the A53 prints them.
+ */
+void uart_write(const char *buf, size_t len) {
+    if (mem_cons != NULL) {
+        mem_cons_write(buf, len);
+        return;
+    }
+
+    if (!irq_mode) {
+        while (len > 0) {
+            uint32_t room = uart_tx_room();
+
+            while (room > 0 && len > 0) {
+                WRITE_REG((uint8_t)*buf++, UART_TX_RX_FIFO_OFFSET);
+                room--;
+                len--;
+            }
+        }
+        return;
+    }
+
+    while (len > 0) {
+        uint32_t n = TX_RING_SIZE - (tx_head - tx_tail);
+
+        if (n == 0) {
+            tx_kick();  // The interrupt handler drains the ring
+            continue;
+        }
+        if (n > len) {
+            n = len;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            tx_ring[(tx_head + i) % TX_RING_SIZE] = (uint8_t)buf[i];
+        }
+        __asm__ volatile("" : : : "memory");  // Bytes before the index
+        tx_head += n;
+        buf += n;
+        len -= n;
+    }
+    tx_kick();
+}
+
 /**
  * Receive a single byte via UART (non-blocking, returns 0 if empty).
  * @return Received byte if available, 0 otherwise.
  */
 uint8_t uart_receive_byte(void) {
-    if (uart_is_rx_fifo_empty()) {
-        return 0;  // No data available
+    uint8_t data;
+
+    if (!irq_mode) {
+        if (uart_is_rx_fifo_empty()) {
+            return 0;  // No data available
+        }
+        return (uint8_t)READ_REG(UART_TX_RX_FIFO_OFFSET);
+    }
+
+    if (rx_tail == rx_head) {
+        return 0;
+    }
+    data = rx_ring[rx_tail % RX_RING_SIZE];
+    rx_tail++;
+    return data;
+}
+
+/**
+ * UART interrupt: empty the RX FIFO into the RX ring and refill the TX
+ * FIFO from the TX ring. Bytes that find the RX ring full are dropped.
+ */
+void console_irq(void) {
+    uint32_t isr = READ_REG(UART_INTRPT_STS_OFFSET) & READ_REG(UART_INTRPT_MASK_OFFSET);
+
+    WRITE_REG32(isr, UART_INTRPT_STS_OFFSET);
+
+    if (isr & (UART_IXR_RTRIG | UART_IXR_TOUT)) {
+        while (!uart_is_rx_fifo_empty()) {
+            uint8_t data = (uint8_t)READ_REG(UART_TX_RX_FIFO_OFFSET);
+
+            if (rx_head - rx_tail < RX_RING_SIZE) {
+                rx_ring[rx_head % RX_RING_SIZE] = data;
+                __asm__ volatile("" : : : "memory");
+                rx_head++;
+            }
+        }
+        if (isr & UART_IXR_TOUT) {
+            WRITE_REG32(READ_REG(UART_CONTROL_OFFSET) | UART_RESTART_TIMEOUT, UART_CONTROL_OFFSET);
+        }
+    }
+
+    if (isr & UART_IXR_TEMPTY) {
+        tx_fill();
+    }
+}
+
+/**
+ * Switch the console to interrupt-driven, ring-buffered I/O on XICS
+ * source 0. RX interrupts fire at half a FIFO, or once the line has been
+ * idle for 40 bit times with bytes waiting. The TX trigger, which only
+ * sizes bursts, is set to half a FIFO too. Output goes to the A53's
+ * shared-memory ring instead when the bootloader has set one up.
+ */
+void console_init(void) {
+    volatile mw_console *mc = (volatile mw_console *)(MW_SHARED_BASE + MW_SHARED_CONSOLE_OFFSET);
+
+    WRITE_REG32(UART_IXR_ALL, UART_INTRPT_DIS_OFFSET);
+    WRITE_REG32(UART_IXR_ALL, UART_INTRPT_STS_OFFSET);
+    WRITE_REG32(UART_FIFO_DEPTH / 2, UART_RX_TRIGGER_OFFSET);
+    WRITE_REG32(10, UART_RX_TIMEOUT_OFFSET);
+    WRITE_REG32(UART_FIFO_DEPTH / 2, UART_TX_TRIGGER_OFFSET);
+    tx_trig_room = UART_FIFO_DEPTH / 2;
+    WRITE_REG32(READ_REG(UART_CONTROL_OFFSET) | UART_RESTART_TIMEOUT, UART_CONTROL_OFFSET);
+
+    tx_head = tx_tail = 0;
+    rx_head = rx_tail = 0;
+    tx_armed = false;
+    irq_mode = true;
+
+    if (readl((unsigned long)&mc->magic) == MW_CONSOLE_MAGIC &&
+        readl((unsigned long)&mc->size) == MW_CONSOLE_DATA_SIZE) {
+        mem_head = readl((unsigned long)&mc->head);
+        mem_tail = readl((unsigned long)&mc->tail);
+        mem_word = readq((unsigned long)&mc->data[mem_head & (MW_CONSOLE_DATA_SIZE - 8)]);
+        mem_cons = mc;
+    }
+
+    WRITE_REG32(UART_IXR_RTRIG | UART_IXR_TOUT, UART_INTRPT_EN_OFFSET);
+    irq_set_priority(XICS_SRC_UART0, 0);
+}
+
+/**
+ * Wait until everything queued has left the UART.
+ */
+void console_flush(void) {
+    while (mem_cons != NULL && readl((unsigned long)&mem_cons->tail) != mem_head) {
+        // The A53 drains the ring
+    }
+    while (tx_tail != tx_head) {
+        // The interrupt handler drains the ring
+    }
+    while ((READ_REG(UART_CHANNEL_STS_OFFSET) & UART_TX_EMPTY) == 0) {
+        // Busy wait
+    }
+}
+
+/**
+ * Flush the console and hand the UART back in polled mode, with its
+ * interrupts and MSR[EE] off, e.g. before jumping to a kernel.
+ */
+void console_shutdown(void) {
+    if (!irq_mode) {
+        return;
     }
-    return (uint8_t)READ_REG(UART_TX_RX_FIFO_OFFSET);
+    console_flush();
+    irq_save();
+    irq_set_priority(XICS_SRC_UART0, 7);
+    WRITE_REG32(UART_IXR_ALL, UART_INTRPT_DIS_OFFSET);
+    WRITE_REG32(UART_IXR_ALL, UART_INTRPT_STS_OFFSET);
+    irq_mode = false;
+    tx_armed = false;
+    mem_cons = NULL;
 }
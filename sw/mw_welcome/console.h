@@ -3,4 +3,11 @@
 bool uart_is_tx_fifo_full(void);
 bool uart_is_rx_fifo_empty(void);
 void uart_transmit_byte(uint8_t data);
+void uart_write(const char *buf, size_t len);
 uint8_t uart_receive_byte(void);
+#include "print.h"
+
+void console_init(void);
+void console_irq(void);
+void console_flush(void);
+void console_shutdown(void);
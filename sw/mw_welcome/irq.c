@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "irq.h"
+#include "console.h"
+#include "microwatt_soc.h"
+#include "io.h"
+#include "timebase.h"
+
+#define XICS_PRIO_MASKED	0xFF
+
+static void (*dec_handler)(uint64_t srr0);
+
+// XICS registers are big-endian
+static inline uint32_t xics_read(unsigned long addr)
+{
+	return __builtin_bswap32(readl(addr));
+}
+
+static inline void xics_write(uint32_t val, unsigned long addr)
+{
+	writel(__builtin_bswap32(val), addr);
+}
+
+void irq_set_priority(unsigned int src, uint8_t prio)
+{
+	xics_write(prio >= 7 ? XICS_PRIO_MASKED : prio, XICS_ICS_BASE + XICS_XIVE(src));
+}
+
+void irq_set_dec_handler(void (*fn)(uint64_t srr0))
+{
+	dec_handler = fn;
+}
+
+void irq_init(void)
+{
+	uint64_t msr;
+
+	mtdec(DEC_PARKED);
+	// CPPR is the top byte of XIRR; 0xFF lets every priority through
+	writeb(XICS_PRIO_MASKED, XICS_ICP_BASE + XICS_XIRR);
+
+	__asm__ volatile("mfmsr %0" : "=r" (msr));
+	irq_restore(msr | MSR_EE);
+}
+
+void irq_handler(uint64_t vector, uint64_t srr0)
+{
+	uint32_t xirr;
+
+	switch (vector) {
+	case 0x500:
+		// Reading XIRR accepts the interrupt; writing it back is the EOI
+		xirr = xics_read(XICS_ICP_BASE + XICS_XIRR);
+		switch ((int)(xirr & 0xFFFFFF) - XICS_IRQ_BASE) {
+		case XICS_SRC_UART0:
+			console_irq();
+			break;
+		default:
+			break;
+		}
+		xics_write(xirr, XICS_ICP_BASE + XICS_XIRR);
+		break;
+	case 0x900:
+		// Push the next one out of the way; a handler may bring it back
+		mtdec(DEC_PARKED);
+		if (dec_handler != NULL) {
+			dec_handler(srr0);
+		}
+		break;
+	default:
+		break;
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef __IRQ_H
+#define __IRQ_H
+
+#include <stdint.h>
+
+#define MSR_EE		0x8000UL
+
+/**
+ * @brief Sets the ICP to accept every priority, parks the decrementer and
+ *        turns on external interrupts (MSR[EE]).
+ */
+void irq_init(void);
+
+/**
+ * @brief Routes an ICS source to the CPU at the given priority (0 is the
+ *        most favoured, 7 masks it).
+ */
+void irq_set_priority(unsigned int src, uint8_t prio);
+
+/**
+ * @brief Called from the 0x500 and 0x900 vectors in head.S, with MSR[EE] off.
+ * @param srr0 Address of the interrupted instruction.
+ */
+void irq_handler(uint64_t vector, uint64_t srr0);
+
+/**
+ * @brief Hands decrementer interrupts to fn, called from irq_handler() once
+ *        the decrementer has been parked, with the interrupted address;
+ *        NULL goes back to just parking it.
+ */
+void irq_set_dec_handler(void (*fn)(uint64_t srr0));
+
+/**
+ * @brief Turns MSR[EE] off.
+ * @return The MSR to hand back to irq_restore().
+ */
+static inline uint64_t irq_save(void)
+{
+	uint64_t msr, tmp;
+
+	__asm__ volatile("mfmsr %0; andc %1,%0,%2; mtmsrd %1,1"
+			 : "=&r" (msr), "=&r" (tmp) : "r" (MSR_EE) : "memory");
+	return msr;
+}
+
+static inline void irq_restore(uint64_t msr)
+{
+	__asm__ volatile("mtmsrd %0,1" : : "r" (msr) : "memory");
+}
+
+#endif /* __IRQ_H */
@@ -6,6 +6,13 @@
  */
 
 #define DRAM_BASE                    0x00000000UL  /* "Main-memory/DRAM Base Address */
+#define DRAM_SIZE                    0x20000000UL  /* Up to the end of the shared area */
+
+// PS DRAM address of Microwatt address 0, as seen by PS bus masters (DMA)
+#define DRAM_PS_OFFSET               0x20000000UL
+
+// Timebase frequency (mftb ticks per second)
+#define TB_FREQ_HZ                   100000000UL
 
 /*
  * Zynq UltraScale+ UART subsystem:
@@ -18,6 +25,12 @@
 #define UART_CONTROL_OFFSET          0x00  // Control register
 #define UART_MODE_OFFSET             0x04  // Mode register (for baud rate, etc.)
 #define UART_INTRPT_EN_OFFSET        0x08  // Interrupt enable
+#define UART_INTRPT_DIS_OFFSET       0x0C  // Interrupt disable
+#define UART_INTRPT_MASK_OFFSET      0x10  // Interrupt mask (enabled sources)
+#define UART_INTRPT_STS_OFFSET       0x14  // Interrupt status, write 1 to clear
+#define UART_RX_TIMEOUT_OFFSET       0x1C  // RX timeout, in 4 bit periods
+#define UART_RX_TRIGGER_OFFSET       0x20  // RX FIFO trigger level
+#define UART_TX_TRIGGER_OFFSET       0x44  // TX FIFO trigger level
 #define UART_CHANNEL_STS_OFFSET      0x2C  // Channel status register
 #define UART_TX_RX_FIFO_OFFSET       0x30  // TX/RX FIFO data
 
@@ -26,9 +39,44 @@
 #define UART_RX_ENABLE               (1 << 2)  // RX path enable
 #define UART_TX_RESET                (1 << 1)  // TX FIFO reset (self-clearing)
 #define UART_RX_RESET                (1 << 0)  // RX FIFO reset (self-clearing)
+#define UART_RESTART_TIMEOUT         (1 << 7)  // Restart the RX timeout (self-clearing)
+
+// Interrupt Register Bits (enable, disable, mask and status)
+#define UART_IXR_RTRIG               (1 << 0)  // RX FIFO reached the trigger level
+#define UART_IXR_TEMPTY              (1 << 3)  // TX FIFO empty
+#define UART_IXR_TOUT                (1 << 8)  // RX timeout
+#define UART_IXR_ALL                 0x1FFF
+
+#define UART_FIFO_DEPTH              64
 
 // Channel Status Register Bits
 #define UART_TX_FULL                 (1 << 4)  // TFUL: TX FIFO full
 #define UART_RX_EMPTY                (1 << 1)  // REMPTY: RX FIFO empty
+#define UART_TX_EMPTY                (1 << 3)  // TEMPTY: TX FIFO empty
+#define UART_TX_TRIG                 (1 << 13) // TTRIG: TX FIFO level >= trigger
+
+/*
+ * XICS interrupt controller: presenter (ICP) and source (ICS) units
+ */
+#define XICS_ICP_BASE                0xC0004000UL
+#define XICS_ICS_BASE                0xC0005000UL
+
+#define XICS_XIRR                    0x04   // Read to accept, write to EOI
+#define XICS_XIVE(src)               (0x800 + 4 * (src))
+
+// ICS sources; the interrupt number is XICS_IRQ_BASE + source
+#define XICS_IRQ_BASE                16
+#define XICS_SRC_UART0               0
+#define XICS_SRC_ETH                 1
+#define XICS_SRC_SDCARD              3
+
+/*
+ * Zynq UltraScale+ SD controller (SD1, the card slot), interrupt on XICS
+ * source 3 (ext_irq_sdcard)
+ */
+#define SD_BASE_ADDR                 0xFF170000UL
+
+// SD reference clock, used when the capabilities register leaves it out
+#define SD_REF_CLK_HZ                187500000UL
 
 #endif /* __MICROWATT_SOC_H */
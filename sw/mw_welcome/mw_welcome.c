@@ -1,9 +1,20 @@
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 
+#include "io.h"
 #include "print.h"
 #include "console.h"
+#include "irq.h"
+#include "microwatt_soc.h"
+#include "sdhci.h"
+#include "timebase.h"
+#include "bench.h"
+#include "profile.h"
+#include "mw_shared.h"
 
+// Kernel entry when the A53 leaves no mw_boot_info, and where the firmware
+// puts the kernel it reads from the card itself
 #define	 KERNEL_ADDR	0x01700000UL
 
 static char mw_logo[] =
@@ -18,30 +29,171 @@ static char mw_logo[] =
 "    `ww'      \n\r"
 "\n\r\n\r";
 
-int main(void)
+#ifdef SD_KERNEL_SECTOR
+/**
+ * @brief Reads the raw kernel image from the SD card to KERNEL_ADDR, over
+ *        whatever the A53 put there.
+ * @return SD_OK or an SD_ERR_* code.
+ */
+static int sd_load_kernel(void)
 {
-	my_printf("%s", mw_logo);
-	my_printf("Function <my_printf> is located at 0x%08x.\n\r", &my_printf);
-	volatile uint32_t *prog = (volatile uint32_t *)KERNEL_ADDR;
-	my_printf("Executing: *(0x%08x) --> 0x%08x.\n\r", (uint32_t *)prog, *prog);
-	my_printf("Press any key to continue...");
-
-	// Receive loop example (pseudo-code, assuming incoming data)
-	while (true) {
-		uint8_t rx_data = uart_receive_byte();
-		if (rx_data != 0) {
-			// Process received data
-			my_printf("\n\r\n\r");
-			break;
-		}
+	sd_card card;
+	uint32_t sectors = ((uint32_t)SD_KERNEL_BYTES + SD_BLOCK_SIZE - 1) / SD_BLOCK_SIZE;
+	int ret;
+
+	ret = sd_card_init(&card, SD_BASE_ADDR);
+	if (ret != SD_OK) {
+		my_printf("SD: card init failed (%d).\n\r", ret);
+		return ret;
+	}
+	my_printf("SD: %d MB card, %d kHz%s.\n\r", (int)(card.sectors / 2048),
+		  (int)(card.clock_hz / 1000), card.high_speed ? " high speed" : "");
+
+	ret = sd_read(&card, SD_KERNEL_SECTOR, sectors, (void *)KERNEL_ADDR);
+	if (ret != SD_OK) {
+		my_printf("SD: reading %d sectors from %d failed (%d).\n\r", (int)sectors,
+			  (int)SD_KERNEL_SECTOR, ret);
+		return ret;
 	}
-	
+	my_printf("SD: loaded %d bytes to 0x%08lx.\n\r", (int)SD_KERNEL_BYTES,
+		  (uint64_t)KERNEL_ADDR);
+
+	return SD_OK;
+}
+#endif
+
+/**
+ * @brief Takes the kernel handoff from the boot-info block the A53 wrote,
+ *        or KERNEL_ADDR without a device tree, waiting for a key, if there
+ *        is none. The block is read cache-inhibited, since the A53 rewrites
+ *        it behind the data cache's back on every release.
+ */
+static void boot_info_read(mw_boot_info *bi)
+{
+	unsigned long src = MW_SHARED_BASE + MW_SHARED_BOOT_INFO_OFFSET;
+
+	bi->magic = MW_BOOT_INFO_MAGIC;
+	if (readl(src + offsetof(mw_boot_info, magic)) == MW_BOOT_INFO_MAGIC &&
+	    readq(src + offsetof(mw_boot_info, entry)) != 0) {
+		bi->flags = readl(src + offsetof(mw_boot_info, flags));
+		bi->entry = readq(src + offsetof(mw_boot_info, entry));
+		bi->dtb = readq(src + offsetof(mw_boot_info, dtb));
+	} else {
+		bi->flags = 0;
+		bi->entry = KERNEL_ADDR;
+		bi->dtb = 0;
+	}
+}
+
+/**
+ * @brief Enters the kernel with r3 = dtb, r4 = entry and r5 = 0, as the
+ *        powerpc boot wrapper expects, and r12 = entry for its ELFv2
+ *        global entry point.
+ */
+static void __attribute__((noreturn)) kernel_enter(uint64_t entry, uint64_t dtb)
+{
+	register uint64_t r3 __asm__("r3") = dtb;
+	register uint64_t r4 __asm__("r4") = entry;
+	register uint64_t r5 __asm__("r5") = 0;
+	register uint64_t r12 __asm__("r12") = entry;
+
 	__asm__ volatile(
-	    "lis    %%r12, %0@ha     \n\t"
-	    "mtctr  %%r12            \n\t"
-	    "bctrl                   \n\t"
+	    "mtctr  %3               \n\t"
+	    "bctr                    \n\t"
 	    :
-	    : "i"(KERNEL_ADDR)
-	    : "r12", "ctr"
+	    : "r"(r3), "r"(r4), "r"(r5), "r"(r12)
+	    : "ctr", "memory"
 	);
+	__builtin_unreachable();
+}
+
+#ifdef MW_BENCH
+// 64 bytes, one FIFO's worth
+static const char bench_line[] =
+	"Microwatt console benchmark: one full UART FIFO of text ......\n\r";
+
+/**
+ * @brief Times handing bench_line to the console, starting from an empty
+ *        FIFO so that the line rate does not come into it.
+ * @param burst Use uart_write() rather than uart_transmit_byte() per byte.
+ * @return Timebase ticks.
+ */
+static uint64_t bench_console_line(bool burst)
+{
+	uint64_t t0;
+
+	console_flush();
+	t0 = mftb();
+	if (burst) {
+		uart_write(bench_line, sizeof(bench_line) - 1);
+	} else {
+		for (size_t i = 0; i < sizeof(bench_line) - 1; i++) {
+			uart_transmit_byte(bench_line[i]);
+		}
+	}
+	return mftb() - t0;
+}
+#endif
+
+int main(void)
+{
+	mw_boot_info bi;
+#ifdef MW_BENCH
+	uint64_t t_byte, t_burst, t_queued;
+#endif
+
+	irq_init();
+#ifdef MW_PROFILE
+	profile_start(MW_PROFILE);
+#endif
+#ifdef MW_BENCH
+	t_byte = bench_console_line(false);
+	t_burst = bench_console_line(true);
+#endif
+	console_init();
+#ifdef MW_BENCH
+	t_queued = bench_console_line(true);
+	my_printf("Console, ticks for %d bytes: %d polled per byte, %d polled burst, "
+		  "%d queued (%d ticks/us).\n\r", (int)(sizeof(bench_line) - 1), (int)t_byte,
+		  (int)t_burst, (int)t_queued, (int)(TB_FREQ_HZ / 1000000UL));
+	bench_memory();
+	bench_printf();
+#endif
+
+	my_printf("%s", mw_logo);
+	boot_info_read(&bi);
+#ifdef SD_KERNEL_SECTOR
+	if (sd_load_kernel() != SD_OK) {
+		my_printf("SD: kernel load failed, booting what is in memory.\n\r");
+	} else {
+		bi.entry = KERNEL_ADDR;
+	}
+#endif
+	my_printf("Function <my_printf> is located at 0x%08lx.\n\r", (uintptr_t)&my_printf);
+	volatile uint32_t *prog = (volatile uint32_t *)bi.entry;
+	my_printf("Executing: *(0x%08lx) --> 0x%08x, DTB at 0x%08lx.\n\r", (uintptr_t)prog, *prog,
+		  bi.dtb);
+#ifdef MW_PROFILE
+	my_printf("Profile: %d samples every %d ticks at 0x%08lx.\n\r", (int)profile_stop(),
+		  (int)MW_PROFILE, (uint64_t)(MW_SHARED_BASE + MW_SHARED_PROFILE_OFFSET));
+#endif
+
+	if ((bi.flags & MW_BOOT_INFO_AUTOBOOT) == 0) {
+		my_printf("Press any key to continue...");
+
+		// Receive loop example (pseudo-code, assuming incoming data)
+		while (true) {
+			uint8_t rx_data = uart_receive_byte();
+			if (rx_data != 0) {
+				// Process received data
+				my_printf("\n\r\n\r");
+				break;
+			}
+		}
+	}
+
+	// The kernel takes over the UART and expects interrupts off
+	console_shutdown();
+
+	kernel_enter(bi.entry, bi.dtb);
 }
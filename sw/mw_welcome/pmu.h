@@ -0,0 +1,97 @@
+#ifndef __PMU_H
+#define __PMU_H
+
+#include <stdint.h>
+
+#include "timebase.h"
+
+/*
+ * Microwatt performance monitor (rtl/pmu.vhdl)
+ *
+ * PMC1-4 count the events MMCR1 selects, one byte per counter, PMC5
+ * completed instructions and PMC6 cycles. The counters are 32 bits wide
+ * and start frozen (MMCR0[FC]).
+ */
+
+#define SPR_MMCR2		785
+#define SPR_MMCRA		786
+#define SPR_PMC1		787
+#define SPR_PMC2		788
+#define SPR_PMC3		789
+#define SPR_PMC4		790
+#define SPR_PMC5		791
+#define SPR_PMC6		792
+#define SPR_MMCR0		795
+#define SPR_MMCR1		798
+
+/* MMCR0 */
+#define MMCR0_FC		0x80000000UL	/* Freeze all counters */
+#define MMCR0_CC56RUN		0x00000100UL	/* PMC5/6 count with CTRL[RUN] clear too */
+
+/* MMCR1 event selectors, PMC1 in the top byte */
+#define MMCR1_PMC1_LD_COMPLETE	0xFCUL
+#define MMCR1_PMC2_DC_MISS	0xFEUL		/* Data cache misses resolved */
+#define MMCR1_PMC3_DC_ST_MISS	0xF0UL
+#define MMCR1_PMC4_BR_MISPRED	0xF6UL
+#define MMCR1_EVENTS		((MMCR1_PMC1_LD_COMPLETE << 24) | \
+				 (MMCR1_PMC2_DC_MISS << 16) | \
+				 (MMCR1_PMC3_DC_ST_MISS << 8) | \
+				 MMCR1_PMC4_BR_MISPRED)
+
+#define __stringify_1(x)	#x
+#define __stringify(x)		__stringify_1(x)
+
+#define mfspr(rn) ({ uint64_t __v; \
+	__asm__ volatile("mfspr %0," __stringify(rn) : "=r" (__v)); __v; })
+#define mtspr(rn, v) \
+	__asm__ volatile("mtspr " __stringify(rn) ",%0" : : "r" ((uint64_t)(v)) : "memory")
+
+enum { PMU_LOADS, PMU_DC_MISSES, PMU_DC_ST_MISSES, PMU_BR_MISPREDICTS,
+       PMU_INSNS, PMU_CYCLES, PMU_COUNTERS };
+
+typedef struct {
+	uint64_t tb;
+	uint32_t pmc[PMU_COUNTERS];
+} pmu_sample;
+
+/**
+ * @brief Selects the MMCR1_EVENTS, clears the counters and lets them run.
+ */
+static inline void pmu_init(void)
+{
+	mtspr(SPR_MMCR0, MMCR0_FC);
+	mtspr(SPR_MMCR1, MMCR1_EVENTS);
+	mtspr(SPR_MMCR2, 0);
+	mtspr(SPR_MMCRA, 0);
+	mtspr(SPR_PMC1, 0);
+	mtspr(SPR_PMC2, 0);
+	mtspr(SPR_PMC3, 0);
+	mtspr(SPR_PMC4, 0);
+	mtspr(SPR_PMC5, 0);
+	mtspr(SPR_PMC6, 0);
+	mtspr(SPR_MMCR0, MMCR0_CC56RUN);
+}
+
+static inline void pmu_read(pmu_sample *s)
+{
+	s->tb = mftb();
+	s->pmc[PMU_LOADS] = (uint32_t)mfspr(SPR_PMC1);
+	s->pmc[PMU_DC_MISSES] = (uint32_t)mfspr(SPR_PMC2);
+	s->pmc[PMU_DC_ST_MISSES] = (uint32_t)mfspr(SPR_PMC3);
+	s->pmc[PMU_BR_MISPREDICTS] = (uint32_t)mfspr(SPR_PMC4);
+	s->pmc[PMU_INSNS] = (uint32_t)mfspr(SPR_PMC5);
+	s->pmc[PMU_CYCLES] = (uint32_t)mfspr(SPR_PMC6);
+}
+
+/**
+ * @brief Turns end into the difference end - start, counter by counter.
+ */
+static inline void pmu_delta(pmu_sample *end, const pmu_sample *start)
+{
+	end->tb -= start->tb;
+	for (int i = 0; i < PMU_COUNTERS; i++) {
+		end->pmc[i] -= start->pmc[i];
+	}
+}
+
+#endif /* __PMU_H */
@@ -3,240 +3,236 @@
 #include <stdarg.h>
 #include <stdbool.h>
 
+#include "print.h"
 #include "console.h"
 
-/* ========================================================================= */
-/*                          PROVIDED PRINT FUNCTION                          */
-/* ========================================================================= */
-
-/**
- * @brief Prints a string to the serial console character by character.
- *
- * This function is provided and simulates writing to a serial port by interacting
- * with memory-mapped I/O registers. It waits for the transmit buffer to be
- * ready before sending each character.
- *
- * @param str The null-terminated string to be printed.
+/*
+ * Single-pass formatter: literal text goes out in runs up to the next '%',
+ * and each number is written backwards into a buffer on the stack, so
+ * that it is emitted with one call and no reversing or strlen() pass.
  */
-void my_print(const char *str)
-{
-	for (int i = 0; str[i] != '\0'; i++) {
-		char c = str[i];
-		uart_transmit_byte(c);
-	}
-}
 
+#define NUM_BUF		24	/* 20 decimal digits of a uint64_t, and a sign */
 
-/* ========================================================================= */
-/*                       HELPER FUNCTION IMPLEMENTATIONS                     */
-/* ========================================================================= */
+/* Padding comes from here, a chunk at a time */
+static const char pad_zeros[] = "0000000000000000";
+static const char pad_spaces[] = "                ";
 
-/**
- * @brief Calculates the length of a string.
- * @param s The null-terminated string.
- * @return The number of characters in the string, excluding the null terminator.
- */
-static int my_strlen(const char *s)
+static const char hex_lower[] = "0123456789abcdef";
+static const char hex_upper[] = "0123456789ABCDEF";
+
+static void emit_pad(print_out *out, bool zeros, int n)
 {
-	int i = 0;
-	while (s[i] != '\0') {
-		i++;
+	const char *pad = zeros ? pad_zeros : pad_spaces;
+
+	while (n > 0) {
+		int chunk = n < (int)sizeof(pad_zeros) - 1 ? n : (int)sizeof(pad_zeros) - 1;
+
+		out(pad, chunk);
+		n -= chunk;
 	}
-	return i;
 }
 
 /**
- * @brief Reverses a string in place.
- * @param str The null-terminated string to be reversed.
+ * @brief Writes the digits of v in front of end.
+ * @return The first digit.
  */
-static void str_reverse(char *str)
+static char *format_digits(char *end, uint64_t v, const char *hex)
 {
-	int i = 0;
-	int j = my_strlen(str) - 1;
-	char temp;
-
-	while (i < j) {
-		temp = str[i];
-		str[i] = str[j];
-		str[j] = temp;
-		i++;
-		j--;
+	char *p = end;
+
+	if (hex != NULL) {
+		do {
+			*--p = hex[v & 0xF];
+			v >>= 4;
+		} while (v != 0);
+	} else {
+		// Division by a constant, which the compiler turns into a multiply
+		do {
+			*--p = (char)('0' + v % 10);
+			v /= 10;
+		} while (v != 0);
 	}
+	return p;
 }
 
 /**
- * @brief Converts an integer to a null-terminated decimal string.
- * @param n The integer to convert.
- * @param s Buffer to store the resulting string.
- * @param min_len The minimum length of the output string, padded with leading zeros if necessary.
+ * @brief Emits one field: prefix (a sign or 0x), then body, padded to
+ *        width with spaces on the left or right, or with zeros between
+ *        the prefix and the body.
+ * @return Bytes written.
  */
-static void my_itoa(int n, char *s, int min_len)
+static int emit_field(print_out *out, const char *prefix, int prefix_len,
+		      const char *body, int body_len, int width, bool left, bool zeros)
 {
-	int i = 0;
-	int is_negative = 0;
-
-	if (n == 0) {
-		s[i++] = '0';
-	} else if (n < 0) {
-		is_negative = 1;
-		n = -n;
-	}
+	int pad = width - prefix_len - body_len;
 
-	while (n != 0) {
-		s[i++] = (n % 10) + '0';
-		n = n / 10;
+	if (pad < 0) {
+		pad = 0;
 	}
-
-	while (i < min_len) {
-		s[i++] = '0';
-	}
-
-	if (is_negative) {
-		s[i++] = '-';
+	if (pad > 0 && !left && !zeros) {
+		emit_pad(out, false, pad);
 	}
-
-	s[i] = '\0';
-	str_reverse(s);
-}
-
-/**
- * @brief Converts a 64-bit unsigned integer to a null-terminated hexadecimal string.
- * @param n The unsigned 64-bit integer to convert.
- * @param s Buffer to store the resulting string.
- * @param min_len The minimum length of the output string, padded with leading zeros if necessary.
- */
-static void my_uitoa_hex(uint64_t n, char *s, int min_len)
-{
-	int i = 0;
-	const char *hex_chars = "0123456789abcdef";
-
-	if (n == 0) {
-		s[i++] = '0';
+	if (prefix_len > 0) {
+		out(prefix, prefix_len);
 	}
-
-	while (n != 0) {
-		s[i++] = hex_chars[n % 16];
-		n = n / 16;
+	if (pad > 0 && zeros && !left) {
+		emit_pad(out, true, pad);
 	}
-
-	while (i < min_len) {
-		s[i++] = '0';
+	out(body, body_len);
+	if (pad > 0 && left) {
+		emit_pad(out, false, pad);
 	}
-
-	s[i] = '\0';
-	str_reverse(s);
+	return prefix_len + pad + body_len;
 }
 
-
-/* ========================================================================= */
-/*                       MAIN `my_printf` IMPLEMENTATION                     */
-/* ========================================================================= */
-
-/**
- * @brief Formats a string and prints it to the serial console.
- *
- * This function mimics the behavior of the standard C library's printf.
- * It supports the following format specifiers:
- * - %d: Signed decimal integer.
- * - %x: Unsigned hexadecimal integer (expects uint64_t).
- * - %p: Pointer address (printed as 16-digit zero-padded hex).
- * - %c: Character.
- * - %s: String.
- * - %%: A literal '%' character.
- * It also supports zero-padding for numbers (e.g., %02d, %016x).
- *
- * @param format The format string.
- * @param ... Variable arguments corresponding to the format specifiers.
- * @return The total number of characters printed.
- */
-int my_printf(const char *format, ...)
+int my_vprintf(print_out *out, const char *format, va_list args)
 {
-	va_list args;
-	va_start(args, format);
-
-	char buffer[21]; // Sufficient for 64-bit integer string + null terminator
-	int count = 0;   // Total characters printed
-
-	for (int i = 0; format[i] != '\0'; i++) {
-		if (format[i] != '%') {
-			char str[2] = {format[i], '\0'};
-			my_print(str);
-			count++;
+	char num[NUM_BUF];
+	char *end = num + sizeof(num);
+	const char *f = format;
+	int count = 0;
+
+	while (*f != '\0') {
+		const char *run = f;
+		bool left = false, zeros = false;
+		int width = 0;
+		int size = 0;	/* 0 int, 1 long, 2 long long */
+		const char *prefix = NULL;
+		int prefix_len = 0;
+		const char *body;
+		int body_len;
+		uint64_t v;
+
+		// The run of literal characters up to the next '%', at once
+		while (*f != '\0' && *f != '%') {
+			f++;
+		}
+		if (f != run) {
+			out(run, f - run);
+			count += f - run;
 			continue;
 		}
 
-		// Move past the '%'
-		i++;
-
-		// Check for zero-padding and width specifiers
-		int min_len = 0;
-		if (format[i] == '0') {
-			i++;
+		// Flags, width and length modifier after the '%'
+		f++;
+		for (;; f++) {
+			if (*f == '-') {
+				left = true;
+			} else if (*f == '0') {
+				zeros = true;
+			} else {
+				break;
+			}
 		}
-		while (format[i] >= '0' && format[i] <= '9') {
-			min_len = min_len * 10 + (format[i] - '0');
-			i++;
+		if (*f == '*') {
+			width = va_arg(args, int);
+			if (width < 0) {
+				left = true;
+				width = -width;
+			}
+			f++;
 		}
-
-		// Handle format specifiers
-		switch (format[i]) {
-			case 'd': {
-				int d = va_arg(args, int);
-				my_itoa(d, buffer, min_len);
-				my_print(buffer);
-				count += my_strlen(buffer);
-				break;
+		while (*f >= '0' && *f <= '9') {
+			width = width * 10 + (*f++ - '0');
+		}
+		if (*f == 'l') {
+			size = 1;
+			if (*++f == 'l') {
+				size = 2;
+				f++;
 			}
-			case 'x': {
-				// Assumes 'x' is for uint64_t as per the example
-				uint64_t x = va_arg(args, uint64_t);
-				my_uitoa_hex(x, buffer, min_len);
-				my_print(buffer);
-				count += my_strlen(buffer);
-				break;
+		} else if (*f == 'z') {
+			size = 1;
+			f++;
+		}
+
+		switch (*f) {
+		case 'd':
+		case 'i': {
+			int64_t d = size == 2 ? (int64_t)va_arg(args, long long) :
+				    size == 1 ? (int64_t)va_arg(args, long) :
+				    (int64_t)va_arg(args, int);
+
+			v = d < 0 ? -(uint64_t)d : (uint64_t)d;
+			if (d < 0) {
+				prefix = "-";
+				prefix_len = 1;
 			}
-			case 'p': {
-				uint64_t p = (uint64_t)va_arg(args, void *);
-				my_print("0x");
-				count += 2;
-				// Pointers are typically printed with full width
-				my_uitoa_hex(p, buffer, 16);
-				my_print(buffer);
-				count += my_strlen(buffer);
-				break;
+			body = format_digits(end, v, NULL);
+			break;
+		}
+		case 'u':
+		case 'x':
+		case 'X':
+			v = size == 2 ? (uint64_t)va_arg(args, unsigned long long) :
+			    size == 1 ? (uint64_t)va_arg(args, unsigned long) :
+			    (uint64_t)va_arg(args, unsigned int);
+			body = format_digits(end, v, *f == 'u' ? NULL : *f == 'x' ? hex_lower : hex_upper);
+			break;
+		case 'p': {
+			// Always 0x and all 16 digits
+			char *p = format_digits(end, (uintptr_t)va_arg(args, void *), hex_lower);
+
+			while (p > end - 16) {
+				*--p = '0';
 			}
-			case 'c': {
-				// char is promoted to int in va_arg
-				char c = (char)va_arg(args, int);
-				char str[2] = {c, '\0'};
-				my_print(str);
-				count++;
-				break;
+			body = p;
+			prefix = "0x";
+			prefix_len = 2;
+			break;
+		}
+		case 'c':
+			// char is promoted to int in va_arg
+			num[0] = (char)va_arg(args, int);
+			count += emit_field(out, NULL, 0, num, 1, width, left, false);
+			f++;
+			continue;
+		case 's': {
+			const char *s = va_arg(args, const char *);
+			const char *e;
+
+			if (s == NULL) {
+				s = "(null)";
 			}
-			case 's': {
-				char *s = va_arg(args, char *);
-				if (s == NULL) {
-					s = "(null)";
-				}
-				my_print(s);
-				count += my_strlen(s);
-				break;
+			for (e = s; *e != '\0'; e++) {
 			}
-			case '%': {
-				my_print("%");
+			count += emit_field(out, NULL, 0, s, e - s, width, left, false);
+			f++;
+			continue;
+		}
+		case '%':
+			out(f, 1);
+			count++;
+			f++;
+			continue;
+		default:
+			// Unknown specifier: print it literally
+			out("%", 1);
+			count++;
+			if (*f != '\0') {
+				out(f, 1);
 				count++;
-				break;
-			}
-			default: {
-				// If specifier is unknown, print it literally
-				my_print("%");
-				my_print(&format[i]);
-				count += 2;
-				break;
+				f++;
 			}
+			continue;
 		}
+
+		body_len = end - body;
+		count += emit_field(out, prefix, prefix_len, body, body_len, width, left, zeros);
+		f++;
 	}
 
+	return count;
+}
+
+int my_printf(const char *format, ...)
+{
+	va_list args;
+	int count;
+
+	va_start(args, format);
+	count = my_vprintf(uart_write, format, args);
 	va_end(args);
 	return count;
 }
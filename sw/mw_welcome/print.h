@@ -1 +1,24 @@
-int my_printf(const char *format, ...);
+#ifndef __PRINT_H
+#define __PRINT_H
+
+#include <stddef.h>
+#include <stdarg.h>
+
+/* Where formatted output goes, one run of bytes at a time */
+typedef void print_out(const char *buf, size_t len);
+
+/**
+ * @brief Formats like printf() into out. Supports %d, %i, %u, %x, %X, %c,
+ *        %s, %p and %%, the l, ll and z length modifiers, the '-' and '0'
+ *        flags and a field width, either digits or '*'. %p prints 0x and 16
+ *        hex digits.
+ * @return Bytes written.
+ */
+int my_vprintf(print_out *out, const char *format, va_list args);
+
+/**
+ * @brief my_vprintf() to the console.
+ */
+int my_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+#endif /* __PRINT_H */
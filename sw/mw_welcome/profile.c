@@ -0,0 +1,66 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#include "profile.h"
+#include "irq.h"
+#include "pmu.h"
+#include "timebase.h"
+#include "mw_shared.h"
+
+static mw_profile *const prof = (mw_profile *)(MW_SHARED_BASE + MW_SHARED_PROFILE_OFFSET);
+static uint32_t prof_period;
+
+// Decrementer interrupt: one sample, then rearm
+static void profile_tick(uint64_t srr0)
+{
+	uint32_t n = prof->count;
+
+	if (n < prof->capacity) {
+		mw_profile_sample *s = &prof->sample[n];
+
+		s->pc = srr0;
+		s->pmc[0] = (uint32_t)mfspr(SPR_PMC1);
+		s->pmc[1] = (uint32_t)mfspr(SPR_PMC2);
+		s->pmc[2] = (uint32_t)mfspr(SPR_PMC3);
+		s->pmc[3] = (uint32_t)mfspr(SPR_PMC4);
+		s->pmc[4] = (uint32_t)mfspr(SPR_PMC5);
+		s->pmc[5] = (uint32_t)mfspr(SPR_PMC6);
+		__asm__ volatile("sync" : : : "memory");  // The sample before the count
+		prof->count = n + 1;
+	} else {
+		prof->dropped++;
+	}
+	mtdec(prof_period);
+}
+
+void profile_start(uint32_t period)
+{
+	uint64_t msr = irq_save();
+
+	prof->magic = 0;
+	prof->period = period;
+	prof->capacity = MW_PROFILE_CAPACITY;
+	prof->count = 0;
+	prof->dropped = 0;
+	prof->reserved = 0;
+	prof->mmcr1 = MMCR1_EVENTS;
+	prof_period = period;
+	pmu_init();
+	__asm__ volatile("sync" : : : "memory");
+	prof->magic = MW_PROFILE_MAGIC;
+
+	irq_set_dec_handler(profile_tick);
+	mtdec(period);
+	irq_restore(msr);
+}
+
+uint32_t profile_stop(void)
+{
+	uint64_t msr = irq_save();
+
+	mtdec(DEC_PARKED);
+	irq_set_dec_handler(NULL);
+	irq_restore(msr);
+
+	return prof->count;
+}
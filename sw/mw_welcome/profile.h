@@ -0,0 +1,24 @@
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#include <stdint.h>
+
+/*
+ * Decrementer-driven PC sampling into the mw_profile block of the shared
+ * area (mw_shared.h). Each tick costs one interrupt and seven SPR reads.
+ */
+
+/**
+ * @brief Starts the PMU counters and takes a sample every period timebase
+ *        ticks from now on, over whatever was there before. Needs
+ *        irq_init() first.
+ */
+void profile_start(uint32_t period);
+
+/**
+ * @brief Stops sampling, leaving the samples for the A53 or a host to read.
+ * @return Samples taken.
+ */
+uint32_t profile_stop(void);
+
+#endif /* __PROFILE_H */
@@ -0,0 +1,107 @@
+#!/usr/bin/python3
+#
+# Flat profile from the firmware's sampling profiler (make MW_PROFILE=N)
+#
+#   profile.py mw_welcome.elf profile.bin
+#
+# profile.bin is the mw_profile block (mw_shared.h), MW_SHARED_PROFILE_SIZE
+# bytes from MW_SHARED_BASE + MW_SHARED_PROFILE_OFFSET, e.g. from Linux:
+#   dd if=/dev/mem of=profile.bin bs=4096 skip=$((0x1FFA0000 / 4096)) count=96
+# or from XSCT on the A53 side (PS DRAM address):
+#   mrd -bin -file profile.bin 0x3FFA0000 0x18000
+#
+# Every sample is charged to the function it interrupted, together with
+# the counter deltas since the sample before it.
+
+import sys
+import struct
+import bisect
+
+PROFILE_MAGIC = 0x4652504D
+HDR = struct.Struct('<IIIIIIQ')
+SAMPLE = struct.Struct('<Q6I')
+
+# MMCR1 byte per PMC1-4 -> event name, from rtl/pmu.vhdl
+EVENTS = [
+    {0xf0: 'cycles', 0xf2: 'insns', 0xfe: 'insns', 0xf4: 'fp', 0xf6: 'itlb miss',
+     0xf8: 'no insn', 0xfa: 'run cycles', 0xfc: 'loads'},
+    {0xf0: 'stores', 0xf2: 'dispatch', 0xf4: 'run cycles', 0xf6: 'dtlb miss',
+     0xf8: 'ext irq', 0xfa: 'br taken', 0xfc: 'icache miss', 0xfe: 'dc miss'},
+    {0xf0: 'dc st miss', 0xf2: 'dispatch', 0xf4: 'run insns', 0xf6: 'dc ld miss',
+     0xf8: 'tb event', 0xfe: 'dtlb miss'},
+    {0xf0: 'dc ld miss', 0xf2: 'dispatch', 0xf4: 'run cycles', 0xf6: 'mispredict',
+     0xf8: 'ipref drop', 0xfa: 'run insns', 0xfc: 'itlb miss', 0xfe: 'ld nocache'},
+]
+
+
+def read_symbols(path):
+    """Function symbols of a little-endian ELF64, sorted by address."""
+    with open(path, 'rb') as f:
+        elf = f.read()
+    if elf[:4] != b'\x7fELF' or elf[4] != 2 or elf[5] != 1:
+        raise Exception('%s is not a little-endian ELF64 file' % path)
+    shoff, = struct.unpack_from('<Q', elf, 0x28)
+    shentsize, shnum = struct.unpack_from('<HH', elf, 0x3a)
+    sections = [struct.unpack_from('<IIQQQQIIQQ', elf, shoff + i * shentsize)
+                for i in range(shnum)]
+
+    syms = {}
+    for sh in sections:
+        if sh[1] != 2:  # SHT_SYMTAB
+            continue
+        strtab = sections[sh[6]]
+        for off in range(sh[4], sh[4] + sh[5], sh[9]):
+            name, info, _, shndx, value, size = struct.unpack_from('<IBBHQQ', elf, off)
+            # STT_NOTYPE (assembly labels) or STT_FUNC, in a section
+            if (info & 0xf) not in (0, 2) or shndx == 0 or shndx >= 0xff00:
+                continue
+            start = strtab[4] + name
+            label = elf[start:elf.index(b'\0', start)].decode()
+            if label and not label.startswith(('.', '$')) and value not in syms:
+                syms[value] = label
+    addrs = sorted(syms)
+    return addrs, [syms[a] for a in addrs]
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('usage: %s <firmware.elf> <profile.bin>' % sys.argv[0])
+
+    addrs, names = read_symbols(sys.argv[1])
+    with open(sys.argv[2], 'rb') as f:
+        blob = f.read()
+
+    magic, period, capacity, count, dropped, _, mmcr1 = HDR.unpack_from(blob, 0)
+    if magic != PROFILE_MAGIC:
+        sys.exit('no profile in %s (magic 0x%08x)' % (sys.argv[2], magic))
+    count = min(count, capacity, (len(blob) - HDR.size) // SAMPLE.size)
+
+    events = [EVENTS[i].get((mmcr1 >> (24 - 8 * i)) & 0xff, 'pmc%d' % (i + 1))
+              for i in range(4)]
+    cols = ['cycles', 'insns', events[1], events[3]]
+
+    funcs = {}
+    prev = None
+    for i in range(count):
+        pc, *pmc = SAMPLE.unpack_from(blob, HDR.size + i * SAMPLE.size)
+        k = bisect.bisect_right(addrs, pc) - 1
+        name = names[k] if k >= 0 else '0x%x' % pc
+        f = funcs.setdefault(name, [0, 0, 0, 0, 0])
+        f[0] += 1
+        if prev is not None:
+            # PMC6, PMC5, PMC2, PMC4; 32-bit counters wrap
+            for j, c in enumerate((5, 4, 1, 3)):
+                f[1 + j] += (pmc[c] - prev[c]) & 0xffffffff
+        prev = pmc
+
+    print('%d samples every %d ticks, %d dropped' % (count, period, dropped))
+    print('%8s %6s %12s %12s %5s %10s %10s  %s' %
+          ('samples', '%', cols[0], cols[1], 'IPC', cols[2], cols[3], 'function'))
+    for name, f in sorted(funcs.items(), key=lambda kv: -kv[1][0]):
+        ipc = '%.2f' % (f[2] / f[1]) if f[1] else '-'
+        print('%8d %6.2f %12d %12d %5s %10d %10d  %s' %
+              (f[0], 100.0 * f[0] / count, f[1], f[2], ipc, f[3], f[4], name))
+
+
+if __name__ == '__main__':
+    main()
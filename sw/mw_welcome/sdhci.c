@@ -0,0 +1,417 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sdhci.h"
+#include "microwatt_soc.h"
+#include "io.h"
+#include "timebase.h"
+
+#define SD_CLK_INIT_HZ			400000UL
+#define SD_CLK_DEFAULT_HZ		25000000UL
+#define SD_CLK_HIGH_SPEED_HZ		50000000UL
+
+#define CACHE_LINE_SIZE			64UL
+
+typedef struct {
+	uint16_t attr;
+	uint16_t len;
+	uint32_t addr;
+} sdhci_adma2_desc;
+
+static sdhci_adma2_desc desc_table[SDHCI_DESC_LINES] __attribute__((aligned(8)));
+static uint8_t switch_status[64] __attribute__((aligned(CACHE_LINE_SIZE)));
+
+static void udelay(uint32_t us)
+{
+	uint64_t end = mftb() + (uint64_t)us * (TB_FREQ_HZ / 1000000UL);
+
+	while ((int64_t)(mftb() - end) < 0) {
+	}
+}
+
+/**
+ * @brief Waits until any bit of mask is set in a register (set = true) or
+ *        all of them are clear (set = false).
+ * @return The last value read, or 0 with *timed_out set.
+ */
+static uint32_t sdhci_wait(sd_card *card, unsigned long reg, uint32_t mask, bool set,
+			   uint32_t timeout_us, bool *timed_out)
+{
+	uint64_t end = mftb() + (uint64_t)timeout_us * (TB_FREQ_HZ / 1000000UL);
+	uint32_t val;
+
+	*timed_out = false;
+	for (;;) {
+		val = readl(card->base + reg);
+		if (set ? (val & mask) != 0 : (val & mask) == 0) {
+			return val;
+		}
+		if ((int64_t)(mftb() - end) >= 0) {
+			*timed_out = true;
+			return 0;
+		}
+	}
+}
+
+static int sdhci_reset(sd_card *card, uint32_t what)
+{
+	bool timed_out;
+
+	writel(readl(card->base + SDHCI_CLK_CTRL) | what, card->base + SDHCI_CLK_CTRL);
+	sdhci_wait(card, SDHCI_CLK_CTRL, what, false, 100000, &timed_out);
+
+	return timed_out ? SD_ERR_TIMEOUT : SD_OK;
+}
+
+/**
+ * @brief Sets the SD clock to the fastest rate not above hz, with the
+ *        10-bit divided clock mode of version 3.00 controllers.
+ */
+static int sdhci_set_clock(sd_card *card, uint32_t hz)
+{
+	unsigned long reg = card->base + SDHCI_CLK_CTRL;
+	uint32_t base_hz = ((readl(card->base + SDHCI_CAPS) >> 8) & 0xFFU) * 1000000UL;
+	uint32_t div = 0;
+	uint32_t val;
+	bool timed_out;
+
+	if (base_hz == 0) {
+		base_hz = SD_REF_CLK_HZ;
+	}
+	if (base_hz > hz) {
+		div = (base_hz + 2 * hz - 1) / (2 * hz);
+		if (div > 0x3FFU) {
+			div = 0x3FFU;
+		}
+	}
+
+	val = readl(reg) & ~0xFFFFU;
+	writel(val, reg);
+	val |= ((div & 0xFFU) << 8) | (((div >> 8) & 0x3U) << 6) | SDHCI_CC_INT_CLK_EN;
+	writel(val, reg);
+	sdhci_wait(card, SDHCI_CLK_CTRL, SDHCI_CC_INT_CLK_STABLE, true, 100000, &timed_out);
+	if (timed_out) {
+		return SD_ERR_TIMEOUT;
+	}
+	writel(val | SDHCI_CC_SD_CLK_EN, reg);
+
+	card->clock_hz = div ? base_hz / (2 * div) : base_hz;
+	return SD_OK;
+}
+
+/**
+ * @brief Clears the error, resets the command and data lines and maps the
+ *        status to a return code.
+ */
+static int sdhci_error(sd_card *card, uint32_t sts)
+{
+	writel(sts, card->base + SDHCI_INT_STS);
+	sdhci_reset(card, SDHCI_SWRST_CMD | SDHCI_SWRST_DAT);
+
+	if ((sts & SDHCI_INT_ERR_MASK) == SDHCI_INT_ERR_CMD_TIMEOUT) {
+		return SD_ERR_TIMEOUT;
+	}
+	return (sts & SDHCI_INT_ERR_DATA_MASK) != 0 ? SD_ERR_DATA : SD_ERR_CMD;
+}
+
+/**
+ * @brief Waits for transfer complete, which ends a data command or the
+ *        busy phase of an R1b response.
+ */
+static int sdhci_wait_xfer(sd_card *card, uint32_t timeout_us)
+{
+	uint32_t sts;
+	bool timed_out;
+
+	sts = sdhci_wait(card, SDHCI_INT_STS, SDHCI_INT_TC | SDHCI_INT_ERR, true, timeout_us,
+			 &timed_out);
+	if (timed_out) {
+		sdhci_reset(card, SDHCI_SWRST_CMD | SDHCI_SWRST_DAT);
+		return SD_ERR_TIMEOUT;
+	}
+	if (sts & SDHCI_INT_ERR) {
+		return sdhci_error(card, sts);
+	}
+	writel(SDHCI_INT_TC, card->base + SDHCI_INT_STS);
+
+	return SD_OK;
+}
+
+/**
+ * @brief Issues a command and waits for its response; for R1b also for the
+ *        end of busy. Data commands leave the transfer to the caller.
+ * @param flags SDHCI_RESP_* ORed with SDHCI_DAT_PRESENT.
+ * @param mode  Transfer mode bits for data commands.
+ */
+static int sdhci_cmd(sd_card *card, uint32_t idx, uint32_t arg, uint32_t flags, uint32_t mode)
+{
+	uint32_t inhibit = SDHCI_PSR_INHIBIT_CMD;
+	uint32_t sts;
+	bool timed_out;
+
+	if ((flags & SDHCI_DAT_PRESENT) || flags == SDHCI_RESP_R1B) {
+		inhibit |= SDHCI_PSR_INHIBIT_DAT;
+	}
+	sdhci_wait(card, SDHCI_PRES_STATE, inhibit, false, 100000, &timed_out);
+	if (timed_out) {
+		return SD_ERR_TIMEOUT;
+	}
+
+	writel(0xFFFFFFFFU, card->base + SDHCI_INT_STS);
+	writel(arg, card->base + SDHCI_ARGMT);
+	writel(mode | (((idx << 8) | flags) << 16), card->base + SDHCI_XFER_MODE);
+
+	sts = sdhci_wait(card, SDHCI_INT_STS, SDHCI_INT_CC | SDHCI_INT_ERR, true, 100000,
+			 &timed_out);
+	if (timed_out) {
+		sdhci_reset(card, SDHCI_SWRST_CMD | SDHCI_SWRST_DAT);
+		return SD_ERR_TIMEOUT;
+	}
+	if (sts & SDHCI_INT_ERR) {
+		return sdhci_error(card, sts);
+	}
+	writel(SDHCI_INT_CC, card->base + SDHCI_INT_STS);
+
+	if (flags == SDHCI_RESP_R1B) {
+		return sdhci_wait_xfer(card, 500000);
+	}
+	return SD_OK;
+}
+
+static int sdhci_app_cmd(sd_card *card, uint32_t idx, uint32_t arg, uint32_t flags)
+{
+	int ret = sdhci_cmd(card, 55, card->rca, SDHCI_RESP_R1, 0);
+
+	if (ret != SD_OK) {
+		return ret;
+	}
+	return sdhci_cmd(card, idx, arg, flags, 0);
+}
+
+/**
+ * @brief Reads blocks of a data command into buf through the ADMA2 engine,
+ *        then drops the stale lines of buf from the data cache.
+ */
+static int sdhci_read_blocks(sd_card *card, uint32_t idx, uint32_t arg, uint32_t blk_size,
+			     uint32_t blocks, void *buf)
+{
+	unsigned long addr = (unsigned long)buf;
+	unsigned long bytes = (unsigned long)blk_size * blocks;
+	unsigned long left = bytes;
+	uint32_t mode = SDHCI_TM_DMA_EN | SDHCI_TM_BLK_CNT_EN | SDHCI_TM_DAT_DIR_READ;
+	uint32_t i = 0;
+	int ret;
+
+	if ((addr & 0x3U) != 0 || addr + bytes > DRAM_SIZE ||
+	    bytes > (unsigned long)SDHCI_DESC_LINES * SDHCI_DESC_MAX_BYTES) {
+		return SD_ERR_ARG;
+	}
+
+	while (left > 0) {
+		uint32_t len = left < SDHCI_DESC_MAX_BYTES ? left : SDHCI_DESC_MAX_BYTES;
+
+		desc_table[i].attr = SDHCI_DESC_VALID | SDHCI_DESC_TRAN;
+		desc_table[i].len = len;
+		desc_table[i].addr = addr + (bytes - left) + DRAM_PS_OFFSET;
+		left -= len;
+		i++;
+	}
+	desc_table[i - 1].attr |= SDHCI_DESC_END;
+
+	// The table is in write-through cached memory; the sync in writel orders it
+	writel((unsigned long)desc_table + DRAM_PS_OFFSET, card->base + SDHCI_ADMA_SAR);
+	writel(blk_size | (blocks << 16), card->base + SDHCI_BLK_SIZE);
+	if (blocks > 1) {
+		mode |= SDHCI_TM_MUL_SIN_BLK | SDHCI_TM_AUTO_CMD12;
+	}
+
+	ret = sdhci_cmd(card, idx, arg, SDHCI_RESP_R1 | SDHCI_DAT_PRESENT, mode);
+	if (ret == SD_OK) {
+		// Allow for 1MB/s, a tenth of the slowest bus mode
+		ret = sdhci_wait_xfer(card, 100000 + bytes);
+	}
+
+	for (unsigned long p = addr & ~(CACHE_LINE_SIZE - 1); p < addr + bytes;
+	     p += CACHE_LINE_SIZE) {
+		__asm__ volatile("dcbf 0,%0" : : "r" (p) : "memory");
+	}
+	__asm__ volatile("sync" : : : "memory");
+
+	return ret;
+}
+
+/* Bit start..start+len-1 of a CSD whose CRC byte the controller dropped */
+static uint32_t csd_bits(const uint32_t *resp, uint32_t start, uint32_t len)
+{
+	uint32_t val = 0;
+
+	for (uint32_t i = 0; i < len; i++) {
+		uint32_t bit = start - 8 + i;
+
+		val |= ((resp[bit / 32] >> (bit % 32)) & 1U) << i;
+	}
+	return val;
+}
+
+static uint32_t csd_sectors(const uint32_t *resp)
+{
+	if (csd_bits(resp, 126, 2) == 1) {
+		return (csd_bits(resp, 48, 22) + 1) * 1024U;
+	}
+
+	// CSD version 1.0: (C_SIZE + 1) << (C_SIZE_MULT + 2 + READ_BL_LEN) bytes
+	return (csd_bits(resp, 62, 12) + 1) <<
+	       (csd_bits(resp, 47, 3) + 2 + csd_bits(resp, 80, 4) - 9);
+}
+
+/**
+ * @brief Switches the card to high-speed timing with CMD6 and follows with
+ *        the host. Cards that refuse stay at the default 25MHz.
+ */
+static void sd_high_speed(sd_card *card)
+{
+	// Byte 16, bits 379:376, holds the function group 1 result
+	if (sdhci_read_blocks(card, 6, 0x80FFFFF1U, sizeof(switch_status), 1,
+			      switch_status) != SD_OK ||
+	    (switch_status[16] & 0x0FU) != 1) {
+		return;
+	}
+
+	writel(readl(card->base + SDHCI_HOST_CTRL1) | SDHCI_HC_HIGH_SPEED,
+	       card->base + SDHCI_HOST_CTRL1);
+	if (sdhci_set_clock(card, SD_CLK_HIGH_SPEED_HZ) == SD_OK) {
+		card->high_speed = true;
+	}
+}
+
+int sd_card_init(sd_card *card, unsigned long base)
+{
+	uint32_t resp[4];
+	uint32_t ocr;
+	uint64_t end;
+	bool v2 = true;
+	bool timed_out;
+	int ret;
+
+	card->base = base;
+	card->rca = 0;
+	card->sectors = 0;
+	card->hcs = false;
+	card->high_speed = false;
+
+	ret = sdhci_reset(card, SDHCI_SWRST_ALL);
+	if (ret != SD_OK) {
+		return ret;
+	}
+	sdhci_wait(card, SDHCI_PRES_STATE, SDHCI_PSR_CARD_INSRT, true, 100000, &timed_out);
+	if (timed_out) {
+		return SD_ERR_CARD;
+	}
+
+	writel(SDHCI_PC_BUS_ON_3V3 | SDHCI_HC_DMA_ADMA2_32, base + SDHCI_HOST_CTRL1);
+	writel(SDHCI_TC_MAX, base + SDHCI_CLK_CTRL);
+	ret = sdhci_set_clock(card, SD_CLK_INIT_HZ);
+	if (ret != SD_OK) {
+		return ret;
+	}
+	// Polled; an interrupt-driven caller would enable XICS source 3 here
+	writel(0xFFFFFFFFU, base + SDHCI_INT_STS_EN);
+	writel(0, base + SDHCI_INT_SIG_EN);
+	udelay(1000);	// Power ramp and 74 initialisation clocks
+
+	sdhci_cmd(card, 0, 0, SDHCI_RESP_NONE, 0);
+
+	ret = sdhci_cmd(card, 8, 0x1AA, SDHCI_RESP_R1, 0);
+	if (ret == SD_ERR_TIMEOUT) {
+		v2 = false;	// Version 1.x card
+	} else if (ret != SD_OK) {
+		return ret;
+	} else if ((readl(base + SDHCI_RESP0) & 0xFFFU) != 0x1AA) {
+		return SD_ERR_CARD;
+	}
+
+	end = mftb() + TB_FREQ_HZ;	// The card has a second to power up
+	for (;;) {
+		ret = sdhci_app_cmd(card, 41, 0x00FF8000U | (v2 ? (1U << 30) : 0), SDHCI_RESP_R3);
+		if (ret != SD_OK) {
+			return ret;
+		}
+		ocr = readl(base + SDHCI_RESP0);
+		if (ocr & (1U << 31)) {
+			break;
+		}
+		if ((int64_t)(mftb() - end) >= 0) {
+			return SD_ERR_TIMEOUT;
+		}
+		udelay(10000);
+	}
+	card->hcs = (ocr & (1U << 30)) != 0;
+
+	ret = sdhci_cmd(card, 2, 0, SDHCI_RESP_R2, 0);
+	if (ret == SD_OK) {
+		ret = sdhci_cmd(card, 3, 0, SDHCI_RESP_R1, 0);
+	}
+	if (ret != SD_OK) {
+		return ret;
+	}
+	card->rca = readl(base + SDHCI_RESP0) & 0xFFFF0000U;
+
+	ret = sdhci_cmd(card, 9, card->rca, SDHCI_RESP_R2, 0);
+	if (ret != SD_OK) {
+		return ret;
+	}
+	for (int i = 0; i < 4; i++) {
+		resp[i] = readl(base + SDHCI_RESP0 + 4 * i);
+	}
+	card->sectors = csd_sectors(resp);
+
+	ret = sdhci_cmd(card, 7, card->rca, SDHCI_RESP_R1B, 0);
+	if (ret == SD_OK) {
+		ret = sdhci_app_cmd(card, 6, 2, SDHCI_RESP_R1);	// 4-bit bus
+	}
+	if (ret != SD_OK) {
+		return ret;
+	}
+	writel(readl(base + SDHCI_HOST_CTRL1) | SDHCI_HC_WIDTH_4, base + SDHCI_HOST_CTRL1);
+
+	if (!card->hcs) {
+		ret = sdhci_cmd(card, 16, SD_BLOCK_SIZE, SDHCI_RESP_R1, 0);
+		if (ret != SD_OK) {
+			return ret;
+		}
+	}
+
+	ret = sdhci_set_clock(card, SD_CLK_DEFAULT_HZ);
+	if (ret != SD_OK) {
+		return ret;
+	}
+	sd_high_speed(card);
+
+	return SD_OK;
+}
+
+int sd_read(sd_card *card, uint32_t sector, uint32_t count, void *buf)
+{
+	const uint32_t max_blocks = SDHCI_DESC_LINES * (SDHCI_DESC_MAX_BYTES / SD_BLOCK_SIZE);
+	uint8_t *dst = buf;
+
+	if (sector + count < sector || sector + count > card->sectors) {
+		return SD_ERR_ARG;
+	}
+
+	while (count > 0) {
+		uint32_t blocks = count < max_blocks ? count : max_blocks;
+		uint32_t arg = card->hcs ? sector : sector * SD_BLOCK_SIZE;
+		int ret;
+
+		ret = sdhci_read_blocks(card, blocks > 1 ? 18 : 17, arg, SD_BLOCK_SIZE, blocks, dst);
+		if (ret != SD_OK) {
+			return ret;
+		}
+		sector += blocks;
+		count -= blocks;
+		dst += blocks * SD_BLOCK_SIZE;
+	}
+
+	return SD_OK;
+}
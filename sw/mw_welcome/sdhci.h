@@ -0,0 +1,120 @@
+#ifndef __SDHCI_H
+#define __SDHCI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Polled SDHCI/ADMA2 driver for the ZynqMP SD controller, run from Microwatt
+ *
+ * The controller is reached through the PS at its A53 address. Its ADMA2
+ * engine masters PS DRAM directly, so buffers are given to it at
+ * DRAM_PS_OFFSET + their Microwatt address, and their cache lines are
+ * flushed once the data has landed. The card is brought up from scratch
+ * (CMD0 onwards), so it does not depend on what the A53 left behind.
+ */
+
+/* Register offsets (SD Host Controller Simplified Specification 3.00) */
+#define SDHCI_ARGMT2			0x00
+#define SDHCI_BLK_SIZE			0x04	/* Block size, block count << 16 */
+#define SDHCI_ARGMT			0x08
+#define SDHCI_XFER_MODE			0x0C	/* Transfer mode, command << 16 */
+#define SDHCI_RESP0			0x10
+#define SDHCI_PRES_STATE		0x24
+#define SDHCI_HOST_CTRL1		0x28	/* Host control, power << 8 */
+#define SDHCI_CLK_CTRL			0x2C	/* Clock, timeout << 16, reset << 24 */
+#define SDHCI_INT_STS			0x30	/* Normal status, error status << 16 */
+#define SDHCI_INT_STS_EN		0x34
+#define SDHCI_INT_SIG_EN		0x38
+#define SDHCI_CAPS			0x40
+#define SDHCI_ADMA_SAR			0x58
+#define SDHCI_HOST_VERSION		0xFC	/* Spec version in bits 23:16 */
+
+/* SDHCI_PRES_STATE */
+#define SDHCI_PSR_INHIBIT_CMD		(1U << 0)
+#define SDHCI_PSR_INHIBIT_DAT		(1U << 1)
+#define SDHCI_PSR_CARD_INSRT		(1U << 16)
+
+/* SDHCI_HOST_CTRL1 */
+#define SDHCI_HC_WIDTH_4		(1U << 1)
+#define SDHCI_HC_HIGH_SPEED		(1U << 2)
+#define SDHCI_HC_DMA_ADMA2_32		(2U << 3)
+#define SDHCI_PC_BUS_ON_3V3		(0x0FU << 8)
+
+/* SDHCI_CLK_CTRL */
+#define SDHCI_CC_INT_CLK_EN		(1U << 0)
+#define SDHCI_CC_INT_CLK_STABLE		(1U << 1)
+#define SDHCI_CC_SD_CLK_EN		(1U << 2)
+#define SDHCI_TC_MAX			(0x0EU << 16)
+#define SDHCI_SWRST_ALL			(1U << 24)
+#define SDHCI_SWRST_CMD			(1U << 25)
+#define SDHCI_SWRST_DAT			(1U << 26)
+
+/* SDHCI_INT_STS */
+#define SDHCI_INT_CC			(1U << 0)	/* Command complete */
+#define SDHCI_INT_TC			(1U << 1)	/* Transfer complete */
+#define SDHCI_INT_ERR			(1U << 15)
+#define SDHCI_INT_ERR_MASK		0xFFFF0000U
+#define SDHCI_INT_ERR_CMD_TIMEOUT	(1U << 16)
+#define SDHCI_INT_ERR_DATA_MASK		0x03700000U	/* Data timeout/CRC/end bit, Auto CMD, ADMA */
+
+/* Transfer mode */
+#define SDHCI_TM_DMA_EN			(1U << 0)
+#define SDHCI_TM_BLK_CNT_EN		(1U << 1)
+#define SDHCI_TM_AUTO_CMD12		(1U << 2)
+#define SDHCI_TM_DAT_DIR_READ		(1U << 4)
+#define SDHCI_TM_MUL_SIN_BLK		(1U << 5)
+
+/* Command register: response type, checks, data present */
+#define SDHCI_RESP_NONE			0x00U
+#define SDHCI_RESP_R2			0x09U	/* 136 bits, CRC checked */
+#define SDHCI_RESP_R3			0x02U	/* 48 bits, no checks */
+#define SDHCI_RESP_R1			0x1AU	/* 48 bits, CRC and index checked */
+#define SDHCI_RESP_R1B			0x1BU	/* R1 with busy */
+#define SDHCI_DAT_PRESENT		0x20U
+
+/* ADMA2 32-bit descriptor attributes */
+#define SDHCI_DESC_VALID		(1U << 0)
+#define SDHCI_DESC_END			(1U << 1)
+#define SDHCI_DESC_TRAN			(2U << 4)
+
+#define SDHCI_DESC_MAX_BYTES		0x8000U		/* 32KB, 64 sectors */
+#define SDHCI_DESC_LINES		64U		/* 2MB per command */
+
+#define SD_BLOCK_SIZE			512U
+
+/* Return codes */
+#define SD_OK				0
+#define SD_ERR_TIMEOUT			(-1)
+#define SD_ERR_CMD			(-2)	/* Command or response error */
+#define SD_ERR_DATA			(-3)	/* Data CRC, timeout or ADMA error */
+#define SD_ERR_CARD			(-4)	/* No card, or not one we can drive */
+#define SD_ERR_ARG			(-5)	/* Buffer not DMA-able, range past the card */
+
+typedef struct {
+	unsigned long base;		/* Controller base address */
+	uint32_t rca;			/* Relative card address << 16 */
+	uint32_t sectors;		/* Card capacity */
+	uint32_t clock_hz;		/* SD clock in use */
+	bool hcs;			/* Block addressed (SDHC/SDXC) */
+	bool high_speed;		/* 50MHz high-speed timing */
+} sd_card;
+
+/**
+ * @brief Resets the controller and takes the card through identification
+ *        into 4-bit transfer state, in high-speed mode if it supports it.
+ * @param card Filled in on success.
+ * @param base Controller base address.
+ * @return SD_OK or an SD_ERR_* code.
+ */
+int sd_card_init(sd_card *card, unsigned long base);
+
+/**
+ * @brief Reads count sectors starting at sector with ADMA2, one multi-block
+ *        command per 2MB, and flushes the buffer from the data cache.
+ * @param buf 4-byte aligned DRAM buffer of count * 512 bytes.
+ * @return SD_OK or an SD_ERR_* code.
+ */
+int sd_read(sd_card *card, uint32_t sector, uint32_t count, void *buf);
+
+#endif /* __SDHCI_H */
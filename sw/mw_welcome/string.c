@@ -0,0 +1,147 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#include "string.h"
+
+#define CACHE_LINE_SIZE		64UL
+
+/*
+ * Microwatt with -mstrict-align: doubleword accesses only where aligned.
+ * The destination is aligned first; a source left misaligned is read
+ * in aligned doublewords and shifted into place (little-endian).
+ */
+typedef uint64_t __attribute__((may_alias)) u64a;
+
+void *memcpy(void *dest, const void *src, size_t n)
+{
+	uint8_t *d = dest;
+	const uint8_t *s = src;
+
+	if (n >= 16) {
+		while ((uintptr_t)d & 7) {
+			*d++ = *s++;
+			n--;
+		}
+
+		if (((uintptr_t)s & 7) == 0) {
+			u64a *dw = (u64a *)d;
+			const u64a *sw = (const u64a *)s;
+
+			for (; n >= 32; n -= 32) {
+				uint64_t a = sw[0], b = sw[1], c = sw[2], e = sw[3];
+
+				dw[0] = a;
+				dw[1] = b;
+				dw[2] = c;
+				dw[3] = e;
+				sw += 4;
+				dw += 4;
+			}
+			for (; n >= 8; n -= 8) {
+				*dw++ = *sw++;
+			}
+			d = (uint8_t *)dw;
+			s = (const uint8_t *)sw;
+		} else {
+			unsigned int shift = ((uintptr_t)s & 7) * 8;
+			const u64a *sw = (const u64a *)((uintptr_t)s & ~7UL);
+			u64a *dw = (u64a *)d;
+			uint64_t lo = *sw++;
+
+			// Every word read holds bytes that are copied, so none is read past src + n
+			for (; n >= 8; n -= 8) {
+				uint64_t hi = *sw++;
+
+				*dw++ = (lo >> shift) | (hi << (64 - shift));
+				lo = hi;
+			}
+			d = (uint8_t *)dw;
+			s = (const uint8_t *)(sw - 1) + shift / 8;
+		}
+	}
+
+	while (n--) {
+		*d++ = *s++;
+	}
+	return dest;
+}
+
+void *memmove(void *dest, const void *src, size_t n)
+{
+	uint8_t *d = dest;
+	const uint8_t *s = src;
+
+	// memcpy only writes behind what it has read
+	if (d <= s || d >= s + n) {
+		return memcpy(dest, src, n);
+	}
+
+	d += n;
+	s += n;
+	if (n >= 16 && (((uintptr_t)d ^ (uintptr_t)s) & 7) == 0) {
+		u64a *dw;
+		const u64a *sw;
+
+		while ((uintptr_t)d & 7) {
+			*--d = *--s;
+			n--;
+		}
+		dw = (u64a *)d;
+		sw = (const u64a *)s;
+		for (; n >= 8; n -= 8) {
+			*--dw = *--sw;
+		}
+		d = (uint8_t *)dw;
+		s = (const uint8_t *)sw;
+	}
+
+	while (n--) {
+		*--d = *--s;
+	}
+	return dest;
+}
+
+void *memset(void *s, int c, size_t n)
+{
+	uint8_t *d = s;
+	uint64_t v = (uint8_t)c * 0x0101010101010101ULL;
+
+	if (n >= 16) {
+		u64a *dw;
+
+		while ((uintptr_t)d & 7) {
+			*d++ = (uint8_t)c;
+			n--;
+		}
+		dw = (u64a *)d;
+
+		// dcbz writes a whole line of zeros without reading it first
+		if (v == 0 && n >= 2 * CACHE_LINE_SIZE) {
+			while ((uintptr_t)dw & (CACHE_LINE_SIZE - 1)) {
+				*dw++ = 0;
+				n -= 8;
+			}
+			for (; n >= CACHE_LINE_SIZE; n -= CACHE_LINE_SIZE) {
+				__asm__ volatile("dcbz 0,%0" : : "r" (dw) : "memory");
+				dw += CACHE_LINE_SIZE / 8;
+			}
+		}
+
+		for (; n >= 32; n -= 32) {
+			dw[0] = v;
+			dw[1] = v;
+			dw[2] = v;
+			dw[3] = v;
+			dw += 4;
+		}
+		for (; n >= 8; n -= 8) {
+			*dw++ = v;
+		}
+		d = (uint8_t *)dw;
+	}
+
+	while (n--) {
+		*d++ = (uint8_t)c;
+	}
+	return s;
+}
@@ -0,0 +1,19 @@
+#ifndef __STRING_H
+#define __STRING_H
+
+#include <stddef.h>
+
+/*
+ * Bulk memory routines for the firmware. Also what GCC calls for struct
+ * copies and initialisers, so they are built with
+ * -fno-tree-loop-distribute-patterns to keep it from turning their own
+ * loops back into calls.
+ */
+
+void *memcpy(void *dest, const void *src, size_t n);
+void *memmove(void *dest, const void *src, size_t n);
+
+/* Zero fills of two cache lines or more use dcbz, so s must be cacheable DRAM */
+void *memset(void *s, int c, size_t n);
+
+#endif /* __STRING_H */
@@ -0,0 +1,38 @@
+#ifndef __TIMEBASE_H
+#define __TIMEBASE_H
+
+#include <stdint.h>
+#include "microwatt_soc.h"
+
+/* Timebase, TB_FREQ_HZ ticks per second */
+static inline uint64_t mftb(void)
+{
+	uint64_t tb;
+	__asm__ volatile("mftb %0" : "=r" (tb));
+	return tb;
+}
+
+/*
+ * Decrementer, counting down at the timebase rate; it interrupts (0x900)
+ * once bit 31 is set and MSR[EE] is on
+ */
+#define DEC_PARKED	0x7FFFFFFFUL	/* Furthest from interrupting, ~21s */
+
+static inline void mtdec(uint64_t ticks)
+{
+	__asm__ volatile("mtdec %0" : : "r" (ticks));
+}
+
+static inline uint64_t mfdec(void)
+{
+	uint64_t dec;
+	__asm__ volatile("mfdec %0" : "=r" (dec));
+	return dec;
+}
+
+static inline uint64_t tb_to_us(uint64_t ticks)
+{
+	return ticks / (TB_FREQ_HZ / 1000000UL);
+}
+
+#endif /* __TIMEBASE_H */
@@ -0,0 +1,612 @@
+/*
+ * mwpack - build a Microwatt boot image container from a kernel ELF.
+ *
+ * The output is meant to be written raw to the SD card at the sector the
+ * A53 bootloader reads from (SECTOR_OFFSET in bootloader.c), e.g.
+ *
+ *   mwpack vmlinux boot.img
+ *   dd if=boot.img of=/dev/sdX bs=512 seek=0
+ *
+ * With -c none every segment is stored raw and sector aligned, so the
+ * bootloader can DMA it straight to its load address.
+ *
+ * With --dtb and/or --initrd it builds a boot manifest instead: a sector-0
+ * table followed by the kernel (a plain ELF or an image from an earlier
+ * mwpack run, copied as is) and the raw parts, each at its own aligned
+ * offset so it can be rewritten on its own later.
+ *
+ * After writing, the image is read back, its header CRC is checked and
+ * every chunk is decompressed with the bootloader's own LZ4 decoder and
+ * compared against the ELF.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "mw_image.h"
+#include "lz4.h"
+#include "crc32.h"
+
+#define EI_NIDENT	16
+#define PT_LOAD		1
+#define EM_PPC64	21
+
+typedef struct {
+	unsigned char e_ident[EI_NIDENT];
+	uint16_t e_type;
+	uint16_t e_machine;
+	uint32_t e_version;
+	uint64_t e_entry;
+	uint64_t e_phoff;
+	uint64_t e_shoff;
+	uint32_t e_flags;
+	uint16_t e_ehsize;
+	uint16_t e_phentsize;
+	uint16_t e_phnum;
+	uint16_t e_shentsize;
+	uint16_t e_shnum;
+	uint16_t e_shstrndx;
+} elf64_ehdr;
+
+typedef struct {
+	uint32_t p_type;
+	uint32_t p_flags;
+	uint64_t p_offset;
+	uint64_t p_vaddr;
+	uint64_t p_paddr;
+	uint64_t p_filesz;
+	uint64_t p_memsz;
+	uint64_t p_align;
+} elf64_phdr;
+
+/* LZ4 block format limits */
+#define LZ4_MIN_MATCH		4U
+#define LZ4_LAST_LITERALS	5U	/* The block always ends with literals */
+#define LZ4_MFLIMIT		12U	/* No match may start closer to the end */
+#define LZ4_MAX_OFFSET		65535U
+#define LZ4_HASH_BITS		16U
+#define LZ4_BOUND(n)		((n) + (n) / 255U + 16U)
+
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint32_t lz4_hash(uint32_t v)
+{
+	return (v * 2654435761U) >> (32U - LZ4_HASH_BITS);
+}
+
+static uint8_t *lz4_put_length(uint8_t *op, uint32_t len)
+{
+	while (len >= 255U) {
+		*op++ = 255U;
+		len -= 255U;
+	}
+	*op++ = (uint8_t)len;
+	return op;
+}
+
+static uint8_t *lz4_put_sequence(uint8_t *op, const uint8_t *lit, uint32_t lit_len,
+	uint32_t offset, uint32_t match_len)
+{
+	uint8_t *token = op++;
+
+	*token = (uint8_t)((lit_len >= 15U ? 15U : lit_len) << 4);
+	if (lit_len >= 15U)
+		op = lz4_put_length(op, lit_len - 15U);
+	memcpy(op, lit, lit_len);
+	op += lit_len;
+
+	if (match_len == 0)
+		return op;	/* Final, literal-only sequence */
+
+	*op++ = (uint8_t)offset;
+	*op++ = (uint8_t)(offset >> 8);
+	match_len -= LZ4_MIN_MATCH;
+	*token |= (uint8_t)(match_len >= 15U ? 15U : match_len);
+	if (match_len >= 15U)
+		op = lz4_put_length(op, match_len - 15U);
+	return op;
+}
+
+/*
+ * Greedy single-probe LZ4 block compressor. dst must hold LZ4_BOUND(n)
+ * bytes. Returns the compressed size.
+ */
+static uint32_t lz4_compress_block(const uint8_t *src, uint32_t n, uint8_t *dst)
+{
+	static uint32_t table[1U << LZ4_HASH_BITS];
+	uint8_t *op = dst;
+	uint32_t ip = 0;
+	uint32_t anchor = 0;
+
+	memset(table, 0xFF, sizeof(table));
+
+	while (n >= LZ4_MFLIMIT + 1U && ip + LZ4_MFLIMIT < n) {
+		uint32_t seq = read32(src + ip);
+		uint32_t h = lz4_hash(seq);
+		uint32_t ref = table[h];
+		uint32_t len;
+
+		table[h] = ip;
+		if (ref == UINT32_MAX || ip - ref > LZ4_MAX_OFFSET || read32(src + ref) != seq) {
+			ip++;
+			continue;
+		}
+
+		len = LZ4_MIN_MATCH;
+		while (ip + len < n - LZ4_LAST_LITERALS && src[ref + len] == src[ip + len])
+			len++;
+
+		op = lz4_put_sequence(op, src + anchor, ip - anchor, ip - ref, len);
+		ip += len;
+		anchor = ip;
+	}
+
+	op = lz4_put_sequence(op, src + anchor, n - anchor, 0, 0);
+	return (uint32_t)(op - dst);
+}
+
+#define MANIFEST_DEF_ALIGN	0x100000U	/* Room for parts to grow in place */
+
+typedef struct {
+	uint32_t type;
+	const char *path;
+	uint64_t load_addr;
+} manifest_part;
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-c none|lz4] [-s chunk_size] input.elf output.img\n"
+		"       %s -d [-s chunk_size] input.elf output.dig\n"
+		"       %s [--dtb file@addr] [--initrd file@addr] [-a align] kernel output.img\n"
+		"  -c  compression method (default lz4); none lays segments out\n"
+		"      for direct DMA to their load addresses\n"
+		"  -d  write a CRC-32C digest sidecar for booting the plain ELF\n"
+		"  -s  uncompressed bytes per chunk (default %u)\n"
+		"  --dtb, --initrd  build a boot manifest with the kernel and these\n"
+		"      raw parts, loaded at the given Microwatt addresses\n"
+		"  -a  manifest part alignment in bytes (default 0x%x)\n",
+		prog, prog, prog, MW_IMAGE_DEF_CHUNK_SIZE, MANIFEST_DEF_ALIGN);
+	exit(2);
+}
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *buf;
+	long len;
+
+	if (!f) {
+		perror(path);
+		return NULL;
+	}
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	buf = malloc(len > 0 ? (size_t)len : 1U);
+	if (!buf || fread(buf, 1, (size_t)len, f) != (size_t)len) {
+		fprintf(stderr, "%s: read failed\n", path);
+		fclose(f);
+		free(buf);
+		return NULL;
+	}
+	fclose(f);
+	*size = (size_t)len;
+	return buf;
+}
+
+/*
+ * Reads the image back and checks every segment against the ELF, using
+ * the same decoder as the bootloader.
+ */
+static int verify_image(const char *path, const uint8_t *elf, const elf64_phdr **load,
+	uint32_t load_count)
+{
+	const mw_image_header *hdr;
+	const mw_image_chunk *chunks;
+	uint8_t *img, *out;
+	size_t img_size;
+	uint32_t crc;
+	int ret = -1;
+
+	img = read_file(path, &img_size);
+	if (!img)
+		return -1;
+	hdr = (const mw_image_header *)img;
+	chunks = mw_image_chunks(hdr);
+	out = malloc(hdr->chunk_size);
+	if (!out)
+		goto out;
+
+	if (hdr->magic != MW_IMAGE_MAGIC || hdr->seg_count != load_count ||
+		img_size < (size_t)hdr->hdr_sectors * MW_IMAGE_SECTOR_SIZE) {
+		fprintf(stderr, "verify: bad header\n");
+		goto out;
+	}
+	crc = hdr->hdr_crc;
+	((mw_image_header *)img)->hdr_crc = 0;
+	if (crc32_update(0, img, hdr->hdr_sectors * MW_IMAGE_SECTOR_SIZE) != crc) {
+		fprintf(stderr, "verify: header CRC mismatch\n");
+		goto out;
+	}
+
+	for (uint32_t s = 0; s < hdr->seg_count; s++) {
+		const mw_image_segment *seg = &hdr->seg[s];
+		const uint8_t *ref = elf + load[s]->p_offset;
+
+		for (uint32_t c = 0; c < seg->chunk_count; c++) {
+			uint32_t idx = seg->first_chunk + c;
+			const mw_image_chunk *chunk = &chunks[idx];
+			uint32_t stored = chunk->stored_size & MW_IMAGE_CHUNK_SIZE_MASK;
+			size_t off = (size_t)chunk->sector * MW_IMAGE_SECTOR_SIZE;
+			int32_t got;
+
+			if (off + stored > img_size) {
+				fprintf(stderr, "verify: chunk %u past end of image\n", idx);
+				goto out;
+			}
+			if (crc32c_update(0, img + off, stored) != chunk->crc) {
+				fprintf(stderr, "verify: chunk %u CRC mismatch\n", idx);
+				goto out;
+			}
+			if (chunk->stored_size & MW_IMAGE_CHUNK_RAW) {
+				memcpy(out, img + off, stored);
+				got = (int32_t)stored;
+			} else {
+				got = lz4_decompress_block(img + off, stored, out, hdr->chunk_size);
+			}
+			if (got != (int32_t)chunk->raw_size ||
+				memcmp(out, ref + (size_t)c * hdr->chunk_size, chunk->raw_size) != 0) {
+				fprintf(stderr, "verify: chunk %u does not match the ELF\n", idx);
+				goto out;
+			}
+		}
+	}
+	ret = 0;
+out:
+	free(out);
+	free(img);
+	return ret;
+}
+
+/*
+ * Writes the digest sidecar for a plain ELF file. It goes right after the
+ * bootloader's image window on the card.
+ */
+static int write_digest(const char *path, const uint8_t *elf, size_t elf_size,
+	uint32_t chunk_size)
+{
+	uint8_t buf[MW_DIGEST_SECTORS * MW_IMAGE_SECTOR_SIZE] = { 0 };
+	mw_digest *dg = (mw_digest *)buf;
+	FILE *out;
+
+	dg->magic = MW_DIGEST_MAGIC;
+	dg->file_size = (uint32_t)elf_size;
+	dg->chunk_size = chunk_size;
+	dg->chunk_count = (uint32_t)((elf_size + chunk_size - 1) / chunk_size);
+	if (dg->chunk_count > MW_DIGEST_MAX_CHUNKS) {
+		fprintf(stderr, "%u chunks do not fit the digest (max %zu), use a larger -s\n",
+			dg->chunk_count, (size_t)MW_DIGEST_MAX_CHUNKS);
+		return -1;
+	}
+	for (uint32_t c = 0; c < dg->chunk_count; c++) {
+		size_t off = (size_t)c * chunk_size;
+		size_t len = elf_size - off < chunk_size ? elf_size - off : chunk_size;
+
+		dg->crc[c] = crc32c_update(0, elf + off, len);
+	}
+
+	out = fopen(path, "wb");
+	if (!out || fwrite(buf, 1, sizeof(buf), out) != sizeof(buf) || fclose(out) != 0) {
+		perror(path);
+		return -1;
+	}
+
+	printf("%s: %u chunks of %u bytes; write it with dd ... seek=%u\n",
+		path, dg->chunk_count, chunk_size, MW_DIGEST_DEF_SECTOR);
+	return 0;
+}
+
+/* Parses "file@addr" into a manifest part. */
+static int parse_part(manifest_part *part, uint32_t type, char *arg)
+{
+	char *at = strrchr(arg, '@');
+	char *end;
+
+	if (!at || at == arg)
+		return -1;
+	*at = '\0';
+	part->type = type;
+	part->path = arg;
+	part->load_addr = strtoull(at + 1, &end, 0);
+	return (*end != '\0' || (part->load_addr & 7)) ? -1 : 0;
+}
+
+/*
+ * Writes a boot manifest image: the manifest in sector 0, then the kernel
+ * and every raw part, each starting on an align boundary. Prints where
+ * each part went so it can be updated on its own with dd.
+ */
+static int write_manifest(const char *path, const char *kernel, manifest_part *parts,
+	uint32_t part_count, uint32_t align)
+{
+	uint8_t sector0[MW_IMAGE_SECTOR_SIZE] = { 0 };
+	mw_manifest *mf = (mw_manifest *)sector0;
+	uint32_t next = align / MW_IMAGE_SECTOR_SIZE;
+	FILE *out;
+
+	out = fopen(path, "wb");
+	if (!out) {
+		perror(path);
+		return -1;
+	}
+
+	mf->magic = MW_MANIFEST_MAGIC;
+	mf->version = MW_MANIFEST_VERSION;
+	for (uint32_t i = 0; i <= part_count; i++) {
+		mw_manifest_entry *e = &mf->entry[mf->entry_count++];
+		const char *src = i == 0 ? kernel : parts[i - 1].path;
+		uint8_t *data;
+		size_t size;
+
+		data = read_file(src, &size);
+		if (!data)
+			return -1;
+		if (size == 0 || size > UINT32_MAX) {
+			fprintf(stderr, "%s: bad size\n", src);
+			return -1;
+		}
+		e->type = i == 0 ? MW_MANIFEST_KERNEL : parts[i - 1].type;
+		e->sector = next;
+		e->size = (uint32_t)size;
+		e->crc = i == 0 ? 0 : crc32c_update(0, data, (uint32_t)size);
+		e->load_addr = i == 0 ? 0 : parts[i - 1].load_addr;
+
+		fseek(out, (long)e->sector * MW_IMAGE_SECTOR_SIZE, SEEK_SET);
+		if (fwrite(data, 1, size, out) != size) {
+			perror("write");
+			return -1;
+		}
+		free(data);
+
+		printf("  %-10s sector %-8u %9u bytes", i == 0 ? "kernel" :
+			e->type == MW_MANIFEST_DTB ? "dtb" : "initrd", e->sector, e->size);
+		if (i != 0)
+			printf(" at 0x%08llx", (unsigned long long)e->load_addr);
+		printf("\n");
+
+		next = e->sector + (uint32_t)((size + align - 1) / align) * (align / MW_IMAGE_SECTOR_SIZE);
+	}
+	/* Pad the last part to a whole sector */
+	fseek(out, (long)next * MW_IMAGE_SECTOR_SIZE - 1, SEEK_SET);
+	fputc(0, out);
+
+	mf->hdr_crc = crc32_update(0, mf, sizeof(*mf));
+	fseek(out, 0, SEEK_SET);
+	if (fwrite(sector0, 1, sizeof(sector0), out) != sizeof(sector0) || fclose(out) != 0) {
+		perror("write");
+		return -1;
+	}
+
+	printf("%s: manifest with %u parts\n", path, mf->entry_count);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	static const struct option long_opts[] = {
+		{ "dtb", required_argument, NULL, 't' },
+		{ "initrd", required_argument, NULL, 'i' },
+		{ NULL, 0, NULL, 0 }
+	};
+	manifest_part parts[MW_MANIFEST_MAX_ENTRIES - 1];
+	uint32_t part_count = 0;
+	uint32_t align = MANIFEST_DEF_ALIGN;
+	const elf64_phdr *load[MW_IMAGE_MAX_SEGMENTS];
+	uint32_t chunk_size = MW_IMAGE_DEF_CHUNK_SIZE;
+	uint32_t comp = MW_IMAGE_COMP_LZ4;
+	uint32_t load_count = 0;
+	uint32_t chunk_count = 0;
+	uint32_t sector;
+	uint64_t raw_total = 0, stored_total = 0;
+	mw_image_header *hdr;
+	mw_image_chunk *chunks;
+	const elf64_ehdr *ehdr;
+	uint8_t *elf, *hdr_buf, *cbuf;
+	size_t elf_size;
+	FILE *out;
+	int digest = 0;
+	int opt;
+
+	while ((opt = getopt_long(argc, argv, "a:c:ds:", long_opts, NULL)) != -1) {
+		switch (opt) {
+		case 'a':
+			align = (uint32_t)strtoul(optarg, NULL, 0);
+			if (align < MW_IMAGE_SECTOR_SIZE || align % MW_IMAGE_SECTOR_SIZE)
+				usage(argv[0]);
+			break;
+		case 't':
+		case 'i':
+			if (part_count == MW_MANIFEST_MAX_ENTRIES - 1 ||
+			    parse_part(&parts[part_count++], opt == 't' ? MW_MANIFEST_DTB :
+				       MW_MANIFEST_INITRD, optarg) != 0)
+				usage(argv[0]);
+			break;
+		case 'd':
+			digest = 1;
+			break;
+		case 'c':
+			if (!strcmp(optarg, "lz4"))
+				comp = MW_IMAGE_COMP_LZ4;
+			else if (!strcmp(optarg, "none"))
+				comp = MW_IMAGE_COMP_NONE;
+			else
+				usage(argv[0]);
+			break;
+		case 's':
+			chunk_size = (uint32_t)strtoul(optarg, NULL, 0);
+			if (chunk_size < MW_IMAGE_SECTOR_SIZE || chunk_size > MW_IMAGE_MAX_CHUNK_SIZE ||
+			    chunk_size % MW_IMAGE_SECTOR_SIZE)
+				usage(argv[0]);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (argc - optind != 2)
+		usage(argv[0]);
+	if (part_count != 0)
+		return write_manifest(argv[optind + 1], argv[optind], parts, part_count, align) != 0;
+
+	elf = read_file(argv[optind], &elf_size);
+	if (!elf)
+		return 1;
+	if (digest) {
+		int ret = write_digest(argv[optind + 1], elf, elf_size, chunk_size);
+
+		free(elf);
+		return ret != 0;
+	}
+
+	/* 1. Collect the loadable segments. */
+	ehdr = (const elf64_ehdr *)elf;
+	if (elf_size < sizeof(*ehdr) || memcmp(ehdr->e_ident, "\177ELF", 4) != 0 ||
+		ehdr->e_ident[4] != 2 || ehdr->e_ident[5] != 1) {
+		fprintf(stderr, "%s: not a little-endian ELF64 file\n", argv[optind]);
+		return 1;
+	}
+	if (ehdr->e_machine != EM_PPC64)
+		fprintf(stderr, "warning: e_machine is %u, not PPC64\n", ehdr->e_machine);
+	if (ehdr->e_phoff + (uint64_t)ehdr->e_phnum * sizeof(elf64_phdr) > elf_size) {
+		fprintf(stderr, "%s: truncated program headers\n", argv[optind]);
+		return 1;
+	}
+
+	for (uint32_t i = 0; i < ehdr->e_phnum; i++) {
+		const elf64_phdr *ph = (const elf64_phdr *)(elf + ehdr->e_phoff) + i;
+
+		if (ph->p_type != PT_LOAD)
+			continue;
+		if (load_count == MW_IMAGE_MAX_SEGMENTS) {
+			fprintf(stderr, "too many PT_LOAD segments (max %u)\n", MW_IMAGE_MAX_SEGMENTS);
+			return 1;
+		}
+		if (ph->p_offset + ph->p_filesz > elf_size) {
+			fprintf(stderr, "segment %u runs past the end of the file\n", i);
+			return 1;
+		}
+		load[load_count++] = ph;
+		chunk_count += (uint32_t)((ph->p_filesz + chunk_size - 1) / chunk_size);
+	}
+	if (chunk_count > MW_IMAGE_MAX_CHUNKS) {
+		fprintf(stderr, "%u chunks do not fit the header (max %zu), use a larger -s\n",
+			chunk_count, (size_t)MW_IMAGE_MAX_CHUNKS);
+		return 1;
+	}
+
+	/* 2. Fill in the header and compress the chunks. */
+	hdr_buf = calloc(MW_IMAGE_HDR_MAX_SECTORS, MW_IMAGE_SECTOR_SIZE);
+	cbuf = malloc(LZ4_BOUND(chunk_size));
+	if (!hdr_buf || !cbuf)
+		return 1;
+	hdr = (mw_image_header *)hdr_buf;
+	chunks = mw_image_chunks(hdr);
+	hdr->magic = MW_IMAGE_MAGIC;
+	hdr->version = MW_IMAGE_VERSION;
+	hdr->comp = (uint16_t)comp;
+	hdr->hdr_sectors = (uint32_t)((sizeof(*hdr) + chunk_count * sizeof(*chunks) +
+		MW_IMAGE_SECTOR_SIZE - 1) / MW_IMAGE_SECTOR_SIZE);
+	hdr->seg_count = load_count;
+	hdr->chunk_count = chunk_count;
+	hdr->chunk_size = chunk_size;
+	hdr->entry = ehdr->e_entry;
+
+	out = fopen(argv[optind + 1], "wb");
+	if (!out) {
+		perror(argv[optind + 1]);
+		return 1;
+	}
+	/* The header is written last, once the chunk table is complete. */
+	fseek(out, (long)hdr->hdr_sectors * MW_IMAGE_SECTOR_SIZE, SEEK_SET);
+
+	sector = hdr->hdr_sectors;
+	chunk_count = 0;
+	for (uint32_t s = 0; s < load_count; s++) {
+		const elf64_phdr *ph = load[s];
+		mw_image_segment *seg = &hdr->seg[s];
+
+		seg->load_addr = ph->p_vaddr;
+		seg->mem_size = ph->p_memsz;
+		seg->file_size = ph->p_filesz;
+		seg->first_chunk = chunk_count;
+
+		for (uint64_t off = 0; off < ph->p_filesz; off += chunk_size) {
+			mw_image_chunk *chunk = &chunks[chunk_count++];
+			const uint8_t *raw = elf + ph->p_offset + off;
+			uint32_t raw_size = (uint32_t)(ph->p_filesz - off < chunk_size ?
+				ph->p_filesz - off : chunk_size);
+			uint32_t stored = raw_size;
+			const uint8_t *data = raw;
+			uint32_t pad;
+
+			if (comp == MW_IMAGE_COMP_LZ4) {
+				uint32_t csize = lz4_compress_block(raw, raw_size, cbuf);
+
+				if (csize < raw_size) {
+					stored = csize;
+					data = cbuf;
+				}
+			}
+
+			chunk->sector = sector;
+			chunk->raw_size = raw_size;
+			chunk->stored_size = stored | (data == raw ? MW_IMAGE_CHUNK_RAW : 0);
+			chunk->crc = crc32c_update(0, data, stored);
+
+			pad = (MW_IMAGE_SECTOR_SIZE - stored % MW_IMAGE_SECTOR_SIZE) % MW_IMAGE_SECTOR_SIZE;
+			if (fwrite(data, 1, stored, out) != stored) {
+				perror("write");
+				return 1;
+			}
+			for (uint32_t p = 0; p < pad; p++)
+				fputc(0, out);
+			sector += (stored + pad) / MW_IMAGE_SECTOR_SIZE;
+			raw_total += raw_size;
+			stored_total += stored;
+		}
+		seg->chunk_count = chunk_count - seg->first_chunk;
+	}
+
+	hdr->hdr_crc = crc32_update(0, hdr_buf, hdr->hdr_sectors * MW_IMAGE_SECTOR_SIZE);
+
+	fseek(out, 0, SEEK_SET);
+	if (fwrite(hdr_buf, MW_IMAGE_SECTOR_SIZE, hdr->hdr_sectors, out) != hdr->hdr_sectors ||
+		fclose(out) != 0) {
+		perror("write");
+		return 1;
+	}
+
+	/* 3. Round trip. */
+	if (verify_image(argv[optind + 1], elf, load, load_count) != 0) {
+		fprintf(stderr, "%s: verification FAILED\n", argv[optind + 1]);
+		return 1;
+	}
+
+	printf("%s: %u segments, %u chunks, %llu -> %llu bytes (%u sectors), verified\n",
+		argv[optind + 1], load_count, chunk_count,
+		(unsigned long long)raw_total, (unsigned long long)stored_total, sector);
+
+	free(cbuf);
+	free(hdr_buf);
+	free(elf);
+	return 0;
+}
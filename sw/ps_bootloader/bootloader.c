@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <xil_types.h>
 #include <xstatus.h>
@@ -7,7 +8,15 @@
 #include "xparameters.h" // Contains hardware base addresses
 #include "xil_io.h"      // For Xil_Out32 and Xil_In32
 #include "xil_cache.h"   // For cache management
+#include "sleep.h"       // usleep
 #include "xsdps.h"		 // SD device driver
+#include "mw_image.h"	 // Compressed boot image container
+#include "crc32.h"
+#include "xtime_l.h"	 // COUNTS_PER_SECOND
+#include "mw_shared.h"	 // DRAM area shared with Microwatt
+#include "elf_loader.h"	 // ELF loader shared with the host build
+#include "sd_cache.h"	 // Read-ahead cache for small SD reads
+#include "image_loader.h" // Pipelined loaders shared with the host build
 
 #define CTR_REG			 	 	0xA0000000
 #define MEM_REG			 	 	0xA0000004
@@ -20,248 +29,1373 @@
 #define SECTOR_OFFSET			0x00000000UL
 #define PS_DRAM_BASE_OFFSET		0x20000000UL
 #define ELF_OS_BASE_OFFSET		0x30000000UL
+#define SHARED_PS_BASE			(PS_DRAM_BASE_OFFSET + MW_SHARED_BASE)
 
-// The SDPS driver's ADMA descriptor table can handle a maximum of 2MB
-// per transfer (32 descriptors * 65536 bytes/descriptor).
-#define MAX_BYTES_PER_TRANSFER (32U * 65536U)
-
-// --- Part 1: ELF Header Definitions for a 64-bit system ---
-// These structures must match the ELF64 specification.
-
-#define EI_NIDENT 16
-
-// ELF Header (Ehdr)
-typedef struct {
-    unsigned char e_ident[EI_NIDENT]; // Magic number and other info
-    uint16_t      e_type;             // Object file type
-    uint16_t      e_machine;          // Architecture
-    uint32_t      e_version;          // Object file version
-    uint64_t      e_entry;            // Entry point virtual address
-    uint64_t      e_phoff;            // Program header table file offset
-    uint64_t      e_shoff;            // Section header table file offset
-    uint32_t      e_flags;            // Processor-specific flags
-    uint16_t      e_ehsize;           // ELF header size in bytes
-    uint16_t      e_phentsize;        // Program header table entry size
-    uint16_t      e_phnum;            // Program header table entry count
-    uint16_t      e_shentsize;        // Section header table entry size
-    uint16_t      e_shnum;            // Section header table entry count
-    uint16_t      e_shstrndx;         // Section header string table index
-} Elf64_Ehdr;
-
-// Program Header (Phdr)
-typedef struct {
-    uint32_t p_type;   // Segment type
-    uint32_t p_flags;  // Segment flags
-    uint64_t p_offset; // Segment file offset
-    uint64_t p_vaddr;  // Segment virtual address
-    uint64_t p_paddr;  // Segment physical address
-    uint64_t p_filesz; // Segment size in file
-    uint64_t p_memsz;  // Segment size in memory
-    uint64_t p_align;  // Segment alignment
-} Elf64_Phdr;
-
-// ELF segment types
-#define PT_NULL    0
-#define PT_LOAD    1 // Identifies a loadable segment
-
-// ELF magic number
-#define ELFMAG0 0x7f
-#define ELFMAG1 'E'
-#define ELFMAG2 'L'
-#define ELFMAG3 'F'
+// Warm restart: after a cold boot the loaded segments are copied to a
+// snapshot area above the Microwatt/Linux memory. When the bootloader is
+// run again, the snapshot is intact and the headers on the card still
+// match the ones it was loaded from, it is restored instead of reading the
+// whole image. Images without checksums (a plain ELF without a digest
+// sidecar) are never snapshotted. The cost: every cold boot copies and
+// CRCs all loaded segments once more (the "snapshot" phase, about as long
+// as "extract"), and a warm restart still initializes the card to re-read
+// the headers. Set WARM_RESTART to 0 to always boot from the card.
+#define WARM_RESTART			1
+#define WARM_SNAPSHOT_BASE		0x31000000UL
+#define WARM_SNAPSHOT_SIZE		0x0E000000UL	// Ends at 0x3F000000, below SHARED_PS_BASE
+
+// Set CONSOLE_RING to 1 to give Microwatt a console ring in shared DRAM
+// (mw_console in mw_shared.h). After the release the bootloader copies
+// it to stdout, so Microwatt software never waits on the 115200-baud UART.
+#define CONSOLE_RING			1
+#define CONSOLE_RING_BURST		256U	// Bytes printed between tail updates
+
+// Set AUTOBOOT to 1 to have the Microwatt firmware enter the kernel as soon
+// as it starts (mw_boot_info in mw_shared.h), or to 0 to make it wait for a
+// key on the console first.
+#define AUTOBOOT			1
+
+// Set BULK_MAILBOX to 1 to do large zero fills and copies for Microwatt
+// after the release (mw_bulk in mw_shared.h). The A53 stores straight to
+// DRAM, where every Microwatt access is a round trip through the AXI-Lite
+// bridge. The "bulk" cases of mw_bench measure the difference.
+#define BULK_MAILBOX			1
+#define SERVICE_IDLE_US			20U	// Poll interval while Microwatt asks for nothing
+
+// Each ADMA2 descriptor moves up to 64KB. The driver's built-in table only
+// has 32 of them (2MB per transfer), so we hand it a table big enough to
+// cover the whole OS image and read it with a single CMD18.
+#define SD_SECTOR_SIZE			512U	// Standard SD sector/block size
+#define SD_DESC_MAX_LENGTH		65536U
+#define SD_DESC_LINES			((OS_SIZE_BYTES + SD_DESC_MAX_LENGTH - 1U) / SD_DESC_MAX_LENGTH)
+
+// Set SD_AUTO_SPEED to 1 to walk down from the fastest bus mode the card
+// advertises until one passes tuning and a read-back of the first
+// SD_SPEED_CHECK_SECTORS of the image. The chosen mode is then timed on an
+// SD_SPEED_TEST_BYTES read. Costs a few tens of ms at init.
+#define SD_AUTO_SPEED			1
+#define SD_SPEED_CHECK_SECTORS		64U
+#define SD_SPEED_TEST_BYTES		0x40000U
+
+// The first sectors of the image hold either the ELF and program headers
+// or an mw_image header and chunk table. The direct ELF loader scatters up
+// to ELF_MAX_SG_SEGMENTS segments at once.
+#define BOOT_HDR_SECTORS		MW_IMAGE_HDR_MAX_SECTORS
+#define ELF_MAX_SG_SEGMENTS		16U
+#define LOAD_NOT_DIRECT			2	// Layout needs the buffered/streaming path
+
+// The pipelined loaders (image_loader.c) read windows of up to
+// LOADER_PIPE_MAX_SG entries and STREAM_BUF_SIZE bytes with one CMD18,
+// which the SD_DESC_LINES descriptors always cover. What they cannot DMA
+// in place (compressed chunks, partial sectors) is staged in two buffers
+// placed after the header in the ELF_OS_BASE_OFFSET area: one is filled
+// by the SD controller while the items in the other are checked and
+// decompressed.
+#define STREAM_BUF_SIZE			LOADER_STAGE_SIZE
+#define STREAM_BUF_BASE			(ELF_OS_BASE_OFFSET + BOOT_HDR_SECTORS * SD_SECTOR_SIZE)
+
+// Small reads (boot headers, manifest, digest sidecar) go through a cache
+// of SD_CACHE_LINES lines of SD_CACHE_WINDOW sectors, so that neighbouring
+// metadata costs one command. It lives after the digest sidecar buffer.
+#define SD_CACHE_LINES			8U
+#define SD_CACHE_WINDOW			64U	// 32KB per line
+#define SD_CACHE_BASE			(ELF_OS_BASE_OFFSET + OS_SIZE_BYTES + \
+					 MW_DIGEST_SECTORS * SD_SECTOR_SIZE)
+
+// --- Part 1: ELF definitions and the portable loader live in elf_loader.h ---
 
 // --- Part 2: Baremetal Memory Utilities ---
-// We can't use the standard library, so we provide our own.
+// We can't use the standard library, so we provide our own. The D-cache
+// is off, so every access is a bus transaction of its own: both move a
+// doubleword at a time once the pointers are aligned.
+
+void *my_memcpy(void *dest, const void *src, size_t n) {
+    char *d = dest;
+    const char *s = src;
+
+    if ((((uintptr_t)d ^ (uintptr_t)s) & 7U) == 0) {
+        while (n > 0 && ((uintptr_t)d & 7U) != 0) {
+            *d++ = *s++;
+            n--;
+        }
+        for (; n >= 8; n -= 8, d += 8, s += 8) {
+            *(uint64_t *)d = *(const uint64_t *)s;
+        }
+    }
+    while (n > 0) {
+        *d++ = *s++;
+        n--;
+    }
+    return dest;
+}
+
+void *my_memset(void *s, int c, size_t n) {
+    unsigned char *p = s;
+    uint64_t v = (unsigned char)c * 0x0101010101010101ULL;
+
+    while (n > 0 && ((uintptr_t)p & 7U) != 0) {
+        *p++ = (unsigned char)c;
+        n--;
+    }
+    for (; n >= 8; n -= 8, p += 8) {
+        *(uint64_t *)p = v;
+    }
+    while (n > 0) {
+        *p++ = (unsigned char)c;
+        n--;
+    }
+    return s;
+}
+
+// --- Part 3: Boot-Phase Timing ---
+// Every phase is timed with the A53 generic counter. The results live in
+// the shared DRAM area so Microwatt firmware or Linux can pick them up.
+
+static mw_boot_stats *const boot_stats =
+	(mw_boot_stats *)(SHARED_PS_BASE + MW_SHARED_BOOT_STATS_OFFSET);
+
+static const char *const boot_phase_name[MW_BOOT_PHASE_COUNT] = {
+	"fw copy", "sd init", "sd read", "extract", "release", "snapshot"
+};
+
+static inline uint64_t read_cntpct(void)
+{
+	uint64_t v;
+
+	__asm__ volatile("isb; mrs %0, cntpct_el0" : "=r"(v) : : "memory");
+	return v;
+}
+
+static inline uint64_t read_cntfrq(void)
+{
+	uint64_t v;
+
+	__asm__ volatile("mrs %0, cntfrq_el0" : "=r"(v));
+	return v;
+}
+
+/**
+ * @brief	Clears the boot statistics and marks the start of the boot.
+ */
+static void boot_stats_init(void)
+{
+	my_memset(boot_stats, 0, sizeof(*boot_stats));
+	boot_stats->magic = MW_BOOT_STATS_MAGIC;
+	boot_stats->version = MW_BOOT_STATS_VERSION;
+	// CNTFRQ_EL0 is only a hint and is left at zero by some boot flows.
+	boot_stats->cntfrq = read_cntfrq();
+	if (boot_stats->cntfrq == 0) {
+		boot_stats->cntfrq = COUNTS_PER_SECOND;
+	}
+	boot_stats->start = read_cntpct();
+}
+
+/**
+ * @brief	Adds the time since 'start' and the bytes moved to a boot phase.
+ *
+ * @note	Phases accumulate, so a phase that runs in several pieces (like
+ *          the header read followed by the payload read) is reported once.
+ */
+static void boot_phase_end(uint32_t phase, uint64_t start, uint64_t bytes)
+{
+	boot_stats->phase[phase].ticks += read_cntpct() - start;
+	boot_stats->phase[phase].bytes += bytes;
+}
+
+static uint32_t ticks_to_us(uint64_t ticks)
+{
+	return (uint32_t)(ticks * 1000000ULL / boot_stats->cntfrq);
+}
+
+/**
+ * @brief	Prints the boot-phase timing table.
+ */
+static void boot_stats_print(void)
+{
+	xil_printf("\n\r%-10s %12s %10s %9s\n\r", "phase", "time (us)", "bytes", "MB/s");
+	for (uint32_t i = 0; i < MW_BOOT_PHASE_COUNT; i++) {
+		mw_boot_phase *p = &boot_stats->phase[i];
+		uint32_t mbps_x100 = 0;
+
+		if (p->bytes != 0 && p->ticks != 0) {
+			mbps_x100 = (uint32_t)(p->bytes * 100ULL * boot_stats->cntfrq /
+				(p->ticks * 1000000ULL));
+		}
+		xil_printf("%-10s %12u %10u %6u.%02u\n\r", boot_phase_name[i],
+			   (unsigned int)ticks_to_us(p->ticks), (unsigned int)p->bytes,
+			   (unsigned int)(mbps_x100 / 100), (unsigned int)(mbps_x100 % 100));
+	}
+	xil_printf("%-10s %12u\n\r", "total",
+		   (unsigned int)ticks_to_us(boot_stats->release - boot_stats->start));
+	xil_printf("Boot statistics saved at 0x%08X (Microwatt 0x%08X).\n\r\n\r",
+		   (unsigned int)(uintptr_t)boot_stats,
+		   (unsigned int)(MW_SHARED_BASE + MW_SHARED_BOOT_STATS_OFFSET));
+}
+
+// --- Part 4: Warm Restart ---
+// Every loader records the segments it placed in the warm record, and every
+// header read from the card. Once the cold boot is complete,
+// warm_snapshot_save() copies the segments aside and seals the record with
+// two CRCs.
+
+static mw_warm_record *const warm_record =
+	(mw_warm_record *)(SHARED_PS_BASE + MW_SHARED_WARM_OFFSET);
+
+/**
+ * @brief	Invalidates the warm record before memory is reloaded from the card.
+ */
+static void warm_record_clear(void)
+{
+	warm_record->magic = 0;
+	warm_record->seg_count = 0;
+	warm_record->hdr_count = 0;
+}
+
+/**
+ * @brief	Records the metadata sectors just read from the card, so that a
+ *          warm restart can tell whether the image has changed since.
+ */
+static void warm_note_header(uint32_t sector, uint32_t count, const void *buf)
+{
+	mw_warm_header *hdr;
+
+	if (warm_record->hdr_count >= MW_WARM_MAX_HEADERS) {
+		warm_record->hdr_count = MW_WARM_MAX_HEADERS + 1;
+		return;
+	}
+	hdr = &warm_record->hdr[warm_record->hdr_count++];
+	hdr->sector = sector;
+	hdr->count = count;
+	hdr->crc = crc32c_update(0, buf, count * SD_SECTOR_SIZE);
+}
+
+/**
+ * @brief	Marks the image as one whose headers do not cover its contents,
+ *          so that the record is never sealed.
+ */
+static void warm_note_unchecked(void)
+{
+	warm_record->hdr_count = MW_WARM_MAX_HEADERS + 1;
+}
+
+/**
+ * @brief	Records a segment that has been loaded into DRAM.
+ */
+static void warm_note_segment(uintptr_t dst, uint64_t file_size, uint64_t mem_size)
+{
+	mw_warm_segment *seg;
+
+	if (warm_record->seg_count >= MW_WARM_MAX_SEGMENTS) {
+		// Too many to restore; the record is never sealed.
+		warm_record->seg_count = MW_WARM_MAX_SEGMENTS + 1;
+		return;
+	}
+	seg = &warm_record->seg[warm_record->seg_count++];
+	seg->dst = dst;
+	seg->file_size = file_size;
+	seg->mem_size = mem_size;
+}
+
+static uint32_t warm_record_crc(void)
+{
+	uint32_t saved = warm_record->record_crc;
+	uint32_t crc;
+
+	warm_record->record_crc = 0;
+	crc = crc32_update(0, warm_record, sizeof(*warm_record));
+	warm_record->record_crc = saved;
+
+	return crc;
+}
+
+/**
+ * @brief	Copies the freshly loaded segments to the snapshot area and seals
+ *          the warm record. Must run before Microwatt starts modifying them.
+ *
+ * @note	Timed as the "snapshot" phase, which is what WARM_RESTART adds
+ *          to every cold boot.
+ */
+static void warm_snapshot_save(void)
+{
+	uintptr_t snap = WARM_SNAPSHOT_BASE;
+	uint64_t t0 = read_cntpct();
+
+	if (warm_record->seg_count > MW_WARM_MAX_SEGMENTS) {
+		xil_printf("Warm restart disabled: too many segments.\n\r");
+		return;
+	}
+	if (warm_record->hdr_count > MW_WARM_MAX_HEADERS) {
+		xil_printf("Warm restart disabled: the image has no checksums to compare.\n\r");
+		return;
+	}
+	for (u32 i = 0; i < warm_record->seg_count; i++) {
+		mw_warm_segment *seg = &warm_record->seg[i];
+
+		if (snap + seg->file_size > WARM_SNAPSHOT_BASE + WARM_SNAPSHOT_SIZE) {
+			xil_printf("Warm restart disabled: image too large for the snapshot.\n\r");
+			return;
+		}
+		my_memcpy((void *)snap, (void *)seg->dst, seg->file_size);
+		snap += seg->file_size;
+	}
+
+	warm_record->snapshot = WARM_SNAPSHOT_BASE;
+	warm_record->snapshot_size = snap - WARM_SNAPSHOT_BASE;
+	warm_record->snapshot_crc = crc32c_update(0, (void *)WARM_SNAPSHOT_BASE,
+		(uint32_t)warm_record->snapshot_size);
+	warm_record->magic = MW_WARM_MAGIC;
+	warm_record->record_crc = warm_record_crc();
+	boot_phase_end(MW_BOOT_PHASE_SNAPSHOT, t0, warm_record->snapshot_size);
+}
+
+static int sd_read_small(uint32_t sector, uint32_t count, void *buf);
+
+/**
+ * @brief	Re-reads the headers recorded by the cold boot and compares them
+ *          with what the card holds now.
+ *
+ * @return	XST_SUCCESS if they all match, otherwise XST_FAILURE.
+ */
+static int warm_card_matches(void)
+{
+	void *buf = (void *)ELF_OS_BASE_OFFSET;
+	uint64_t t0 = read_cntpct();
+	uint64_t bytes = 0;
+
+	if (warm_record->hdr_count == 0) {
+		return XST_FAILURE;
+	}
+	for (u32 i = 0; i < warm_record->hdr_count; i++) {
+		mw_warm_header *hdr = &warm_record->hdr[i];
+
+		if (hdr->count > BOOT_HDR_SECTORS ||
+			sd_read_small(hdr->sector, hdr->count, buf) != XST_SUCCESS ||
+			crc32c_update(0, buf, hdr->count * SD_SECTOR_SIZE) != hdr->crc) {
+			return XST_FAILURE;
+		}
+		bytes += hdr->count * SD_SECTOR_SIZE;
+	}
+	boot_phase_end(MW_BOOT_PHASE_SD_READ, t0, bytes);
+
+	return XST_SUCCESS;
+}
+
+/**
+ * @brief	Restores the segments of the last cold boot from the snapshot.
+ *
+ * @return	XST_SUCCESS if the snapshot was intact and the card still holds
+ *          the image it was taken from, in which case it has been restored,
+ *          otherwise XST_FAILURE and DRAM is left untouched.
+ */
+static int warm_restore(void)
+{
+	uintptr_t snap = WARM_SNAPSHOT_BASE;
+	uint64_t t0;
+	uint64_t bytes = 0;
+
+	if (warm_record->magic != MW_WARM_MAGIC ||
+		warm_record->record_crc != warm_record_crc() ||
+		warm_record->snapshot != WARM_SNAPSHOT_BASE ||
+		warm_record->snapshot_size > WARM_SNAPSHOT_SIZE ||
+		warm_record->seg_count > MW_WARM_MAX_SEGMENTS ||
+		warm_record->hdr_count > MW_WARM_MAX_HEADERS) {
+		return XST_FAILURE;
+	}
+	if (warm_card_matches() != XST_SUCCESS) {
+		xil_printf("The boot image on the SD card has changed, booting from the card.\n\r");
+		return XST_FAILURE;
+	}
+	t0 = read_cntpct();
+	if (crc32c_update(0, (void *)WARM_SNAPSHOT_BASE, (uint32_t)warm_record->snapshot_size) !=
+		warm_record->snapshot_crc) {
+		xil_printf("Warm snapshot is corrupt, booting from the SD card.\n\r");
+		return XST_FAILURE;
+	}
+
+	for (u32 i = 0; i < warm_record->seg_count; i++) {
+		mw_warm_segment *seg = &warm_record->seg[i];
+
+		my_memcpy((void *)seg->dst, (void *)snap, seg->file_size);
+		snap += seg->file_size;
+		if (seg->mem_size > seg->file_size) {
+			my_memset((void *)(seg->dst + seg->file_size), 0, seg->mem_size - seg->file_size);
+		}
+		bytes += seg->mem_size;
+	}
+	boot_phase_end(MW_BOOT_PHASE_EXTRACT, t0, bytes);
+	boot_stats->flags |= MW_BOOT_FLAG_WARM;
+
+	return XST_SUCCESS;
+}
+
+// --- Part 5: Hooks for the portable loaders (elf_loader.c, image_loader.c) ---
+
+void loader_copy(uintptr_t dst, uintptr_t src, size_t len)
+{
+	if (src == 0) {
+		my_memset((void *)dst, 0, len);
+	} else {
+		my_memcpy((void *)dst, (const void *)src, len);
+	}
+}
+
+void loader_note_segment(uintptr_t dst, uint64_t file_size, uint64_t mem_size)
+{
+	warm_note_segment(dst, file_size, mem_size);
+}
+
+uint64_t loader_time(void)
+{
+	return read_cntpct();
+}
+
+void loader_phase_end(uint32_t phase, uint64_t start, uint64_t bytes)
+{
+	boot_phase_end(phase, start, bytes);
+}
+
+#if SD_AUTO_SPEED
+/**
+ * @brief	Picks the fastest SD bus mode that reads the image back
+ *          correctly, then reports it with a measured read throughput.
+ *
+ * @return	XST_SUCCESS if the card works in some mode, otherwise XST_FAILURE.
+ */
+static int sd_select_speed(XSdPs *SdInstance)
+{
+	static const char *const mode_name[] = {
+		"SDR12", "SDR25", "SDR50", "SDR104", "DDR50", "HS", "default", "HS200"
+	};
+	u32 arg = SdInstance->HCS ? SECTOR_OFFSET : SECTOR_OFFSET * SD_SECTOR_SIZE;
+	uint64_t t0;
+	uint32_t us;
+	int Status;
+
+	Status = XSdPs_SelectBusSpeed(SdInstance, arg, SD_SPEED_CHECK_SECTORS,
+		(u8 *)STREAM_BUF_BASE, (u8 *)(STREAM_BUF_BASE + STREAM_BUF_SIZE));
+	if (Status != XST_SUCCESS) {
+		xil_printf("ERROR: SD card failed the read-back check in every bus mode.\r\n");
+		return XST_FAILURE;
+	}
+
+	t0 = read_cntpct();
+	Status = XSdPs_ReadPolled(SdInstance, arg, SD_SPEED_TEST_BYTES / SD_SECTOR_SIZE,
+		(u8 *)STREAM_BUF_BASE);
+	us = ticks_to_us(read_cntpct() - t0);
+	if (Status != XST_SUCCESS) {
+		xil_printf("ERROR: SD throughput read failed. Status: %d\r\n", Status);
+		return XST_FAILURE;
+	}
+
+	xil_printf("SD bus mode %s at %u MHz, %u.%02u MB/s\r\n",
+		   SdInstance->Mode < sizeof(mode_name) / sizeof(mode_name[0]) ?
+		   mode_name[SdInstance->Mode] : "?",
+		   (unsigned int)(SdInstance->BusSpeed / 1000000U),
+		   (unsigned int)(us ? SD_SPEED_TEST_BYTES / us : 0),
+		   (unsigned int)(us ? (SD_SPEED_TEST_BYTES * 100ULL / us) % 100 : 0));
+
+	return XST_SUCCESS;
+}
+#endif
+
+/**
+ * @brief	Initializes the SDPS driver and the SD card.
+ *
+ * @return	Pointer to the ready driver instance, or NULL on failure.
+ *
+ * @note	Initialization only happens on the first call; later calls
+ *          return the same instance. A descriptor table sized for
+ *          OS_SIZE_BYTES is registered with the driver, so the whole
+ *          OS image normally goes in one multi-block read.
+ */
+static XSdPs *sd_init(void)
+{
+	static XSdPs SdInstance;
+	static XSdPs_Adma2Descriptor64 SdDescTbl[SD_DESC_LINES] __attribute__ ((aligned(32)));
+	static int SdIsInitialized = 0; // Initialize the driver only once
+	XSdPs_Config *SdConfig;
+	uint64_t t0;
+	int Status;
+
+	if (SdIsInitialized) {
+		return &SdInstance;
+	}
+	t0 = read_cntpct();
+
+	xil_printf("Initializing SDPS driver...\r\n");
+
+	// Look up the device configuration
+#ifndef SDT
+	// Using Device ID from xparameters.h for baremetal flow
+	SdConfig = XSdPs_LookupConfig(XPAR_XSDPS_0_DEVICE_ID);
+#else
+	// Using base address for system device-tree flow
+	SdConfig = XSdPs_LookupConfig(XPAR_XSDPS_0_BASEADDR);
+#endif
+	if (NULL == SdConfig) {
+		xil_printf("ERROR: SDPS LookupConfig failed.\r\n");
+		return NULL;
+	}
+
+	// Initialize the SDPS driver instance
+	Status = XSdPs_CfgInitialize(&SdInstance, SdConfig, SdConfig->BaseAddress);
+	if (Status != XST_SUCCESS) {
+		xil_printf("ERROR: SDPS CfgInitialize failed. Status: %d\r\n", Status);
+		return NULL;
+	}
+
+	// Perform card initialization sequence
+	Status = XSdPs_CardInitialize(&SdInstance);
+	if (Status != XST_SUCCESS) {
+		xil_printf("ERROR: SDPS CardInitialize failed. Status: %d\r\n", Status);
+		return NULL;
+	}
+
+	// Replace the driver's 32-entry descriptor table with ours
+	Status = XSdPs_SetAdma2DescrTbl(&SdInstance, SdDescTbl, SD_DESC_LINES);
+	if (Status != XST_SUCCESS) {
+		xil_printf("ERROR: SDPS SetAdma2DescrTbl failed. Status: %d\r\n", Status);
+		return NULL;
+	}
+
+#if SD_AUTO_SPEED
+	if (sd_select_speed(&SdInstance) != XST_SUCCESS) {
+		return NULL;
+	}
+#endif
+
+	SdIsInitialized = 1;
+	boot_phase_end(MW_BOOT_PHASE_SD_INIT, t0, 0);
+	xil_printf("SDPS driver and card initialized successfully.\r\n");
+	xil_printf("SD multi-block reads end by %s\r\n",
+		   SdInstance.AutoCmd23 ? "Auto CMD23 count" : "Auto CMD12 stop");
+
+	return &SdInstance;
+}
+
+/**
+ * @brief	Converts a sector number into the argument of a read command.
+ *
+ * @note	High Capacity cards are addressed by sector and legacy Standard
+ *          Capacity cards by byte. The driver sets the 'HCS' flag during
+ *          initialization.
+ */
+static u32 sd_read_arg(XSdPs *SdInstance, u32 sector)
+{
+	return SdInstance->HCS ? sector : sector * SD_SECTOR_SIZE;
+}
+
+// Block device over the SD driver, for the portable loaders.
+static int sd_blk_read(mw_blkdev *dev, uint32_t sector, uint32_t count, void *buf)
+{
+	XSdPs *SdInstance = dev->priv;
+	int Status;
+
+	Status = XSdPs_ReadPolled(SdInstance, sd_read_arg(SdInstance, sector), count, buf);
+	if (Status != XST_SUCCESS) {
+		xil_printf("ERROR: SDPS ReadPolled failed. Status: %d\r\n", Status);
+		return -1;
+	}
+
+	return 0;
+}
+
+// The list in flight, so that its buffers can be invalidated once it has
+// landed.
+static XSdPs_SgEntry sd_sg[LOADER_PIPE_MAX_SG];
+static u32 sd_sg_count;
+
+static int sd_blk_start_sg(mw_blkdev *dev, const mw_blk_sg *sg, uint32_t count)
+{
+	XSdPs *SdInstance = dev->priv;
+	int Status;
+
+	if (count > LOADER_PIPE_MAX_SG) {
+		return -1;
+	}
+	for (u32 i = 0; i < count; i++) {
+		sd_sg[i].Sector = sg[i].sector;
+		sd_sg[i].Buff = sg[i].buf;
+		sd_sg[i].Length = sg[i].len;
+	}
+	sd_sg_count = count;
+
+	Status = XSdPs_StartReadSG(SdInstance, sd_sg, count);
+	if (Status != XST_SUCCESS) {
+		xil_printf("ERROR: SDPS StartReadSG failed. Status: %d\r\n", Status);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int sd_blk_wait_sg(mw_blkdev *dev)
+{
+	XSdPs *SdInstance = dev->priv;
+	int Status;
+
+	do {
+		Status = XSdPs_CheckReadTransfer(SdInstance);
+	} while (Status == XST_DEVICE_BUSY);
+	if (Status != XST_SUCCESS) {
+		xil_printf("ERROR: SDPS read transfer failed. Status: %d\r\n", Status);
+		return -1;
+	}
+
+	for (u32 i = 0; i < sd_sg_count; i++) {
+		Xil_DCacheInvalidateRange(sd_sg[i].Buff, sd_sg[i].Length);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief	Returns the SD card as a block device, initializing it first.
+ *
+ * @return	The device, or NULL on failure.
+ */
+static mw_blkdev *sd_blkdev(void)
+{
+	static mw_blkdev dev;
+	XSdPs *SdInstance;
+
+	SdInstance = sd_init();
+	if (SdInstance == NULL) {
+		return NULL;
+	}
+
+	dev.max_sectors = XSdPs_GetMaxTransferLen(SdInstance) / SD_SECTOR_SIZE;
+	dev.read = sd_blk_read;
+	dev.start_sg = sd_blk_start_sg;
+	dev.wait_sg = sd_blk_wait_sg;
+	dev.priv = SdInstance;
+
+	return &dev;
+}
+
+static sd_cache sd_small_cache;
+static mw_blkdev *sd_small;	// The cache, or the card if the cache did not fit
+
+/**
+ * @brief	Reads a few sectors of metadata through the read-ahead cache.
+ *
+ * @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+ */
+static int sd_read_small(uint32_t sector, uint32_t count, void *buf)
+{
+	mw_blkdev *dev;
+
+	dev = sd_blkdev();
+	if (dev == NULL) {
+		return XST_FAILURE;
+	}
+
+	if (sd_small == NULL) {
+		sd_small = dev;
+		if (sd_cache_init(&sd_small_cache, dev, (void *)SD_CACHE_BASE, SD_CACHE_LINES,
+				  SD_CACHE_WINDOW, ((XSdPs *)dev->priv)->SectorCount) == 0) {
+			sd_small = &sd_small_cache.dev;
+		}
+	}
+
+	return sd_small->read(sd_small, sector, count, buf) == 0 ? XST_SUCCESS : XST_FAILURE;
+}
+
+/**
+ * @brief	Prints how the small reads fared in the cache.
+ */
+static void sd_cache_print(void)
+{
+	sd_cache_stats *s = &sd_small_cache.stats;
+
+	if (sd_small != &sd_small_cache.dev) {
+		return;
+	}
+	xil_printf("SD cache: %u hits (%u sectors), %u misses, %u bypassed, "
+		   "%u fills (%u sectors)\n\r",
+		   (unsigned int)s->hits, (unsigned int)s->hit_sectors, (unsigned int)s->misses,
+		   (unsigned int)s->bypassed, (unsigned int)s->fills,
+		   (unsigned int)s->fill_sectors);
+}
+
+/**
+ * @brief	Reads the first sectors of the boot image, where either the ELF
+ *          headers or the mw_image header live.
+ *
+ * @param	hdr_buf:          Destination buffer, BOOT_HDR_SECTORS sectors long.
+ * @param	sd_sector_offset: The sector on the SD card where the image starts.
+ *
+ * @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+ */
+static int read_boot_header(uintptr_t hdr_buf, uint32_t sd_sector_offset)
+{
+	uint64_t t0;
+
+	t0 = read_cntpct();
+	if (sd_read_small(sd_sector_offset, BOOT_HDR_SECTORS, (void *)hdr_buf) != XST_SUCCESS) {
+		xil_printf("ERROR: Reading the boot header at sector %u failed.\r\n",
+			   (unsigned int)sd_sector_offset);
+		return XST_FAILURE;
+	}
+	boot_phase_end(MW_BOOT_PHASE_SD_READ, t0, BOOT_HDR_SECTORS * SD_SECTOR_SIZE);
+	warm_note_header(sd_sector_offset, BOOT_HDR_SECTORS, (void *)hdr_buf);
+
+	return XST_SUCCESS;
+}
+
+/**
+ * @brief	Reads a large file (like an ELF) from an SD card to DRAM.
+ *
+ * @param	mem_dst_adr:      The destination address in DRAM.
+ * @param	elf_size_in_byte: The total size of the file to read in bytes.
+ * @param	sd_sector_offset: The starting sector on the SD card to begin reading.
+ *
+ * @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+ *
+ * @note	Files larger than the registered descriptor table allows are
+ *          read in chunks.
+ */
+static int read_elf_from_sd(uintptr_t mem_dst_adr, uint32_t elf_size_in_byte,
+	uint32_t sd_sector_offset)
+{
+	mw_blkdev *dev;
+
+	xil_printf("Starting ELF read from SD card...\r\n");
+
+	dev = sd_blkdev();
+	if (dev == NULL) {
+		return XST_FAILURE;
+	}
+
+	if (read_elf_from_blkdev(dev, mem_dst_adr, elf_size_in_byte, sd_sector_offset) != 0) {
+		return XST_FAILURE;
+	}
+
+	xil_printf("ELF file read from SD card successfully.\r\n");
+	return XST_SUCCESS;
+}
+
+/**
+ * @brief	Checks that XSdPs_ReadSG() takes a list without failing on its
+ *          limits: every run of entries that follow each other on the card
+ *          is one command, which must fit in the SD_DESC_LINES descriptors
+ *          and the 16-bit block count.
+ */
+static int sg_list_fits(const XSdPs_SgEntry *sg, u32 count)
+{
+	u32 lines = 0;
+	u32 blocks = 0;
+
+	for (u32 i = 0; i < count; i++) {
+		if (i != 0 && sg[i].Sector != sg[i - 1].Sector + sg[i - 1].Length / SD_SECTOR_SIZE) {
+			lines = 0;
+			blocks = 0;
+		}
+		lines += (sg[i].Length + SD_DESC_MAX_LENGTH - 1) / SD_DESC_MAX_LENGTH;
+		blocks += sg[i].Length / SD_SECTOR_SIZE;
+		if (lines > SD_DESC_LINES || blocks > XSDPS_BLK_CNT_MASK) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * @brief	Loads the PT_LOAD segments of an ELF file on the SD card straight
+ *          to their final addresses with a single scatter-gather read.
+ *
+ * @param	extract_to_offset: Base address the segment addresses are relative to.
+ * @param	hdr_buf:           Buffer already holding the first BOOT_HDR_SECTORS
+ *                             sectors of the file.
+ * @param	sd_sector_offset:  The sector on the SD card where the ELF file starts.
+ *
+ * @return	XST_SUCCESS if successful, LOAD_NOT_DIRECT if the file layout needs
+ *          the buffered read and extract path, otherwise XST_FAILURE.
+ *
+ * @note	The list comes from elf_direct_sg(), which has the layout rules.
+ */
+static int load_elf_from_sd_direct(uintptr_t extract_to_offset, uintptr_t hdr_buf,
+	uint32_t sd_sector_offset)
+{
+	mw_blk_sg sg[ELF_MAX_SG_SEGMENTS];
+	XSdPs_SgEntry SgList[ELF_MAX_SG_SEGMENTS];
+	u32 SgCount = 0;
+	uint64_t SgBytes = 0;
+	uint64_t t0;
+	XSdPs *SdInstance;
+	int Status;
+
+	SdInstance = sd_init();
+	if (SdInstance == NULL) {
+		return XST_FAILURE;
+	}
+
+	Status = elf_direct_sg(extract_to_offset, hdr_buf, BOOT_HDR_SECTORS * SD_SECTOR_SIZE,
+		sd_sector_offset, sg, ELF_MAX_SG_SEGMENTS, &SgCount);
+	if (Status != 0) {
+		return Status == LOADER_NOT_DIRECT ? LOAD_NOT_DIRECT : XST_FAILURE;
+	}
+	for (u32 i = 0; i < SgCount; i++) {
+		SgList[i].Sector = sg[i].sector;
+		SgList[i].Buff = sg[i].buf;
+		SgList[i].Length = sg[i].len;
+		SgBytes += sg[i].len;
+	}
+
+	// One command per contiguous card range, scattered by the ADMA2 chain.
+	if (!sg_list_fits(SgList, SgCount)) {
+		return LOAD_NOT_DIRECT;
+	}
+	t0 = read_cntpct();
+	Status = XSdPs_ReadSG(SdInstance, SgList, SgCount);
+	if (Status != XST_SUCCESS) {
+		xil_printf("ERROR: SDPS ReadSG failed. Status: %d\r\n", Status);
+		return XST_FAILURE;
+	}
+	boot_phase_end(MW_BOOT_PHASE_SD_READ, t0, SgBytes);
 
-void *my_memcpy(void *dest, const void *src, size_t n) {
-    char *d = dest;
-    const char *s = src;
-    for (size_t i = 0; i < n; i++) {
-        d[i] = s[i];
-    }
-    return dest;
+	elf_direct_finish(extract_to_offset, hdr_buf);
+
+	return XST_SUCCESS;
 }
 
-void *my_memset(void *s, int c, size_t n) {
-    unsigned char *p = s;
-    for (size_t i = 0; i < n; i++) {
-        p[i] = (unsigned char)c;
-    }
-    return s;
+/**
+ * @brief	Loads an mw_image container from the SD card.
+ *
+ * @param	extract_to_offset: Base address the segment addresses are relative to.
+ * @param	hdr_buf:           Buffer already holding the image header and chunk table.
+ * @param	sd_sector_offset:  The sector on the SD card where the image starts.
+ *
+ * @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+ *
+ * @note	The "sd read" phase covers the time spent starting reads and
+ *          waiting for them, and "extract" the CRC checks and decompression
+ *          done while they run.
+ */
+static int load_image_from_sd(uintptr_t extract_to_offset, uintptr_t hdr_buf,
+	uint32_t sd_sector_offset)
+{
+	mw_blkdev *dev;
+
+	dev = sd_blkdev();
+	if (dev == NULL) {
+		return XST_FAILURE;
+	}
+
+	if (load_image_from_blkdev(dev, extract_to_offset, (mw_image_header *)hdr_buf,
+			sd_sector_offset, STREAM_BUF_BASE) != 0) {
+		return XST_FAILURE;
+	}
+
+	return XST_SUCCESS;
 }
 
-// --- Part 3: The ELF Loader and Execution Logic ---
+// --- Digest sidecar for plain ELF files ---
+
+// Kept just past the ELF staging area, which the verified read fills.
+static mw_digest *const digest =
+	(mw_digest *)(ELF_OS_BASE_OFFSET + OS_SIZE_BYTES);
 
 /**
- * @brief Parses an ELF file located in memory, loads its segments, and jumps to its entry point.
- * 
- * @param elf_file_in_memory The starting address of the raw ELF file copied into DRAM.
+ * @brief	Reads and checks the digest sidecar stored after the image window.
+ *
+ * @param	sector: The sector on the SD card where the sidecar starts.
+ *
+ * @return	XST_SUCCESS if a usable digest was read, LOAD_NOT_DIRECT if
+ *          there is none, otherwise XST_FAILURE.
  */
-int load_and_run_elf(uintptr_t extract_to_offset, uintptr_t elf_file_in_memory) {
-    // 1. Point to the ELF header at the start of the file.
-    Elf64_Ehdr *ehdr = (Elf64_Ehdr *)elf_file_in_memory;
+static int read_digest(uint32_t sector)
+{
+	if (sd_read_small(sector, MW_DIGEST_SECTORS, digest) != XST_SUCCESS) {
+		xil_printf("ERROR: Reading the digest sidecar failed.\r\n");
+		return XST_FAILURE;
+	}
+	warm_note_header(sector, MW_DIGEST_SECTORS, digest);
 
-    // 2. Sanity Check: Verify the ELF magic number.
-    if (ehdr->e_ident[0] != ELFMAG0 || ehdr->e_ident[1] != ELFMAG1 ||
-        ehdr->e_ident[2] != ELFMAG2 || ehdr->e_ident[3] != ELFMAG3) {
-        // Not a valid ELF file.
-        return XST_FAILURE;
-    }
-    
-    // 3. Find the Program Header Table.
-    // The main header tells us where the table is (e_phoff) and how many entries it has (e_phnum).
-    Elf64_Phdr *phdr_table = (Elf64_Phdr *)(elf_file_in_memory + ehdr->e_phoff);
-
-    // 4. Iterate through each Program Header.
-    for (int i = 0; i < ehdr->e_phnum; i++) {
-        Elf64_Phdr *phdr = &phdr_table[i];
-
-        // We only care about "LOAD"able segments. These are the ones that
-        // need to be loaded into memory (like .text, .data, .rodata).
-        if (phdr->p_type == PT_LOAD) {
-            // Calculate source and destination addresses.
-            uintptr_t source_address = elf_file_in_memory + phdr->p_offset;
-            uintptr_t dest_address = extract_to_offset + phdr->p_vaddr; // The target VMA!
-
-            // Copy the segment from the file buffer to its final memory location.
-            // p_filesz is the size of the data in the file.
-            my_memcpy((void *)dest_address, (void *)source_address, phdr->p_filesz);
-
-            // The .bss section is handled here. If the memory size is larger
-            // than the file size, the difference is the .bss section, which
-            // must be cleared to zero.
-            if (phdr->p_memsz > phdr->p_filesz) {
-                uintptr_t bss_start = dest_address + phdr->p_filesz;
-                size_t bss_size = phdr->p_memsz - phdr->p_filesz;
-                my_memset((void *)bss_start, 0, bss_size);
-            }
-        }
-    }
+	if (digest->magic != MW_DIGEST_MAGIC) {
+		return LOAD_NOT_DIRECT;
+	}
+
+	return check_digest(digest, OS_SIZE_BYTES) == 0 ? XST_SUCCESS : XST_FAILURE;
+}
+
+/**
+ * @brief	Reads the ELF file described by the digest sidecar, checking
+ *          each chunk while the next ones are being read.
+ *
+ * @param	mem_dst_adr:      Destination address in DRAM.
+ * @param	sd_sector_offset: The sector on the SD card where the file starts.
+ *
+ * @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+ */
+static int read_elf_verified_sd(uintptr_t mem_dst_adr, uint32_t sd_sector_offset)
+{
+	mw_blkdev *dev;
 
-    // // 5. Get the application's entry point from the main header.
-    // uint64_t entry_point_addr = extract_to_offset + ehdr->e_entry;
+	dev = sd_blkdev();
+	if (dev == NULL) {
+		return XST_FAILURE;
+	}
 
-    // // 6. Create a function pointer to the entry point and jump to it.
-    // // This transfers control from the bootloader to the newly loaded application.
-    // void (*application_entry)(void) = (void (*)(void))entry_point_addr;
-    // application_entry();
+	if (read_elf_verified(dev, digest, mem_dst_adr, sd_sector_offset, STREAM_BUF_BASE) != 0) {
+		return XST_FAILURE;
+	}
 
 	return XST_SUCCESS;
 }
 
 /**
- * @brief	Reads a large file (like an ELF) from an SD card to DRAM.
+ * @brief	Loads the kernel image whose first sectors read_boot_header()
+ *          has already put at ELF_OS_BASE_OFFSET.
  *
- * @param	mem_dst_adr:      The destination address in DRAM.
- * @param	elf_size_in_byte: The total size of the file to read in bytes.
- * @param	sd_sector_offset: The starting sector on the SD card to begin reading.
+ * @param	extract_to_offset: Base address the image addresses are relative to.
+ * @param	sd_sector_offset:  The sector on the SD card where the image starts.
+ * @param	entry:             Set to the kernel entry point.
  *
  * @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
  *
- * @note	This function handles files larger than the driver's single-call
- *          transfer limit by reading the file in chunks. It also performs
- *          SD card initialization on its first run.
+ * @note	Compressed mw_image containers are streamed and decompressed;
+ *          uncompressed ones are DMAed straight to their segments. Every
+ *          chunk is checked against its CRC-32C. Plain ELF files with a
+ *          digest sidecar are read and checked chunk by chunk, then
+ *          extracted. Without one they are scattered straight to their
+ *          segments when sector aligned, otherwise read whole and extracted.
  */
-static int read_elf_from_sd(uintptr_t mem_dst_adr, uint32_t elf_size_in_byte,
-	uint32_t sd_sector_offset)
+static int load_kernel_from_sd(uintptr_t extract_to_offset, uint32_t sd_sector_offset,
+	uint64_t *entry)
 {
-	static XSdPs SdInstance;
-	static int SdIsInitialized = 0; // Initialize the driver only once
-	XSdPs_Config *SdConfig;
-	int Status;
-	const u32 SectorSize = 512; // Standard SD sector/block size
-	u32 BytesRemaining;
-	u32 CurrentSectorOffset;
-	uintptr_t CurrentMemAddr;
-	u32 MaxBlocksPerTransfer = MAX_BYTES_PER_TRANSFER / SectorSize;
+	int status;
 
-	xil_printf("Starting ELF read from SD card...\r\n");
-
-	// --- 1. Initialize SD Driver and Card (if not already done) ---
-	if (!SdIsInitialized) {
-		xil_printf("Initializing SDPS driver...\r\n");
-
-		// Look up the device configuration
-#ifndef SDT
-		// Using Device ID from xparameters.h for baremetal flow
-		SdConfig = XSdPs_LookupConfig(XPAR_XSDPS_0_DEVICE_ID);
-#else
-		// Using base address for system device-tree flow
-		SdConfig = XSdPs_LookupConfig(XPAR_XSDPS_0_BASEADDR);
-#endif
-		if (NULL == SdConfig) {
-			xil_printf("ERROR: SDPS LookupConfig failed.\r\n");
+	if (((mw_image_header *)ELF_OS_BASE_OFFSET)->magic == MW_IMAGE_MAGIC) {
+		*entry = ((mw_image_header *)ELF_OS_BASE_OFFSET)->entry;
+		xil_printf("Loading boot image to the DRAM...\n\r");
+		status = load_image_from_sd(extract_to_offset, ELF_OS_BASE_OFFSET, sd_sector_offset);
+		if (status != XST_SUCCESS) {
+			xil_printf("Loading boot image failed.\n\r");
 			return XST_FAILURE;
 		}
+		xil_printf("Successfully loaded boot image to the DRAM!\n\r");
+		return XST_SUCCESS;
+	}
 
-		// Initialize the SDPS driver instance
-		Status = XSdPs_CfgInitialize(&SdInstance, SdConfig, SdConfig->BaseAddress);
-		if (Status != XST_SUCCESS) {
-			xil_printf("ERROR: SDPS CfgInitialize failed. Status: %d\r\n", Status);
+	*entry = ((Elf64_Ehdr *)ELF_OS_BASE_OFFSET)->e_entry;
+	status = read_digest(sd_sector_offset + OS_SIZE_BYTES / SD_SECTOR_SIZE);
+	if (status == XST_SUCCESS) {
+		xil_printf("Downloading and verifying Linux ELF file...\n\r");
+		status = read_elf_verified_sd(ELF_OS_BASE_OFFSET, sd_sector_offset);
+		if (status != XST_SUCCESS) {
+			xil_printf("Verified ELF read failed.\n\r");
 			return XST_FAILURE;
 		}
+		goto EXTRACT;
+	}
+	if (status != LOAD_NOT_DIRECT) {
+		return XST_FAILURE;
+	}
+	xil_printf("WARNING: No digest sidecar, the ELF file is not verified.\n\r");
+	warm_note_unchecked();
+
+	xil_printf("Loading Linux ELF segments directly from the SD card...\n\r");
+	status = load_elf_from_sd_direct(extract_to_offset, ELF_OS_BASE_OFFSET, sd_sector_offset);
+	if (status == XST_SUCCESS) {
+		xil_printf("Successfully loaded ELF segments to the DRAM!\n\r");
+		return XST_SUCCESS;
+	}
+	if (status != LOAD_NOT_DIRECT) {
+		xil_printf("Loading ELF segments from the SD card failed.\n\r");
+		return XST_FAILURE;
+	}
+	xil_printf("ELF layout is not sector aligned, using the buffered path.\n\r");
+
+	xil_printf("Downloading Linux ELF file to the DRAM...\n\r");
+	status = read_elf_from_sd(ELF_OS_BASE_OFFSET, OS_SIZE_BYTES, sd_sector_offset);
+	if (status != XST_SUCCESS) {
+		xil_printf("SD Raw Read failed.\n\r");
+		return XST_FAILURE;
+	}
+	xil_printf("Successfully downloaded ELF file to the DRAM at 0x%08X!\n\r", ELF_OS_BASE_OFFSET);
+
+EXTRACT:
+	xil_printf("Extracting Linux ELF file to the DRAM...\n\r");
+	status = load_and_run_elf(extract_to_offset, ELF_OS_BASE_OFFSET);
+	if (status != XST_SUCCESS) {
+		xil_printf("Extracting ELF file failed.\n\r");
+		return XST_FAILURE;
+	}
+	xil_printf("Successfully extracted ELF file to the DRAM!\n\r");
+
+	return XST_SUCCESS;
+}
+
+// --- Boot manifest ---
+// Raw parts (device tree, initramfs) are read with the pipeline straight
+// to their load addresses (read_blob_from_blkdev()).
+
+static mw_boot_items *const boot_items =
+	(mw_boot_items *)(SHARED_PS_BASE + MW_SHARED_BOOT_ITEMS_OFFSET);
+
+static const char *const boot_item_name[] = { "?", "kernel", "DTB", "initramfs" };
+
+static void boot_item_add(uint32_t type, uint64_t addr, uint64_t size)
+{
+	mw_boot_item *item;
+
+	if (boot_items->count >= MW_BOOT_MAX_ITEMS) {
+		return;
+	}
+	item = &boot_items->item[boot_items->count++];
+	item->type = type;
+	item->reserved = 0;
+	item->addr = addr;
+	item->size = size;
+}
+
+/**
+ * @brief	Reads a raw manifest part to its load address and checks its CRC.
+ *
+ * @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+ */
+static int load_blob_from_sd(uintptr_t extract_to_offset, const mw_manifest_entry *e,
+	uint32_t sd_sector_offset)
+{
+	uintptr_t dst = extract_to_offset + e->load_addr;
+	uint32_t crc;
+	mw_blkdev *dev;
+
+	dev = sd_blkdev();
+	if (dev == NULL) {
+		return XST_FAILURE;
+	}
+
+	if ((e->load_addr & 0x3) != 0 || !mw_range_ok(e->load_addr, e->size)) {
+		xil_printf("ERROR: Bad load address 0x%08X for the %s.\r\n",
+			   (unsigned int)e->load_addr, boot_item_name[e->type]);
+		return XST_FAILURE;
+	}
+
+	if (read_blob_from_blkdev(dev, dst, e->size, sd_sector_offset + e->sector,
+			STREAM_BUF_BASE, &crc) != 0) {
+		return XST_FAILURE;
+	}
+	if (crc != e->crc) {
+		xil_printf("ERROR: CRC mismatch in the %s.\r\n", boot_item_name[e->type]);
+		return XST_FAILURE;
+	}
+	warm_note_segment(dst, e->size, e->size);
+
+	return XST_SUCCESS;
+}
+
+/**
+ * @brief	Checks a boot manifest read from the card.
+ *
+ * @return	XST_SUCCESS if it is usable, otherwise XST_FAILURE.
+ */
+static int check_manifest(mw_manifest *mf)
+{
+	uint32_t crc = mf->hdr_crc;
+	uint32_t kernels = 0;
+
+	mf->hdr_crc = 0;
+	if (crc32_update(0, mf, sizeof(*mf)) != crc) {
+		return XST_FAILURE;
+	}
+	mf->hdr_crc = crc;
 
-		// Perform card initialization sequence
-		Status = XSdPs_CardInitialize(&SdInstance);
-		if (Status != XST_SUCCESS) {
-			xil_printf("ERROR: SDPS CardInitialize failed. Status: %d\r\n", Status);
+	if (mf->version != MW_MANIFEST_VERSION || mf->entry_count == 0 ||
+		mf->entry_count > MW_MANIFEST_MAX_ENTRIES) {
+		return XST_FAILURE;
+	}
+	for (u32 i = 0; i < mf->entry_count; i++) {
+		mw_manifest_entry *e = &mf->entry[i];
+
+		if (e->type < MW_MANIFEST_KERNEL || e->type > MW_MANIFEST_INITRD ||
+			e->sector == 0 || e->size == 0) {
 			return XST_FAILURE;
 		}
-		SdIsInitialized = 1;
-		xil_printf("SDPS driver and card initialized successfully.\r\n");
-	}
-
-	// --- 2. Set up loop variables for chunked reading ---
-	BytesRemaining = elf_size_in_byte;
-	CurrentMemAddr = mem_dst_adr;
-	CurrentSectorOffset = sd_sector_offset;
-
-	xil_printf("Reading %u bytes from sector offset %u to address 0x%X\r\n",
-		   (unsigned int)elf_size_in_byte, (unsigned int)sd_sector_offset, (unsigned int)mem_dst_adr);
-
-	// --- 3. Read loop for handling files larger than 2MB ---
-	while (BytesRemaining > 0) {
-		u32 BlocksToRead;
-		u32 BytesToReadInChunk;
-		u32 ReadArg;
-
-		// Determine the size of the current chunk to read
-		if (BytesRemaining > MAX_BYTES_PER_TRANSFER) {
-			BytesToReadInChunk = MAX_BYTES_PER_TRANSFER;
-			BlocksToRead = MaxBlocksPerTransfer;
-		} else {
-			BytesToReadInChunk = BytesRemaining;
-			// Ceiling division to ensure the last partial block is fully read
-			BlocksToRead = (BytesRemaining + SectorSize - 1) / SectorSize;
+		if (e->type == MW_MANIFEST_KERNEL) {
+			kernels++;
 		}
+	}
+
+	return kernels == 1 ? XST_SUCCESS : XST_FAILURE;
+}
+
+/**
+ * @brief	Loads every part listed in the boot manifest at the start of the card.
+ *
+ * @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+ */
+static int load_manifest_from_sd(uintptr_t extract_to_offset, uint32_t sd_sector_offset)
+{
+	static mw_manifest mf;
+	uint64_t entry = 0;
+	int status;
+
+	my_memcpy(&mf, (void *)ELF_OS_BASE_OFFSET, sizeof(mf));
+	if (check_manifest(&mf) != XST_SUCCESS) {
+		xil_printf("ERROR: Unsupported or corrupt boot manifest.\r\n");
+		return XST_FAILURE;
+	}
+
+	for (u32 i = 0; i < mf.entry_count; i++) {
+		mw_manifest_entry *e = &mf.entry[i];
 
-		// The argument for XSdPs_ReadPolled is a sector address for High Capacity
-		// cards and a byte address for legacy Standard Capacity cards.
-		// The driver sets the 'HCS' flag correctly during initialization.
-		ReadArg = CurrentSectorOffset;
-		if (!(SdInstance.HCS)) {
-			ReadArg *= SectorSize;
+		if (e->type != MW_MANIFEST_KERNEL) {
+			xil_printf("Loading %s (%u bytes) to 0x%08X...\n\r", boot_item_name[e->type],
+				   (unsigned int)e->size, (unsigned int)e->load_addr);
+			status = load_blob_from_sd(extract_to_offset, e, sd_sector_offset);
+			if (status != XST_SUCCESS) {
+				return XST_FAILURE;
+			}
+			boot_item_add(e->type, e->load_addr, e->size);
+			continue;
 		}
 
-		// Perform the read operation for the current chunk
-		Status = XSdPs_ReadPolled(&SdInstance, ReadArg, BlocksToRead,
-					  (u8 *)CurrentMemAddr);
-		if (Status != XST_SUCCESS) {
-			xil_printf("ERROR: SDPS ReadPolled failed at sector %u. Status: %d\r\n",
-				   (unsigned int)CurrentSectorOffset, Status);
+		status = read_boot_header(ELF_OS_BASE_OFFSET, sd_sector_offset + e->sector);
+		if (status != XST_SUCCESS) {
+			xil_printf("Reading the kernel image header failed.\n\r");
 			return XST_FAILURE;
 		}
+		status = load_kernel_from_sd(extract_to_offset, sd_sector_offset + e->sector, &entry);
+		if (status != XST_SUCCESS) {
+			return XST_FAILURE;
+		}
+		boot_item_add(MW_BOOT_ITEM_KERNEL, entry, e->size);
+	}
+
+	return XST_SUCCESS;
+}
+
+/**
+ * @brief	Loads the OS from the SD card into DRAM and records where each
+ *          part went in the shared area.
+ *
+ * @param	extract_to_offset: Base address the image addresses are relative to.
+ * @param	sd_sector_offset:  The sector on the SD card where the boot data starts.
+ *
+ * @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+ *
+ * @note	The card holds either a boot manifest listing the kernel, device
+ *          tree and initramfs, or just a kernel image.
+ */
+static int load_os_from_sd(uintptr_t extract_to_offset, uint32_t sd_sector_offset)
+{
+	uint64_t entry = 0;
+	int status;
+
+	warm_record_clear();
+	boot_items->magic = 0;
+	boot_items->count = 0;
+
+	status = read_boot_header(ELF_OS_BASE_OFFSET, sd_sector_offset);
+	if (status != XST_SUCCESS) {
+		xil_printf("Reading the boot image header failed.\n\r");
+		return XST_FAILURE;
+	}
 
-		// Update counters for the next iteration
-		BytesRemaining -= BytesToReadInChunk;
-		CurrentMemAddr += (BlocksToRead * SectorSize); // Advance pointer by bytes read
-		CurrentSectorOffset += BlocksToRead;           // Advance sector offset
+	if (((mw_manifest *)ELF_OS_BASE_OFFSET)->magic == MW_MANIFEST_MAGIC) {
+		xil_printf("Loading the parts listed in the boot manifest...\n\r");
+		status = load_manifest_from_sd(extract_to_offset, sd_sector_offset);
+	} else {
+		status = load_kernel_from_sd(extract_to_offset, sd_sector_offset, &entry);
+		boot_item_add(MW_BOOT_ITEM_KERNEL, entry, 0);
+	}
+	if (status != XST_SUCCESS) {
+		return XST_FAILURE;
 	}
+	boot_items->magic = MW_BOOT_ITEMS_MAGIC;
+
+	return XST_SUCCESS;
+}
+
+// --- Kernel handoff ---
+
+static mw_boot_info *const boot_info =
+	(mw_boot_info *)(SHARED_PS_BASE + MW_SHARED_BOOT_INFO_OFFSET);
+
+/**
+ * @brief	Tells the Microwatt firmware where to enter the kernel and which
+ *          device tree to pass it, from the boot items of the last cold
+ *          boot, which a warm restart keeps.
+ *
+ * @return	XST_SUCCESS if successful, XST_FAILURE if no kernel was loaded.
+ */
+static int boot_info_publish(void)
+{
+	boot_info->magic = 0;
+	boot_info->flags = AUTOBOOT ? MW_BOOT_INFO_AUTOBOOT : 0;
+	boot_info->entry = 0;
+	boot_info->dtb = 0;
+
+	if (boot_items->magic != MW_BOOT_ITEMS_MAGIC) {
+		return XST_FAILURE;
+	}
+	for (u32 i = 0; i < boot_items->count && i < MW_BOOT_MAX_ITEMS; i++) {
+		const mw_boot_item *item = &boot_items->item[i];
+
+		if (item->type == MW_BOOT_ITEM_KERNEL) {
+			boot_info->entry = item->addr;
+		} else if (item->type == MW_BOOT_ITEM_DTB) {
+			boot_info->dtb = item->addr;
+		}
+	}
+	if (boot_info->entry == 0) {
+		return XST_FAILURE;
+	}
+	boot_info->magic = MW_BOOT_INFO_MAGIC;
+	Xil_DCacheFlushRange((INTPTR)boot_info, sizeof(*boot_info));
 
-	xil_printf("ELF file read from SD card successfully.\r\n");
 	return XST_SUCCESS;
 }
 
+// --- Memory console ---
+
+static mw_console *const console_ring =
+	(mw_console *)(SHARED_PS_BASE + MW_SHARED_CONSOLE_OFFSET);
+
+/**
+ * @brief	Sets up an empty console ring for Microwatt to find at release.
+ */
+static void console_ring_init(void)
+{
+	my_memset(console_ring, 0, offsetof(mw_console, data));
+	console_ring->size = MW_CONSOLE_DATA_SIZE;
+	console_ring->magic = MW_CONSOLE_MAGIC;
+	Xil_DCacheFlushRange((INTPTR)console_ring, offsetof(mw_console, data));
+}
+
+/**
+ * @brief	Copies up to CONSOLE_RING_BURST bytes that Microwatt wrote to the
+ *          console ring to stdout, and hands the space back.
+ *
+ * @return	1 if there were any, 0 if the ring was empty.
+ */
+static int console_ring_poll(uint32_t *tail)
+{
+	uint32_t head;
+	uint32_t n;
+
+	Xil_DCacheInvalidateRange((INTPTR)&console_ring->head, MW_CONSOLE_LINE);
+	head = console_ring->head;
+	if (head == *tail) {
+		return 0;
+	}
+
+	n = head - *tail;
+	if (n > CONSOLE_RING_BURST) {
+		n = CONSOLE_RING_BURST;
+	}
+	for (uint32_t i = 0; i < n; i++) {
+		uint32_t idx = (*tail + i) & (MW_CONSOLE_DATA_SIZE - 1);
+
+		if (i == 0 || idx % MW_CONSOLE_LINE == 0) {
+			Xil_DCacheInvalidateRange((INTPTR)&console_ring->data[idx & ~(MW_CONSOLE_LINE - 1)],
+						  MW_CONSOLE_LINE);
+		}
+		outbyte((char)console_ring->data[idx]);
+	}
+
+	*tail += n;
+	console_ring->tail = *tail;
+	Xil_DCacheFlushRange((INTPTR)&console_ring->tail, MW_CONSOLE_LINE);
+	return 1;
+}
+
+// --- Bulk-init mailbox ---
+
+static mw_bulk *const bulk_box =
+	(mw_bulk *)(SHARED_PS_BASE + MW_SHARED_BULK_OFFSET);
+
+/**
+ * @brief	Sets up an idle mailbox for Microwatt to find at release, or
+ *          clears the one a previous run may have left when BULK_MAILBOX
+ *          is off.
+ */
+static void bulk_box_init(void)
+{
+	my_memset(bulk_box, 0, sizeof(*bulk_box));
+	bulk_box->magic = BULK_MAILBOX ? MW_BULK_MAGIC : 0;
+	Xil_DCacheFlushRange((INTPTR)bulk_box, sizeof(*bulk_box));
+}
+
+/**
+ * @brief	Does the request Microwatt posted in the mailbox, if any. Only
+ *          ranges inside the Microwatt/Linux memory are accepted, which
+ *          keeps the shared area and the warm snapshot out of reach.
+ *
+ * @return	1 if there was a request, 0 otherwise.
+ */
+static int bulk_box_poll(void)
+{
+	uint32_t seq;
+	uint64_t dst;
+	uint64_t src;
+	uint64_t len;
+	int32_t status = -1;
+
+	Xil_DCacheInvalidateRange((INTPTR)&bulk_box->seq, MW_CONSOLE_LINE);
+	seq = bulk_box->seq;
+	if (seq == bulk_box->done) {
+		return 0;
+	}
+
+	dst = bulk_box->dst;
+	src = bulk_box->src;
+	len = bulk_box->len;
+	if (mw_range_ok(dst, len)) {
+		if (bulk_box->op == MW_BULK_OP_ZERO) {
+			my_memset((void *)(PS_DRAM_BASE_OFFSET + dst), 0, len);
+			status = 0;
+		} else if (bulk_box->op == MW_BULK_OP_COPY && mw_range_ok(src, len)) {
+			my_memcpy((void *)(PS_DRAM_BASE_OFFSET + dst),
+				(const void *)(PS_DRAM_BASE_OFFSET + src), len);
+			status = 0;
+		}
+		Xil_DCacheFlushRange((INTPTR)(PS_DRAM_BASE_OFFSET + dst), len);
+	}
+
+	// The data before the reply, and the reply before done
+	bulk_box->status = status;
+	__asm__ volatile("dsb sy" : : : "memory");
+	bulk_box->done = seq;
+	Xil_DCacheFlushRange((INTPTR)&bulk_box->done, MW_CONSOLE_LINE);
+	return 1;
+}
+
+/**
+ * @brief	Serves the console ring and the bulk-init mailbox for as long as
+ *          either is set up. Takes the place of the idle loop after the
+ *          release.
+ */
+static void microwatt_service(void)
+{
+	uint32_t tail = 0;
+
+	for (;;) {
+		int active = 0;
+		int busy = 0;
+
+#if CONSOLE_RING
+		if (console_ring->magic == MW_CONSOLE_MAGIC) {
+			active = 1;
+			busy |= console_ring_poll(&tail);
+		}
+#endif
+		if (bulk_box->magic == MW_BULK_MAGIC) {
+			active = 1;
+			busy |= bulk_box_poll();
+		}
+		if (!active) {
+			return;
+		}
+		if (!busy) {
+			usleep(SERVICE_IDLE_US);
+		}
+	}
+}
+
 static int prog_mem_directly(uintptr_t mem_dst_adr, void *prog,
 	uint32_t prog_size_in_byte) {
 
@@ -272,50 +1406,77 @@ static int prog_mem_directly(uintptr_t mem_dst_adr, void *prog,
 
 int main() {
     Xil_DCacheDisable();
+    // Hold Microwatt in reset while its memory is rewritten (it may still be
+    // running when the bootloader is rerun for a warm restart).
+    Xil_Out32(CTR_REG, 0x0);
 
 	int status = 0;
+	uint64_t t0;
 	uint64_t program[] = { 
 		#include "mw_welcome_c_ver.hex" 
 	};
 	uint32_t program_size = sizeof(program);
+
+	boot_stats_init();
+#if CONSOLE_RING
+	console_ring_init();
+#endif
+	bulk_box_init();
 //-----------------------------------------------------------------------------
 	xil_printf("Downloading bootloader to the DRAM...\n\r");
+	t0 = read_cntpct();
 	status = prog_mem_directly(PS_DRAM_BASE_OFFSET, program, program_size);
 	if (status != XST_SUCCESS) {
 		xil_printf("Failed to program memory with the bootloader.\n\r");
 		return XST_FAILURE;
 	}
+	boot_phase_end(MW_BOOT_PHASE_FW_COPY, t0, program_size);
 	xil_printf("Successfully downloaded bootloader to the DRAM at 0x%08X!\n\r", PS_DRAM_BASE_OFFSET);
 //-----------------------------------------------------------------------------
-	xil_printf("Downloading Linux ELF file to the DRAM...\n\r");
-	status = read_elf_from_sd(ELF_OS_BASE_OFFSET, OS_SIZE_BYTES, SECTOR_OFFSET);
-	if (status != XST_SUCCESS) {
-		xil_printf("SD Raw Read failed.\n\r");
-		return XST_FAILURE;
+	status = XST_FAILURE;
+#if WARM_RESTART
+	status = warm_restore();
+	if (status == XST_SUCCESS) {
+		xil_printf("Warm restart: restored Linux from the DRAM snapshot, SD card skipped.\n\r");
 	}
-	xil_printf("Successfully downloaded ELF file to the DRAM at 0x%08X!\n\r", ELF_OS_BASE_OFFSET);
-//-----------------------------------------------------------------------------
-	xil_printf("Extracting Linux ELF file to the DRAM...\n\r");
-	status = load_and_run_elf(PS_DRAM_BASE_OFFSET, ELF_OS_BASE_OFFSET);
+#endif
 	if (status != XST_SUCCESS) {
-		xil_printf("Extracting ELF file failed.\n\r");
-		return XST_FAILURE;
+		status = load_os_from_sd(PS_DRAM_BASE_OFFSET, SECTOR_OFFSET);
+		if (status != XST_SUCCESS) {
+			return XST_FAILURE;
+		}
+#if WARM_RESTART
+		warm_snapshot_save();
+#endif
 	}
-	xil_printf("Successfully extracted ELF file to the DRAM!\n\r");
 //-----------------------------------------------------------------------------
 	xil_printf("Configuring Microwatt for booting...\n\r");
+	t0 = read_cntpct();
+	if (boot_info_publish() == XST_SUCCESS) {
+		xil_printf("Kernel entry 0x%08X, DTB 0x%08X%s.\n\r", (unsigned int)boot_info->entry,
+			   (unsigned int)boot_info->dtb, AUTOBOOT ? ", autoboot" : "");
+	} else {
+		xil_printf("No kernel entry recorded, Microwatt uses its default.\n\r");
+	}
 	Xil_Out32(MEM_REG, PS_DRAM_BASE_OFFSET);
 	if (Xil_In32(MEM_REG) != PS_DRAM_BASE_OFFSET ||
 		Xil_In32(VER_REG) != CUR_VER) {
 		xil_printf("Failed to configure Microwatt properly!\n\r");
 		return XST_FAILURE;
 	}
+	boot_phase_end(MW_BOOT_PHASE_RELEASE, t0, 0);
 	xil_printf("Successfully configured Microwatt!\n\r");
+//-----------------------------------------------------------------------------
+	// Microwatt shares the UART, so the table goes out before it runs.
+	boot_stats->release = read_cntpct();
+	boot_stats_print();
+	sd_cache_print();
 //-----------------------------------------------------------------------------
 	xil_printf("Booting up Microwatt from bootloader at 0x%p...\n\r", PS_DRAM_BASE_OFFSET);
     xil_printf("--------------------------------------------------\n\r\n\r");
     Xil_Out32(CTR_REG, 0x1);
 //-----------------------------------------------------------------------------
+    microwatt_service();
     while (1) { __asm__("wfi"); }
 
     return 0;
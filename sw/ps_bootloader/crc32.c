@@ -0,0 +1,94 @@
+#include "crc32.h"
+
+#define CRC32_POLY	0xEDB88320U
+#define CRC32C_POLY	0x82F63B78U
+
+static uint32_t crc32_table[256];
+static int crc32_table_ready = 0;
+
+// Built on first use; the tables live in .bss rather than .rodata.
+static void crc_init_table(uint32_t *table, uint32_t poly)
+{
+	for (uint32_t i = 0; i < 256U; i++) {
+		uint32_t crc = i;
+
+		for (int k = 0; k < 8; k++) {
+			crc = (crc >> 1) ^ (poly & (0U - (crc & 1U)));
+		}
+		table[i] = crc;
+	}
+}
+
+uint32_t crc32_update(uint32_t crc, const void *buf, uint32_t len)
+{
+	const uint8_t *p = buf;
+
+	if (!crc32_table_ready) {
+		crc_init_table(crc32_table, CRC32_POLY);
+		crc32_table_ready = 1;
+	}
+
+	crc = ~crc;
+	while (len--) {
+		crc = (crc >> 8) ^ crc32_table[(crc ^ *p++) & 0xFFU];
+	}
+
+	return ~crc;
+}
+
+#if defined(__aarch64__)
+
+static inline uint32_t crc32c_u8(uint32_t crc, uint8_t v)
+{
+	__asm__(".arch_extension crc\n\tcrc32cb %w0, %w0, %w1" : "+r"(crc) : "r"(v));
+	return crc;
+}
+
+static inline uint32_t crc32c_u64(uint32_t crc, uint64_t v)
+{
+	__asm__(".arch_extension crc\n\tcrc32cx %w0, %w0, %x1" : "+r"(crc) : "r"(v));
+	return crc;
+}
+
+uint32_t crc32c_update(uint32_t crc, const void *buf, uint32_t len)
+{
+	const uint8_t *p = buf;
+
+	crc = ~crc;
+	while (len > 0 && ((uintptr_t)p & 7U) != 0) {
+		crc = crc32c_u8(crc, *p++);
+		len--;
+	}
+	for (; len >= 8; len -= 8, p += 8) {
+		crc = crc32c_u64(crc, *(const uint64_t *)p);
+	}
+	while (len--) {
+		crc = crc32c_u8(crc, *p++);
+	}
+
+	return ~crc;
+}
+
+#else
+
+static uint32_t crc32c_table[256];
+static int crc32c_table_ready = 0;
+
+uint32_t crc32c_update(uint32_t crc, const void *buf, uint32_t len)
+{
+	const uint8_t *p = buf;
+
+	if (!crc32c_table_ready) {
+		crc_init_table(crc32c_table, CRC32C_POLY);
+		crc32c_table_ready = 1;
+	}
+
+	crc = ~crc;
+	while (len--) {
+		crc = (crc >> 8) ^ crc32c_table[(crc ^ *p++) & 0xFFU];
+	}
+
+	return ~crc;
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef __CRC32_H
+#define __CRC32_H
+
+#include <stdint.h>
+
+/*
+ * CRC-32 checksums shared by the bootloader and mwpack. For both, pass 0
+ * as crc for the first block and the previous result to continue over
+ * further blocks.
+ *
+ * crc32_update:  CRC-32 (IEEE 802.3, reflected, polynomial 0xEDB88320),
+ *                used for headers.
+ * crc32c_update: CRC-32C (Castagnoli, reflected, polynomial 0x82F63B78),
+ *                used for image data and the warm-restart snapshot. On
+ *                AArch64 it runs on the ARMv8 CRC32 instructions, eight
+ *                bytes per instruction.
+ */
+uint32_t crc32_update(uint32_t crc, const void *buf, uint32_t len);
+uint32_t crc32c_update(uint32_t crc, const void *buf, uint32_t len);
+
+#endif /* __CRC32_H */
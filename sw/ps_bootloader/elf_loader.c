@@ -0,0 +1,182 @@
+#include <stdint.h>
+#include "elf_loader.h"
+#include "image_loader.h" // mw_range_ok()
+#include "mw_shared.h"	 // MW_BOOT_PHASE_*
+
+int read_elf_from_blkdev(mw_blkdev *dev, uintptr_t mem_dst, uint32_t size,
+	uint32_t sector)
+{
+	uint32_t bytes_remaining = size;
+	uint32_t max_bytes = dev->max_sectors * LOADER_SECTOR_SIZE;
+	uintptr_t mem = mem_dst;
+	uint64_t t0;
+
+	loader_printf("Reading %u bytes from sector offset %u to address 0x%X\r\n",
+		      (unsigned int)size, (unsigned int)sector, (unsigned int)mem_dst);
+
+	// Read loop for files larger than one transfer
+	t0 = loader_time();
+	while (bytes_remaining > 0) {
+		uint32_t blocks;
+		uint32_t bytes;
+
+		// Determine the size of the current chunk to read
+		if (bytes_remaining > max_bytes) {
+			bytes = max_bytes;
+			blocks = dev->max_sectors;
+		} else {
+			bytes = bytes_remaining;
+			// Ceiling division to ensure the last partial block is fully read
+			blocks = (bytes_remaining + LOADER_SECTOR_SIZE - 1) / LOADER_SECTOR_SIZE;
+		}
+
+		if (dev->read(dev, sector, blocks, (void *)mem) != 0) {
+			loader_printf("ERROR: Read failed at sector %u.\r\n", (unsigned int)sector);
+			return -1;
+		}
+
+		// Update counters for the next iteration
+		bytes_remaining -= bytes;
+		mem += blocks * LOADER_SECTOR_SIZE;	// Advance pointer by bytes read
+		sector += blocks;			// Advance sector offset
+	}
+	loader_phase_end(MW_BOOT_PHASE_SD_READ, t0, size);
+
+	return 0;
+}
+
+int load_and_run_elf(uintptr_t extract_to_offset, uintptr_t elf_file_in_memory) {
+    uint64_t t0 = loader_time();
+    uint64_t bytes = 0;
+
+    // 1. Point to the ELF header at the start of the file.
+    Elf64_Ehdr *ehdr = (Elf64_Ehdr *)elf_file_in_memory;
+
+    // 2. Sanity Check: Verify the ELF magic number.
+    if (ehdr->e_ident[0] != ELFMAG0 || ehdr->e_ident[1] != ELFMAG1 ||
+        ehdr->e_ident[2] != ELFMAG2 || ehdr->e_ident[3] != ELFMAG3) {
+        // Not a valid ELF file.
+        return -1;
+    }
+
+    // 3. Find the Program Header Table.
+    // The main header tells us where the table is (e_phoff) and how many entries it has (e_phnum).
+    Elf64_Phdr *phdr_table = (Elf64_Phdr *)(elf_file_in_memory + ehdr->e_phoff);
+
+    // 4. Iterate through each Program Header.
+    for (int i = 0; i < ehdr->e_phnum; i++) {
+        Elf64_Phdr *phdr = &phdr_table[i];
+
+        // We only care about "LOAD"able segments. These are the ones that
+        // need to be loaded into memory (like .text, .data, .rodata).
+        if (phdr->p_type == PT_LOAD) {
+            // Calculate source and destination addresses.
+            uintptr_t source_address = elf_file_in_memory + phdr->p_offset;
+            uintptr_t dest_address = extract_to_offset + phdr->p_vaddr; // The target VMA!
+
+            loader_note_segment(dest_address, phdr->p_filesz, phdr->p_memsz);
+
+            // Copy the segment from the file buffer to its final memory location.
+            // p_filesz is the size of the data in the file.
+            loader_copy(dest_address, source_address, phdr->p_filesz);
+            bytes += phdr->p_filesz;
+
+            // The .bss section is handled here. If the memory size is larger
+            // than the file size, the difference is the .bss section, which
+            // must be cleared to zero.
+            if (phdr->p_memsz > phdr->p_filesz) {
+                uintptr_t bss_start = dest_address + phdr->p_filesz;
+                size_t bss_size = phdr->p_memsz - phdr->p_filesz;
+                loader_copy(bss_start, 0, bss_size);
+                bytes += bss_size;
+            }
+        }
+    }
+    loader_phase_end(MW_BOOT_PHASE_EXTRACT, t0, bytes);
+
+    // // 5. Get the application's entry point from the main header.
+    // uint64_t entry_point_addr = extract_to_offset + ehdr->e_entry;
+
+    // // 6. Create a function pointer to the entry point and jump to it.
+    // // This transfers control from the bootloader to the newly loaded application.
+    // void (*application_entry)(void) = (void (*)(void))entry_point_addr;
+    // application_entry();
+
+	return 0;
+}
+
+int elf_direct_sg(uintptr_t extract_to_offset, uintptr_t hdr_buf, uint32_t hdr_size,
+	uint32_t sector, mw_blk_sg *sg, uint32_t max_sg, uint32_t *count)
+{
+	Elf64_Ehdr *ehdr = (Elf64_Ehdr *)hdr_buf;
+	Elf64_Phdr *phdr_table;
+
+	if (ehdr->e_ident[0] != ELFMAG0 || ehdr->e_ident[1] != ELFMAG1 ||
+		ehdr->e_ident[2] != ELFMAG2 || ehdr->e_ident[3] != ELFMAG3) {
+		return -1;
+	}
+	if (ehdr->e_phentsize != sizeof(Elf64_Phdr) ||
+		ehdr->e_phoff + (uint64_t)ehdr->e_phnum * sizeof(Elf64_Phdr) > hdr_size) {
+		return LOADER_NOT_DIRECT;
+	}
+
+	// Every loadable segment becomes one scatter-gather entry.
+	*count = 0;
+	phdr_table = (Elf64_Phdr *)(hdr_buf + ehdr->e_phoff);
+	for (int i = 0; i < ehdr->e_phnum; i++) {
+		Elf64_Phdr *phdr = &phdr_table[i];
+		uint64_t padded_size;
+
+		if (phdr->p_type != PT_LOAD) {
+			continue;
+		}
+		if (phdr->p_filesz > phdr->p_memsz || !mw_range_ok(phdr->p_vaddr, phdr->p_memsz)) {
+			loader_printf("ERROR: ELF segment at 0x%08X (%u bytes) is outside the Linux memory.\r\n",
+				      (unsigned int)phdr->p_vaddr, (unsigned int)phdr->p_memsz);
+			return -1;
+		}
+		if (phdr->p_filesz == 0) {
+			continue;
+		}
+
+		padded_size = (phdr->p_filesz + LOADER_SECTOR_SIZE - 1) &
+			~(uint64_t)(LOADER_SECTOR_SIZE - 1);
+		if (*count == max_sg ||
+			(phdr->p_offset % LOADER_SECTOR_SIZE) != 0 ||
+			((extract_to_offset + phdr->p_vaddr) & 0x3) != 0 ||
+			(padded_size != phdr->p_filesz && padded_size > phdr->p_memsz)) {
+			return LOADER_NOT_DIRECT;
+		}
+
+		sg[*count].sector = sector + (uint32_t)(phdr->p_offset / LOADER_SECTOR_SIZE);
+		sg[*count].len = (uint32_t)padded_size;
+		sg[*count].buf = extract_to_offset + phdr->p_vaddr;
+		(*count)++;
+	}
+
+	return 0;
+}
+
+void elf_direct_finish(uintptr_t extract_to_offset, uintptr_t hdr_buf)
+{
+	Elf64_Ehdr *ehdr = (Elf64_Ehdr *)hdr_buf;
+	Elf64_Phdr *phdr_table = (Elf64_Phdr *)(hdr_buf + ehdr->e_phoff);
+	uint64_t t0 = loader_time();
+	uint64_t bytes = 0;
+
+	// Clearing .bss also wipes the sector padding read past p_filesz.
+	for (int i = 0; i < ehdr->e_phnum; i++) {
+		Elf64_Phdr *phdr = &phdr_table[i];
+		uintptr_t dst = extract_to_offset + phdr->p_vaddr;
+
+		if (phdr->p_type != PT_LOAD) {
+			continue;
+		}
+		loader_note_segment(dst, phdr->p_filesz, phdr->p_memsz);
+		if (phdr->p_memsz > phdr->p_filesz) {
+			loader_copy(dst + phdr->p_filesz, 0, phdr->p_memsz - phdr->p_filesz);
+			bytes += phdr->p_memsz - phdr->p_filesz;
+		}
+	}
+	loader_phase_end(MW_BOOT_PHASE_EXTRACT, t0, bytes);
+}
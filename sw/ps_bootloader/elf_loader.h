@@ -0,0 +1,159 @@
+#ifndef __ELF_LOADER_H
+#define __ELF_LOADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Portable part of the ELF boot path
+ *
+ * Reads an ELF file from a block device into a staging buffer and copies
+ * its loadable segments to their place. Nothing in here touches the SD
+ * controller or the A53 directly, so the same code runs in the bootloader
+ * and in the host benchmark (sw/host). The surroundings are supplied by
+ * the build through an mw_blkdev and the loader_* hooks below.
+ *
+ * Addresses are plain pointers cast to uintptr_t. On the board they are
+ * physical addresses; on the host they point into a buffer standing in
+ * for DRAM.
+ */
+
+// --- ELF Header Definitions for a 64-bit system ---
+// These structures must match the ELF64 specification.
+
+#define EI_NIDENT 16
+
+// ELF Header (Ehdr)
+typedef struct {
+    unsigned char e_ident[EI_NIDENT]; // Magic number and other info
+    uint16_t      e_type;             // Object file type
+    uint16_t      e_machine;          // Architecture
+    uint32_t      e_version;          // Object file version
+    uint64_t      e_entry;            // Entry point virtual address
+    uint64_t      e_phoff;            // Program header table file offset
+    uint64_t      e_shoff;            // Section header table file offset
+    uint32_t      e_flags;            // Processor-specific flags
+    uint16_t      e_ehsize;           // ELF header size in bytes
+    uint16_t      e_phentsize;        // Program header table entry size
+    uint16_t      e_phnum;            // Program header table entry count
+    uint16_t      e_shentsize;        // Section header table entry size
+    uint16_t      e_shnum;            // Section header table entry count
+    uint16_t      e_shstrndx;         // Section header string table index
+} Elf64_Ehdr;
+
+// Program Header (Phdr)
+typedef struct {
+    uint32_t p_type;   // Segment type
+    uint32_t p_flags;  // Segment flags
+    uint64_t p_offset; // Segment file offset
+    uint64_t p_vaddr;  // Segment virtual address
+    uint64_t p_paddr;  // Segment physical address
+    uint64_t p_filesz; // Segment size in file
+    uint64_t p_memsz;  // Segment size in memory
+    uint64_t p_align;  // Segment alignment
+} Elf64_Phdr;
+
+// ELF segment types
+#define PT_NULL    0
+#define PT_LOAD    1 // Identifies a loadable segment
+
+// ELF magic number
+#define ELFMAG0 0x7f
+#define ELFMAG1 'E'
+#define ELFMAG2 'L'
+#define ELFMAG3 'F'
+
+#define LOADER_SECTOR_SIZE	512U
+
+/*
+ * One piece of a scatter-gather read: len bytes (whole sectors) from
+ * sector to buf.
+ */
+typedef struct {
+	uint32_t sector;
+	uint32_t len;
+	uintptr_t buf;
+} mw_blk_sg;
+
+/*
+ * A card or card image. read() fills buf with count sectors starting at
+ * sector and returns 0, or returns -1 on error. max_sectors is the
+ * largest count a single call accepts.
+ *
+ * start_sg() starts a read of a list whose entries follow each other on
+ * the card and returns at once; wait_sg() returns when it has landed.
+ * Both return 0, or -1 on error. Devices that cannot read in the
+ * background leave them NULL and the pipelined loaders (image_loader.h)
+ * fall back to read().
+ */
+typedef struct mw_blkdev mw_blkdev;
+struct mw_blkdev {
+	uint32_t max_sectors;
+	int (*read)(mw_blkdev *dev, uint32_t sector, uint32_t count, void *buf);
+	int (*start_sg)(mw_blkdev *dev, const mw_blk_sg *sg, uint32_t count);
+	int (*wait_sg)(mw_blkdev *dev);
+	void *priv;
+};
+
+/**
+ * @brief	Reads size bytes of an ELF file, starting at sector, to mem_dst.
+ *          The last sector is read whole.
+ *
+ * @return	0 if successful, -1 otherwise.
+ */
+int read_elf_from_blkdev(mw_blkdev *dev, uintptr_t mem_dst, uint32_t size,
+	uint32_t sector);
+
+#define LOADER_NOT_DIRECT	1	// Layout needs the buffered read and extract path
+
+/**
+ * @brief	Turns the PT_LOAD segments of the ELF file whose first hdr_size
+ *          bytes are at hdr_buf into a scatter-gather list that reads each
+ *          one from the card straight to extract_to_offset + p_vaddr.
+ *
+ * @return	0 with count entries in sg, LOADER_NOT_DIRECT if the layout
+ *          does not allow it, -1 if the file is not an ELF file or a
+ *          segment lies outside the Linux memory.
+ *
+ * @note	Each segment must start on a sector boundary in the file. Its
+ *          size is rounded up to whole sectors, so the rounding must land
+ *          in the segment's own .bss, which elf_direct_finish() clears once
+ *          the list has been read. Entries need not follow each other on
+ *          the card.
+ */
+int elf_direct_sg(uintptr_t extract_to_offset, uintptr_t hdr_buf, uint32_t hdr_size,
+	uint32_t sector, mw_blk_sg *sg, uint32_t max_sg, uint32_t *count);
+void elf_direct_finish(uintptr_t extract_to_offset, uintptr_t hdr_buf);
+
+/**
+ * @brief	Copies the PT_LOAD segments of the ELF file at elf_file_in_memory
+ *          to extract_to_offset + p_vaddr and clears their .bss.
+ *
+ * @return	0 if successful, -1 if the file is not an ELF file.
+ */
+int load_and_run_elf(uintptr_t extract_to_offset, uintptr_t elf_file_in_memory);
+
+/*
+ * Hooks supplied by the build (bootloader.c on the board, sw/host on a PC).
+ *
+ * loader_copy():         Copies len bytes, or clears them when src is 0.
+ * loader_note_segment(): Called for every segment placed in memory.
+ * loader_time():         Free-running timestamp for loader_phase_end().
+ * loader_phase_end():    Accounts the time since start and the bytes moved
+ *                        to an MW_BOOT_PHASE_* phase.
+ * loader_printf():       Console output.
+ */
+void loader_copy(uintptr_t dst, uintptr_t src, size_t len);
+void loader_note_segment(uintptr_t dst, uint64_t file_size, uint64_t mem_size);
+uint64_t loader_time(void);
+void loader_phase_end(uint32_t phase, uint64_t start, uint64_t bytes);
+
+#ifdef MW_HOST
+#include <stdio.h>
+#define loader_printf		printf
+#else
+#include "xil_printf.h"
+#define loader_printf		xil_printf
+#endif
+
+#endif /* __ELF_LOADER_H */
@@ -0,0 +1,609 @@
+#include <stdint.h>
+#include "image_loader.h"
+#include "mw_shared.h"	 // MW_BOOT_PHASE_*, MW_LINUX_MEM_SIZE
+#include "crc32.h"
+#include "lz4.h"
+
+int mw_range_ok(uint64_t addr, uint64_t size)
+{
+	return addr < MW_LINUX_MEM_SIZE && size <= MW_LINUX_MEM_SIZE - addr;
+}
+
+int check_image_header(mw_image_header *hdr)
+{
+	const mw_image_chunk *chunks = mw_image_chunks(hdr);
+	uint32_t chunk_total = 0;
+	uint32_t crc = hdr->hdr_crc;
+
+	if (hdr->version != MW_IMAGE_VERSION || hdr->hdr_sectors > MW_IMAGE_HDR_MAX_SECTORS) {
+		return -1;
+	}
+
+	// The CRC is computed with its own field zeroed.
+	hdr->hdr_crc = 0;
+	if (crc32_update(0, hdr, hdr->hdr_sectors * LOADER_SECTOR_SIZE) != crc) {
+		loader_printf("ERROR: Boot image header CRC mismatch.\r\n");
+		return -1;
+	}
+	hdr->hdr_crc = crc;
+
+	if (hdr->seg_count > MW_IMAGE_MAX_SEGMENTS ||
+		hdr->chunk_count > MW_IMAGE_MAX_CHUNKS ||
+		hdr->chunk_size == 0 ||
+		(hdr->comp != MW_IMAGE_COMP_NONE && hdr->comp != MW_IMAGE_COMP_LZ4)) {
+		return -1;
+	}
+
+	// The chunk table must lie inside the header sectors the CRC covers.
+	if ((uint64_t)hdr->hdr_sectors * LOADER_SECTOR_SIZE <
+		sizeof(mw_image_header) + (uint64_t)hdr->chunk_count * sizeof(mw_image_chunk)) {
+		return -1;
+	}
+
+	// Segments must own consecutive runs of the chunk table and lie in the
+	// Linux memory.
+	for (uint32_t i = 0; i < hdr->seg_count; i++) {
+		const mw_image_segment *seg = &hdr->seg[i];
+
+		if (seg->first_chunk != chunk_total ||
+			seg->chunk_count > hdr->chunk_count - chunk_total ||
+			seg->file_size > seg->mem_size ||
+			seg->file_size > (uint64_t)seg->chunk_count * hdr->chunk_size ||
+			!mw_range_ok(seg->load_addr, seg->mem_size)) {
+			return -1;
+		}
+		chunk_total += seg->chunk_count;
+	}
+	if (chunk_total != hdr->chunk_count) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < hdr->chunk_count; i++) {
+		uint32_t stored = chunks[i].stored_size & MW_IMAGE_CHUNK_SIZE_MASK;
+
+		if (stored == 0 || stored > LOADER_STAGE_SIZE ||
+			chunks[i].sector < hdr->hdr_sectors ||
+			chunks[i].raw_size > hdr->chunk_size ||
+			((chunks[i].stored_size & MW_IMAGE_CHUNK_RAW) && stored != chunks[i].raw_size)) {
+			return -1;
+		}
+	}
+
+	// Each chunk lands at its index times chunk_size in the segment, so
+	// it must end inside file_size, and together they must fill it.
+	for (uint32_t i = 0; i < hdr->seg_count; i++) {
+		const mw_image_segment *seg = &hdr->seg[i];
+		uint64_t raw_total = 0;
+
+		for (uint32_t j = 0; j < seg->chunk_count; j++) {
+			uint32_t raw = chunks[seg->first_chunk + j].raw_size;
+
+			if ((uint64_t)j * hdr->chunk_size + raw > seg->file_size) {
+				return -1;
+			}
+			raw_total += raw;
+		}
+		if (raw_total != seg->file_size) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+// --- Pipelined reads ---
+// A pipeline is a list of items (image chunks, file pieces, ...). Runs of
+// items that follow each other on the card are read as one window with a
+// non-blocking scatter-gather read. While window N+1 is in flight, the
+// item_done callback checks (and if needed moves) the items of window N.
+// Data that cannot be read in place (compressed chunks, partial last
+// sectors) goes to the window's staging buffer; the two buffers alternate
+// between windows, so the one being worked on is never overwritten.
+
+#define PIPE_ITEM_SG		2U	// Most entries one item needs
+
+typedef struct blk_pipe blk_pipe;
+struct blk_pipe {
+	uint32_t item_count;
+	// Staging bytes the item needs, in whole sectors. NULL if none do.
+	uint32_t (*item_stage)(blk_pipe *pipe, uint32_t item);
+	// Fills in up to PIPE_ITEM_SG entries for an item, returns how many.
+	// 'stage' is where the item's staging bytes are.
+	uint32_t (*item_sg)(blk_pipe *pipe, uint32_t item, uintptr_t stage, mw_blk_sg *sg);
+	// Runs once the item has landed. Returns 0 or -1.
+	int (*item_done)(blk_pipe *pipe, uint32_t item, uintptr_t stage);
+};
+
+static uint32_t blk_pipe_stage(blk_pipe *pipe, uint32_t item)
+{
+	return pipe->item_stage != NULL ? pipe->item_stage(pipe, item) : 0;
+}
+
+// Devices without background reads get the list read one entry at a time.
+static int blk_start_sg(mw_blkdev *dev, const mw_blk_sg *sg, uint32_t count)
+{
+	if (dev->start_sg != NULL) {
+		return dev->start_sg(dev, sg, count);
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t sector = sg[i].sector;
+		uint32_t left = sg[i].len / LOADER_SECTOR_SIZE;
+		uintptr_t buf = sg[i].buf;
+
+		while (left > 0) {
+			uint32_t n = left < dev->max_sectors ? left : dev->max_sectors;
+
+			if (dev->read(dev, sector, n, (void *)buf) != 0) {
+				return -1;
+			}
+			sector += n;
+			buf += (uintptr_t)n * LOADER_SECTOR_SIZE;
+			left -= n;
+		}
+	}
+
+	return 0;
+}
+
+static int blk_wait_sg(mw_blkdev *dev)
+{
+	return dev->wait_sg != NULL ? dev->wait_sg(dev) : 0;
+}
+
+/**
+ * @brief	Starts the read of the window beginning at item 'first'.
+ *
+ * @param	stage: The staging buffer for this window, LOADER_STAGE_SIZE bytes.
+ * @param	end:   Set to the item after the last one in the window.
+ */
+static int blk_pipe_start(mw_blkdev *dev, blk_pipe *pipe, uint32_t first, uintptr_t stage,
+	uint32_t *end, uint64_t *bytes)
+{
+	mw_blk_sg sg[LOADER_PIPE_MAX_SG];
+	uint32_t count = 0;
+	uint32_t window = 0;
+	uint32_t item;
+
+	for (item = first; item < pipe->item_count; item++) {
+		mw_blk_sg isg[PIPE_ITEM_SG];
+		uint32_t n = pipe->item_sg(pipe, item, stage, isg);
+		uint32_t len = 0;
+
+		for (uint32_t k = 0; k < n; k++) {
+			len += isg[k].len;
+		}
+		if (count != 0 &&
+			(count + n > LOADER_PIPE_MAX_SG || window + len > LOADER_STAGE_SIZE ||
+			 isg[0].sector != sg[count - 1].sector + sg[count - 1].len / LOADER_SECTOR_SIZE)) {
+			break;
+		}
+		for (uint32_t k = 0; k < n; k++) {
+			sg[count++] = isg[k];
+		}
+		window += len;
+		stage += blk_pipe_stage(pipe, item);
+	}
+	*end = item;
+	*bytes += window;
+
+	if (blk_start_sg(dev, sg, count) != 0) {
+		loader_printf("ERROR: Starting the read at item %u failed.\r\n", (unsigned int)first);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief	Reads every item of a pipeline, overlapping the item_done work
+ *          of each window with the transfer of the next.
+ *
+ * @note	Only the time spent starting and waiting for reads is charged to
+ *          MW_BOOT_PHASE_SD_READ; item_done charges its own work to
+ *          MW_BOOT_PHASE_EXTRACT.
+ */
+static int blk_pipe_run(mw_blkdev *dev, blk_pipe *pipe, uintptr_t stage_base)
+{
+	uintptr_t stage_buf[2] = { stage_base, stage_base + LOADER_STAGE_SIZE };
+	uint64_t read_time = 0;
+	uint64_t t0;
+	uint64_t bytes = 0;
+	uint32_t cur_first = 0;
+	uint32_t cur_end, next_end;
+	int cur = 0;
+
+	if (pipe->item_count == 0) {
+		return 0;
+	}
+
+	t0 = loader_time();
+	if (blk_pipe_start(dev, pipe, 0, stage_buf[cur], &cur_end, &bytes) != 0) {
+		return -1;
+	}
+
+	while (cur_first < pipe->item_count) {
+		uintptr_t stage = stage_buf[cur];
+
+		if (blk_wait_sg(dev) != 0) {
+			loader_printf("ERROR: Read of item %u failed.\r\n", (unsigned int)cur_first);
+			return -1;
+		}
+
+		next_end = cur_end;
+		if (cur_end < pipe->item_count &&
+			blk_pipe_start(dev, pipe, cur_end, stage_buf[cur ^ 1], &next_end, &bytes) != 0) {
+			return -1;
+		}
+		read_time += loader_time() - t0;
+
+		for (uint32_t i = cur_first; i < cur_end; i++) {
+			if (pipe->item_done(pipe, i, stage) != 0) {
+				return -1;
+			}
+			stage += blk_pipe_stage(pipe, i);
+		}
+
+		cur_first = cur_end;
+		cur_end = next_end;
+		cur ^= 1;
+		t0 = loader_time();
+	}
+	loader_phase_end(MW_BOOT_PHASE_SD_READ, loader_time() - read_time, bytes);
+
+	return 0;
+}
+
+// --- mw_image containers ---
+// Raw chunks of uncompressed images are read to their load address,
+// everything else is staged and then copied or decompressed.
+
+typedef struct {
+	blk_pipe pipe;
+	mw_image_header *hdr;
+	uintptr_t extract_to_offset;
+	uint32_t sector;
+	int direct;			// Raw chunks go straight to their load address
+} image_pipe;
+
+/**
+ * @brief	Works out where a chunk goes and how much of it can be read
+ *          in place.
+ *
+ * @param	dst:  Set to the chunk's load address.
+ * @param	full: Set to the bytes read straight to dst, in whole sectors.
+ *                The rest, if any, is staged: a partial last sector that
+ *                would spill past the segment, or the whole chunk when it
+ *                is compressed or the image is streamed.
+ */
+static void image_chunk_layout(image_pipe *ip, uint32_t item, uintptr_t *dst, uint32_t *full)
+{
+	mw_image_header *hdr = ip->hdr;
+	mw_image_chunk *chunk = &mw_image_chunks(hdr)[item];
+	mw_image_segment *seg;
+	uint64_t offset;
+	uint32_t s = 0;
+
+	while (item >= hdr->seg[s].first_chunk + hdr->seg[s].chunk_count) {
+		s++;
+	}
+	seg = &hdr->seg[s];
+	offset = (uint64_t)(item - seg->first_chunk) * hdr->chunk_size;
+	*dst = ip->extract_to_offset + seg->load_addr + offset;
+
+	if (!ip->direct || !(chunk->stored_size & MW_IMAGE_CHUNK_RAW)) {
+		*full = 0;
+		return;
+	}
+	*full = (chunk->raw_size + LOADER_SECTOR_SIZE - 1) & ~(LOADER_SECTOR_SIZE - 1);
+	// The padding may land in .bss, which is cleared afterwards, but not
+	// past the end of the segment.
+	if (offset + *full > seg->mem_size) {
+		*full = chunk->raw_size & ~(LOADER_SECTOR_SIZE - 1);
+	}
+}
+
+// Bytes the chunk takes on the card, in whole sectors.
+static uint32_t image_chunk_stored(mw_image_chunk *chunk)
+{
+	return ((chunk->stored_size & MW_IMAGE_CHUNK_SIZE_MASK) + LOADER_SECTOR_SIZE - 1) &
+		~(LOADER_SECTOR_SIZE - 1);
+}
+
+static uint32_t image_item_stage(blk_pipe *pipe, uint32_t item)
+{
+	image_pipe *ip = (image_pipe *)pipe;
+	uintptr_t dst;
+	uint32_t full;
+
+	image_chunk_layout(ip, item, &dst, &full);
+	return image_chunk_stored(&mw_image_chunks(ip->hdr)[item]) - full;
+}
+
+static uint32_t image_item_sg(blk_pipe *pipe, uint32_t item, uintptr_t stage, mw_blk_sg *sg)
+{
+	image_pipe *ip = (image_pipe *)pipe;
+	mw_image_chunk *chunk = &mw_image_chunks(ip->hdr)[item];
+	uint32_t stored = image_chunk_stored(chunk);
+	uintptr_t dst;
+	uint32_t full;
+	uint32_t n = 0;
+
+	image_chunk_layout(ip, item, &dst, &full);
+	if (full != 0) {
+		sg[n].sector = ip->sector + chunk->sector;
+		sg[n].buf = dst;
+		sg[n].len = full;
+		n++;
+	}
+	if (full != stored) {
+		sg[n].sector = ip->sector + chunk->sector + full / LOADER_SECTOR_SIZE;
+		sg[n].buf = stage;
+		sg[n].len = stored - full;
+		n++;
+	}
+
+	return n;
+}
+
+static int image_item_done(blk_pipe *pipe, uint32_t item, uintptr_t stage)
+{
+	image_pipe *ip = (image_pipe *)pipe;
+	mw_image_chunk *chunk = &mw_image_chunks(ip->hdr)[item];
+	uint64_t t0 = loader_time();
+	uintptr_t dst;
+	uint32_t full;
+
+	image_chunk_layout(ip, item, &dst, &full);
+	if (chunk->stored_size & MW_IMAGE_CHUNK_RAW) {
+		if (full < chunk->raw_size)
+			loader_copy(dst + full, stage, chunk->raw_size - full);
+		if (crc32c_update(0, (const void *)dst, chunk->raw_size) != chunk->crc) {
+			loader_printf("ERROR: CRC mismatch in chunk %u of the boot image.\r\n",
+				      (unsigned int)item);
+			return -1;
+		}
+	} else {
+		if (crc32c_update(0, (const void *)stage,
+				chunk->stored_size & MW_IMAGE_CHUNK_SIZE_MASK) != chunk->crc) {
+			loader_printf("ERROR: CRC mismatch in chunk %u of the boot image.\r\n",
+				      (unsigned int)item);
+			return -1;
+		}
+		if (lz4_decompress_block((const uint8_t *)stage, chunk->stored_size,
+				(uint8_t *)dst, chunk->raw_size) != (int32_t)chunk->raw_size) {
+			loader_printf("ERROR: Chunk %u of the boot image is corrupt.\r\n",
+				      (unsigned int)item);
+			return -1;
+		}
+	}
+	loader_phase_end(MW_BOOT_PHASE_EXTRACT, t0, 0);
+
+	return 0;
+}
+
+int load_image_from_blkdev(mw_blkdev *dev, uintptr_t extract_to_offset,
+	mw_image_header *hdr, uint32_t sector, uintptr_t stage)
+{
+	image_pipe ip;
+	uint64_t bytes = 0;
+	uint64_t t0;
+
+	if (check_image_header(hdr) != 0) {
+		loader_printf("ERROR: Unsupported or corrupt boot image header (version %u).\r\n",
+			      (unsigned int)hdr->version);
+		return -1;
+	}
+
+	loader_printf("Boot image: %u segments, %u chunks of %u bytes, compression %u\r\n",
+		      (unsigned int)hdr->seg_count, (unsigned int)hdr->chunk_count,
+		      (unsigned int)hdr->chunk_size, (unsigned int)hdr->comp);
+
+	ip.pipe.item_count = hdr->chunk_count;
+	ip.pipe.item_stage = image_item_stage;
+	ip.pipe.item_sg = image_item_sg;
+	ip.pipe.item_done = image_item_done;
+	ip.hdr = hdr;
+	ip.extract_to_offset = extract_to_offset;
+	ip.sector = sector;
+
+	// Raw chunks must start on a sector boundary in their segment and
+	// land on a 4-byte boundary for the DMA.
+	ip.direct = (hdr->chunk_size % LOADER_SECTOR_SIZE) == 0;
+	for (uint32_t i = 0; i < hdr->seg_count; i++) {
+		if (((extract_to_offset + hdr->seg[i].load_addr) & 0x3) != 0) {
+			ip.direct = 0;
+		}
+	}
+
+	if (blk_pipe_run(dev, &ip.pipe, stage) != 0) {
+		return -1;
+	}
+
+	// Clear .bss.
+	t0 = loader_time();
+	for (uint32_t i = 0; i < hdr->seg_count; i++) {
+		mw_image_segment *seg = &hdr->seg[i];
+		uintptr_t dst = extract_to_offset + seg->load_addr;
+
+		loader_note_segment(dst, seg->file_size, seg->mem_size);
+		if (seg->mem_size > seg->file_size) {
+			loader_copy(dst + seg->file_size, 0, seg->mem_size - seg->file_size);
+		}
+		// Everything written to memory counts towards the extract throughput.
+		bytes += seg->mem_size;
+	}
+	loader_phase_end(MW_BOOT_PHASE_EXTRACT, t0, bytes);
+
+	return 0;
+}
+
+// --- Plain ELF files with a digest sidecar ---
+
+int check_digest(const mw_digest *dg, uint32_t max_size)
+{
+	if (dg->chunk_size == 0 || (dg->chunk_size % LOADER_SECTOR_SIZE) != 0 ||
+		dg->chunk_size > LOADER_STAGE_SIZE || dg->file_size > max_size ||
+		dg->chunk_count > MW_DIGEST_MAX_CHUNKS ||
+		dg->chunk_count != (dg->file_size + dg->chunk_size - 1) / dg->chunk_size) {
+		loader_printf("ERROR: Corrupt digest sidecar.\r\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+typedef struct {
+	blk_pipe pipe;
+	const mw_digest *dg;
+	uintptr_t mem_dst;
+	uint32_t sector;
+} elf_pipe;
+
+static uint32_t elf_piece_len(const mw_digest *dg, uint32_t item)
+{
+	uint32_t len = dg->file_size - item * dg->chunk_size;
+
+	return len < dg->chunk_size ? len : dg->chunk_size;
+}
+
+static uint32_t elf_item_sg(blk_pipe *pipe, uint32_t item, uintptr_t stage, mw_blk_sg *sg)
+{
+	elf_pipe *ep = (elf_pipe *)pipe;
+	uint32_t offset = item * ep->dg->chunk_size;
+
+	(void)stage;
+	sg[0].sector = ep->sector + offset / LOADER_SECTOR_SIZE;
+	sg[0].buf = ep->mem_dst + offset;
+	sg[0].len = (elf_piece_len(ep->dg, item) + LOADER_SECTOR_SIZE - 1) &
+		~(LOADER_SECTOR_SIZE - 1);
+
+	return 1;
+}
+
+static int elf_item_done(blk_pipe *pipe, uint32_t item, uintptr_t stage)
+{
+	elf_pipe *ep = (elf_pipe *)pipe;
+	uint32_t offset = item * ep->dg->chunk_size;
+
+	(void)stage;
+	if (crc32c_update(0, (const void *)(ep->mem_dst + offset),
+			elf_piece_len(ep->dg, item)) != ep->dg->crc[item]) {
+		loader_printf("ERROR: CRC mismatch in chunk %u of the ELF file.\r\n",
+			      (unsigned int)item);
+		return -1;
+	}
+
+	return 0;
+}
+
+int read_elf_verified(mw_blkdev *dev, const mw_digest *dg, uintptr_t mem_dst,
+	uint32_t sector, uintptr_t stage)
+{
+	elf_pipe ep;
+
+	ep.pipe.item_count = dg->chunk_count;
+	ep.pipe.item_stage = NULL;
+	ep.pipe.item_sg = elf_item_sg;
+	ep.pipe.item_done = elf_item_done;
+	ep.dg = dg;
+	ep.mem_dst = mem_dst;
+	ep.sector = sector;
+
+	return blk_pipe_run(dev, &ep.pipe, stage);
+}
+
+// --- Raw blobs ---
+// Read in BLOB_PIECE_SIZE pieces straight to their load address, the CRC
+// of each piece being added up while the next ones are read.
+
+#define BLOB_PIECE_SIZE		MW_IMAGE_DEF_CHUNK_SIZE
+
+typedef struct {
+	blk_pipe pipe;
+	uintptr_t dst;
+	uint32_t size;
+	uint32_t sector;
+	uint32_t crc;
+} blob_pipe;
+
+/**
+ * @brief	Works out how much of a piece can be read in place. A partial
+ *          last sector is staged so the read never writes past the end of
+ *          the blob.
+ */
+static void blob_piece_layout(blob_pipe *bp, uint32_t item, uint32_t *len, uint32_t *full)
+{
+	uint32_t offset = item * BLOB_PIECE_SIZE;
+
+	*len = bp->size - offset < BLOB_PIECE_SIZE ? bp->size - offset : BLOB_PIECE_SIZE;
+	*full = *len & ~(LOADER_SECTOR_SIZE - 1);
+}
+
+static uint32_t blob_item_stage(blk_pipe *pipe, uint32_t item)
+{
+	uint32_t len, full;
+
+	blob_piece_layout((blob_pipe *)pipe, item, &len, &full);
+	return full != len ? LOADER_SECTOR_SIZE : 0;
+}
+
+static uint32_t blob_item_sg(blk_pipe *pipe, uint32_t item, uintptr_t stage, mw_blk_sg *sg)
+{
+	blob_pipe *bp = (blob_pipe *)pipe;
+	uint32_t offset = item * BLOB_PIECE_SIZE;
+	uint32_t len, full;
+	uint32_t n = 0;
+
+	blob_piece_layout(bp, item, &len, &full);
+	if (full != 0) {
+		sg[n].sector = bp->sector + offset / LOADER_SECTOR_SIZE;
+		sg[n].buf = bp->dst + offset;
+		sg[n].len = full;
+		n++;
+	}
+	if (full != len) {
+		sg[n].sector = bp->sector + (offset + full) / LOADER_SECTOR_SIZE;
+		sg[n].buf = stage;
+		sg[n].len = LOADER_SECTOR_SIZE;
+		n++;
+	}
+
+	return n;
+}
+
+static int blob_item_done(blk_pipe *pipe, uint32_t item, uintptr_t stage)
+{
+	blob_pipe *bp = (blob_pipe *)pipe;
+	uintptr_t piece = bp->dst + item * BLOB_PIECE_SIZE;
+	uint32_t len, full;
+
+	blob_piece_layout(bp, item, &len, &full);
+	if (full != len)
+		loader_copy(piece + full, stage, len - full);
+	bp->crc = crc32c_update(bp->crc, (const void *)piece, len);
+
+	return 0;
+}
+
+int read_blob_from_blkdev(mw_blkdev *dev, uintptr_t dst, uint32_t size,
+	uint32_t sector, uintptr_t stage, uint32_t *crc)
+{
+	blob_pipe bp;
+
+	bp.pipe.item_count = (size + BLOB_PIECE_SIZE - 1) / BLOB_PIECE_SIZE;
+	bp.pipe.item_stage = blob_item_stage;
+	bp.pipe.item_sg = blob_item_sg;
+	bp.pipe.item_done = blob_item_done;
+	bp.dst = dst;
+	bp.size = size;
+	bp.sector = sector;
+	bp.crc = 0;
+
+	if (blk_pipe_run(dev, &bp.pipe, stage) != 0) {
+		return -1;
+	}
+	*crc = bp.crc;
+
+	return 0;
+}
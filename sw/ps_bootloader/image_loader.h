@@ -0,0 +1,71 @@
+#ifndef __IMAGE_LOADER_H
+#define __IMAGE_LOADER_H
+
+#include <stdint.h>
+#include "elf_loader.h"	 // mw_blkdev, loader_* hooks
+#include "mw_image.h"
+
+/*
+ * Portable part of the pipelined boot paths
+ *
+ * mw_image containers, ELF files with a digest sidecar and raw manifest
+ * parts are read as a list of items (chunks or pieces). Runs of items
+ * that follow each other on the card go out as one scatter-gather read
+ * (mw_blkdev start_sg), and while it is in flight the items of the
+ * previous read are checked, copied and decompressed. Like elf_loader.c
+ * this builds for the board and for the host benchmark (sw/host).
+ *
+ * The caller provides 'stage', two LOADER_STAGE_SIZE buffers back to
+ * back, for the data that cannot be read in place (compressed chunks,
+ * partial last sectors). All functions return 0 if successful and -1
+ * otherwise, having printed why.
+ */
+
+#define LOADER_STAGE_SIZE	MW_IMAGE_MAX_CHUNK_SIZE	// Each of the two buffers
+#define LOADER_PIPE_MAX_SG	64U			// Most entries per read
+
+/**
+ * @brief	Checks that [addr, addr + size) lies in the Microwatt memory
+ *          handed to Linux. Written so that the sum cannot wrap.
+ */
+int mw_range_ok(uint64_t addr, uint64_t size);
+
+/**
+ * @brief	Checks that an mw_image header and its chunk table are ones
+ *          this loader can handle.
+ */
+int check_image_header(mw_image_header *hdr);
+
+/**
+ * @brief	Loads the mw_image container starting at sector, whose header
+ *          is already at hdr, to extract_to_offset + each segment address.
+ *
+ * @note	Raw chunks are read straight to their segment when the layout
+ *          allows it (sector aligned chunks, word aligned segments);
+ *          everything else is staged, then copied or decompressed. Every
+ *          chunk is checked against its CRC-32C.
+ */
+int load_image_from_blkdev(mw_blkdev *dev, uintptr_t extract_to_offset,
+	mw_image_header *hdr, uint32_t sector, uintptr_t stage);
+
+/**
+ * @brief	Checks a digest sidecar whose magic has matched, for a file of
+ *          at most max_size bytes.
+ */
+int check_digest(const mw_digest *dg, uint32_t max_size);
+
+/**
+ * @brief	Reads the ELF file described by the digest sidecar to mem_dst,
+ *          checking each chunk while the next ones are being read.
+ */
+int read_elf_verified(mw_blkdev *dev, const mw_digest *dg, uintptr_t mem_dst,
+	uint32_t sector, uintptr_t stage);
+
+/**
+ * @brief	Reads size bytes from sector to dst without writing past the
+ *          end, and sets crc to their CRC-32C.
+ */
+int read_blob_from_blkdev(mw_blkdev *dev, uintptr_t dst, uint32_t size,
+	uint32_t sector, uintptr_t stage, uint32_t *crc);
+
+#endif /* __IMAGE_LOADER_H */
@@ -0,0 +1,92 @@
+#include "lz4.h"
+
+#define LZ4_MIN_MATCH	4U
+
+/**
+ * @brief	Reads an LZ4 length extension (a run of 255s ended by a smaller byte).
+ *
+ * @param	ip:   Current input position, advanced past the extension.
+ * @param	iend: End of the input block.
+ * @param	len:  Length from the token nibble, extended in place.
+ *
+ * @return	0 if successful, -1 if the input ends inside the extension.
+ */
+static int lz4_read_length(const uint8_t **ip, const uint8_t *iend, uint32_t *len)
+{
+	uint8_t b;
+
+	do {
+		if (*ip >= iend) {
+			return -1;
+		}
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255U);
+
+	return 0;
+}
+
+int32_t lz4_decompress_block(const uint8_t *src, uint32_t src_len,
+	uint8_t *dst, uint32_t dst_cap)
+{
+	const uint8_t *ip = src;
+	const uint8_t *iend = src + src_len;
+	uint8_t *op = dst;
+	uint8_t *oend = dst + dst_cap;
+
+	while (1) {
+		uint8_t token;
+		uint32_t len;
+		uint32_t offset;
+		const uint8_t *match;
+
+		if (ip >= iend) {
+			return -1;
+		}
+		token = *ip++;
+
+		// Literals
+		len = token >> 4;
+		if (len == 15U && lz4_read_length(&ip, iend, &len) != 0) {
+			return -1;
+		}
+		if (len > (uint32_t)(iend - ip) || len > (uint32_t)(oend - op)) {
+			return -1;
+		}
+		while (len--) {
+			*op++ = *ip++;
+		}
+
+		// The last sequence has literals only.
+		if (ip == iend) {
+			break;
+		}
+
+		// Match: 16-bit offset back into the output, then the length.
+		if ((uint32_t)(iend - ip) < 2U) {
+			return -1;
+		}
+		offset = (uint32_t)ip[0] | ((uint32_t)ip[1] << 8);
+		ip += 2;
+		if (offset == 0U || offset > (uint32_t)(op - dst)) {
+			return -1;
+		}
+
+		len = token & 0x0FU;
+		if (len == 15U && lz4_read_length(&ip, iend, &len) != 0) {
+			return -1;
+		}
+		len += LZ4_MIN_MATCH;
+		if (len > (uint32_t)(oend - op)) {
+			return -1;
+		}
+
+		// Byte copy, since the match may overlap the bytes it produces.
+		match = op - offset;
+		while (len--) {
+			*op++ = *match++;
+		}
+	}
+
+	return (int32_t)(op - dst);
+}
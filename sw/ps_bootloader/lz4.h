@@ -0,0 +1,16 @@
+#ifndef __LZ4_H
+#define __LZ4_H
+
+#include <stdint.h>
+
+/*
+ * Minimal LZ4 block decoder, shared by the bootloader and mwpack.
+ *
+ * Decodes one raw LZ4 block (no frame header) from src into dst.
+ * Returns the number of bytes written, or -1 if the block is malformed
+ * or would not fit in dst_cap bytes.
+ */
+int32_t lz4_decompress_block(const uint8_t *src, uint32_t src_len,
+	uint8_t *dst, uint32_t dst_cap);
+
+#endif /* __LZ4_H */
@@ -0,0 +1,152 @@
+#ifndef __MW_IMAGE_H
+#define __MW_IMAGE_H
+
+#include <stdint.h>
+
+/*
+ * Microwatt boot image container
+ *
+ * Shared by the A53 bootloader and the host-side mwpack tool. All fields
+ * are little-endian. Layout on the card, in 512-byte sectors from the
+ * start of the image:
+ *
+ *   [0, hdr_sectors)  mw_image_header, followed by chunk_count entries
+ *                     of mw_image_chunk
+ *   [hdr_sectors, ..) chunk data, each chunk starting on a sector
+ *                     boundary, stored in load order
+ *
+ * Every loadable segment is cut into chunk_size pieces of uncompressed
+ * data (the last one may be shorter). Each piece is compressed on its own
+ * so the loader can decompress it while the next chunks are still being
+ * read from the card. Pieces that do not shrink are stored raw.
+ *
+ * In an uncompressed image (MW_IMAGE_COMP_NONE) every chunk is stored raw
+ * and each segment's chunks are back to back, so the loader can DMA a
+ * whole segment straight to its load address.
+ *
+ * hdr_crc is the CRC-32 (IEEE 802.3) of the first hdr_sectors sectors,
+ * computed with the hdr_crc field itself set to zero. Each chunk carries
+ * the CRC-32C of its stored bytes, checked as soon as the chunk lands.
+ */
+
+#define MW_IMAGE_MAGIC			0x4942574DU	/* "MWBI" */
+#define MW_IMAGE_VERSION		3U
+
+#define MW_IMAGE_SECTOR_SIZE		512U
+#define MW_IMAGE_HDR_MAX_SECTORS	16U	/* Header plus chunk table */
+#define MW_IMAGE_MAX_SEGMENTS		16U
+#define MW_IMAGE_DEF_CHUNK_SIZE		0x10000U	/* 64KB */
+#define MW_IMAGE_MAX_CHUNK_SIZE		0x100000U	/* Loader staging buffer size */
+
+/* Compression methods (mw_image_header.comp) */
+#define MW_IMAGE_COMP_NONE		0U
+#define MW_IMAGE_COMP_LZ4		1U	/* LZ4 block format, no frame */
+
+/* mw_image_chunk.stored_size */
+#define MW_IMAGE_CHUNK_RAW		0x80000000U	/* Chunk is not compressed */
+#define MW_IMAGE_CHUNK_SIZE_MASK	0x7FFFFFFFU
+
+typedef struct {
+	uint64_t load_addr;	/* Offset from the Microwatt DRAM base */
+	uint64_t mem_size;	/* Bytes in memory, including .bss */
+	uint64_t file_size;	/* Bytes of initialized data */
+	uint32_t first_chunk;	/* Index into the chunk table */
+	uint32_t chunk_count;
+} mw_image_segment;
+
+typedef struct {
+	uint32_t sector;	/* First sector, relative to the image start */
+	uint32_t stored_size;	/* Bytes on the card, plus MW_IMAGE_CHUNK_RAW */
+	uint32_t raw_size;	/* Bytes after decompression */
+	uint32_t crc;		/* CRC-32C of the stored bytes */
+} mw_image_chunk;
+
+typedef struct {
+	uint32_t magic;		/* MW_IMAGE_MAGIC */
+	uint16_t version;	/* MW_IMAGE_VERSION */
+	uint16_t comp;		/* MW_IMAGE_COMP_* */
+	uint32_t hdr_sectors;	/* Sectors used by header and chunk table */
+	uint32_t seg_count;
+	uint32_t chunk_count;
+	uint32_t chunk_size;	/* Uncompressed bytes per chunk */
+	uint32_t hdr_crc;	/* CRC-32 of the header sectors */
+	uint32_t reserved;
+	uint64_t entry;		/* ELF entry point */
+	mw_image_segment seg[MW_IMAGE_MAX_SEGMENTS];
+} mw_image_header;
+
+#define MW_IMAGE_MAX_CHUNKS \
+	((MW_IMAGE_HDR_MAX_SECTORS * MW_IMAGE_SECTOR_SIZE - sizeof(mw_image_header)) / \
+	 sizeof(mw_image_chunk))
+
+/* The chunk table starts right after the fixed header. */
+static inline mw_image_chunk *mw_image_chunks(const mw_image_header *hdr)
+{
+	return (mw_image_chunk *)(hdr + 1);
+}
+
+/*
+ * Digest sidecar for plain ELF images
+ *
+ * An ELF written raw to the card carries no checksum, so mwpack -d can
+ * produce a separate digest that is written to the sectors right after
+ * the bootloader's image window (MW_DIGEST_DEF_SECTOR for the default
+ * 7MB window). It holds the CRC-32C of every chunk_size piece of the file.
+ */
+
+#define MW_DIGEST_MAGIC			0x4744574DU	/* "MWDG" */
+#define MW_DIGEST_SECTORS		8U
+#define MW_DIGEST_DEF_SECTOR		(0x00700000U / MW_IMAGE_SECTOR_SIZE)
+
+typedef struct {
+	uint32_t magic;		/* MW_DIGEST_MAGIC */
+	uint32_t file_size;	/* Bytes covered */
+	uint32_t chunk_size;	/* Bytes per CRC, a multiple of the sector size */
+	uint32_t chunk_count;
+	uint32_t crc[];		/* CRC-32C of each chunk */
+} mw_digest;
+
+#define MW_DIGEST_MAX_CHUNKS \
+	((MW_DIGEST_SECTORS * MW_IMAGE_SECTOR_SIZE - sizeof(mw_digest)) / sizeof(uint32_t))
+
+/*
+ * Boot manifest
+ *
+ * A manifest in sector 0 lists the parts of a split boot: the kernel (a
+ * plain ELF or an mw_image) and raw blobs such as the device tree and an
+ * uncompressed initramfs, each loaded to its own address. Every part
+ * starts on a sector boundary, so one part can be rewritten on the card
+ * without touching the others as long as it still fits its slot.
+ *
+ * hdr_crc is the CRC-32 (IEEE 802.3) of the mw_manifest structure with
+ * the field set to zero. Raw parts carry the CRC-32C of their data; the
+ * kernel is checked by its own chunk CRCs or digest sidecar.
+ */
+
+#define MW_MANIFEST_MAGIC		0x464D574DU	/* "MWMF" */
+#define MW_MANIFEST_VERSION		1U
+#define MW_MANIFEST_MAX_ENTRIES		8U
+
+/* mw_manifest_entry.type, same values as MW_BOOT_ITEM_* in mw_shared.h */
+#define MW_MANIFEST_KERNEL		1U
+#define MW_MANIFEST_DTB			2U
+#define MW_MANIFEST_INITRD		3U
+
+typedef struct {
+	uint32_t type;		/* MW_MANIFEST_* */
+	uint32_t sector;	/* First sector, relative to the manifest */
+	uint32_t size;		/* Bytes on the card */
+	uint32_t crc;		/* CRC-32C of the data, 0 for the kernel */
+	uint64_t load_addr;	/* Microwatt address, unused for the kernel */
+} mw_manifest_entry;
+
+typedef struct {
+	uint32_t magic;		/* MW_MANIFEST_MAGIC */
+	uint16_t version;	/* MW_MANIFEST_VERSION */
+	uint16_t entry_count;
+	uint32_t hdr_crc;	/* CRC-32 of this structure */
+	uint32_t reserved;
+	mw_manifest_entry entry[MW_MANIFEST_MAX_ENTRIES];
+} mw_manifest;
+
+#endif /* __MW_IMAGE_H */
@@ -0,0 +1,199 @@
+#include <stdint.h>
+#include "sd_cache.h"
+
+static void cache_copy(uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+	for (uint32_t i = 0; i < len; i++) {
+		dst[i] = src[i];
+	}
+}
+
+static int cache_lookup(sd_cache *c, uint32_t sector)
+{
+	for (uint32_t i = 0; i < c->lines; i++) {
+		sd_cache_line *l = &c->line[i];
+
+		if (l->count != 0 && sector - l->sector < l->count) {
+			return (int)i;
+		}
+	}
+
+	return -1;
+}
+
+// First of the n adjacent lines whose newest use is the oldest.
+static uint32_t cache_victim(sd_cache *c, uint32_t n)
+{
+	uint32_t best = 0;
+	uint32_t best_used = UINT32_MAX;
+
+	for (uint32_t first = 0; first + n <= c->lines; first++) {
+		uint32_t used = 0;
+
+		for (uint32_t i = first; i < first + n; i++) {
+			if (c->line[i].count != 0 && c->line[i].used > used) {
+				used = c->line[i].used;
+			}
+		}
+		if (used < best_used) {
+			best_used = used;
+			best = first;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * @brief	Reads n windows, starting with the one holding sector, into the
+ *          least recently used run of n lines.
+ *
+ * @return	0 if successful, -1 otherwise.
+ */
+static int cache_fill(sd_cache *c, uint32_t sector, uint32_t n)
+{
+	uint32_t base = sector - sector % c->window;
+	uint32_t sectors = n * c->window;
+	uint32_t first;
+
+	if (c->capacity != 0) {
+		if (base >= c->capacity) {
+			return -1;
+		}
+		if (sectors > c->capacity - base) {
+			sectors = c->capacity - base;
+		}
+	}
+	if (sectors > c->lower->max_sectors) {
+		sectors = c->lower->max_sectors - c->lower->max_sectors % c->window;
+	}
+	n = (sectors + c->window - 1) / c->window;
+
+	// Lines start on window boundaries, so an older copy has the same start
+	for (uint32_t i = 0; i < c->lines; i++) {
+		if (c->line[i].sector - base < sectors) {
+			c->line[i].count = 0;
+		}
+	}
+	first = cache_victim(c, n);
+	for (uint32_t i = first; i < first + n; i++) {
+		c->line[i].count = 0;
+	}
+
+	if (c->lower->read(c->lower, base, sectors,
+			   c->mem + first * c->window * LOADER_SECTOR_SIZE) != 0) {
+		return -1;
+	}
+
+	c->tick++;
+	for (uint32_t k = 0; k < n; k++) {
+		sd_cache_line *l = &c->line[first + k];
+		uint32_t left = sectors - k * c->window;
+
+		l->sector = base + k * c->window;
+		l->count = left < c->window ? left : c->window;
+		l->used = c->tick;
+	}
+	c->stats.fills++;
+	c->stats.fill_sectors += sectors;
+
+	return 0;
+}
+
+static int cache_read(mw_blkdev *dev, uint32_t sector, uint32_t count, void *buf)
+{
+	sd_cache *c = (sd_cache *)dev;
+	uint8_t *dst = buf;
+	uint32_t total = count;
+	int sequential = (sector == c->next);
+	int missed = 0;
+
+	c->next = sector + count;
+
+	if (count >= c->window) {
+		c->stats.bypassed++;
+		return c->lower->read(c->lower, sector, count, buf);
+	}
+
+	while (count > 0) {
+		int idx = cache_lookup(c, sector);
+		sd_cache_line *l;
+		uint32_t off;
+		uint32_t len;
+
+		if (idx < 0) {
+			uint32_t n = 1;
+
+			// Every sequential miss in a row reads twice as far ahead
+			if (sequential) {
+				n = c->ahead;
+				c->ahead = c->ahead * 2 < c->max_ahead ? c->ahead * 2 : c->max_ahead;
+			} else {
+				c->ahead = c->max_ahead < 2 ? c->max_ahead : 2;
+			}
+			if (cache_fill(c, sector, n) != 0) {
+				return -1;
+			}
+			sequential = 1;
+			missed = 1;
+			continue;
+		}
+
+		l = &c->line[idx];
+		off = sector - l->sector;
+		len = l->count - off < count ? l->count - off : count;
+		cache_copy(dst, c->mem + ((uint32_t)idx * c->window + off) * LOADER_SECTOR_SIZE,
+			   len * LOADER_SECTOR_SIZE);
+		l->used = ++c->tick;
+
+		dst += len * LOADER_SECTOR_SIZE;
+		sector += len;
+		count -= len;
+	}
+
+	if (missed) {
+		c->stats.misses++;
+	} else {
+		c->stats.hits++;
+		c->stats.hit_sectors += total;
+	}
+
+	return 0;
+}
+
+int sd_cache_init(sd_cache *c, mw_blkdev *lower, void *mem, uint32_t lines,
+	uint32_t window, uint32_t capacity)
+{
+	if (lines == 0 || lines > SD_CACHE_MAX_LINES || window == 0 ||
+	    window > lower->max_sectors) {
+		return -1;
+	}
+
+	c->dev.max_sectors = lower->max_sectors;
+	c->dev.read = cache_read;
+	c->dev.start_sg = NULL;
+	c->dev.wait_sg = NULL;
+	c->dev.priv = NULL;
+	c->lower = lower;
+	c->mem = mem;
+	c->lines = lines;
+	c->window = window;
+	c->max_ahead = lines / 2 ? lines / 2 : 1;
+	c->capacity = capacity;
+	c->next = UINT32_MAX;
+	c->ahead = 1;
+	c->tick = 0;
+	c->stats = (sd_cache_stats){ 0 };
+	sd_cache_invalidate(c);
+
+	return 0;
+}
+
+void sd_cache_invalidate(sd_cache *c)
+{
+	for (uint32_t i = 0; i < SD_CACHE_MAX_LINES; i++) {
+		c->line[i].count = 0;
+		c->line[i].used = 0;
+	}
+	c->next = UINT32_MAX;
+}
@@ -0,0 +1,72 @@
+#ifndef __SD_CACHE_H
+#define __SD_CACHE_H
+
+#include <stdint.h>
+#include "elf_loader.h"	 // mw_blkdev
+
+/*
+ * Read-ahead sector cache in front of a block device
+ *
+ * Small reads (headers, manifest, digest) are served from lines of
+ * 'window' sectors, each filled with one read of the aligned window
+ * around the miss. A miss right after the previous request ended is
+ * taken as a sequential scan and fills two lines, then four, up to
+ * max_ahead, with a single read. The fill goes to the run of adjacent
+ * lines that was used least recently. Reads of a whole window or more
+ * go straight to the device, because bulk data is read once.
+ *
+ * The cache is an mw_blkdev itself, so read_elf_from_blkdev() and the
+ * like can sit on top of it. It holds no Xilinx code and builds on the
+ * host as well. There are no writes, so nothing is ever stale.
+ */
+
+#define SD_CACHE_MAX_LINES	32U
+
+typedef struct {
+	uint32_t sector;	/* First sector, a multiple of the window */
+	uint32_t count;		/* Valid sectors, 0 if the line is empty */
+	uint32_t used;		/* Tick of the last hit or fill */
+} sd_cache_line;
+
+typedef struct {
+	uint32_t hits;		/* Requests served from the lines */
+	uint32_t misses;	/* Requests that needed a fill */
+	uint32_t bypassed;	/* Requests passed straight to the device */
+	uint32_t fills;		/* Device reads issued for fills */
+	uint32_t fill_sectors;
+	uint32_t hit_sectors;
+} sd_cache_stats;
+
+typedef struct {
+	mw_blkdev dev;		/* Must stay first */
+	mw_blkdev *lower;
+	uint8_t *mem;		/* lines * window sectors */
+	uint32_t lines;
+	uint32_t window;	/* Sectors per line */
+	uint32_t max_ahead;	/* Most lines one sequential fill covers */
+	uint32_t capacity;	/* Device size in sectors, 0 if unknown */
+	uint32_t next;		/* Sector after the previous request */
+	uint32_t ahead;		/* Lines the next sequential fill covers */
+	uint32_t tick;
+	sd_cache_line line[SD_CACHE_MAX_LINES];
+	sd_cache_stats stats;
+} sd_cache;
+
+/**
+ * @brief	Sets up a cache over lower in mem, which must hold lines * window
+ *          sectors and suit the device's DMA.
+ *
+ * @param	capacity: Device size in sectors, so fills stop at its end; 0
+ *          if unknown.
+ *
+ * @return	0 if successful, -1 if the geometry does not fit.
+ */
+int sd_cache_init(sd_cache *c, mw_blkdev *lower, void *mem, uint32_t lines,
+	uint32_t window, uint32_t capacity);
+
+/**
+ * @brief	Empties every line, keeping the statistics.
+ */
+void sd_cache_invalidate(sd_cache *c);
+
+#endif /* __SD_CACHE_H */
@@ -92,6 +92,9 @@
 *                       for SD/eMMC.
 * 4.2   ro     06/12/23 Added support for system device-tree flow.
 * 4.3   ap     11/29/23 Add support for Sanitize feature.
+* 4.4   mw     10/18/26 Add XSdPs_ReadSG scatter-gather read API.
+*       mw     10/18/26 Retry a multi-block read with Auto CMD12 when Auto
+*                       CMD23 fails.
 *
 * </pre>
 *
@@ -107,6 +110,8 @@
 /***************** Macros (Inline Functions) Definitions *********************/
 
 /************************** Function Prototypes ******************************/
+static s32 XSdPs_ReadSGRun(XSdPs *InstancePtr, const XSdPs_SgEntry *SgList,
+			   u32 Count, u32 BlkCnt);
 /*****************************************************************************/
 /**
 *
@@ -187,6 +192,8 @@ s32 XSdPs_CfgInitialize(XSdPs *InstancePtr, XSdPs_Config *ConfigPtr,
 	InstancePtr->IsBusy = FALSE;
 	InstancePtr->BlkSize = 0U;
 	InstancePtr->IsTuningDone = 0U;
+	InstancePtr->Adma2_UserDescrTbl = NULL;
+	InstancePtr->Adma2_UserDescrLines = 0U;
 
 	/* Host Controller version is read. */
 	InstancePtr->HC_Version =
@@ -250,6 +257,7 @@ s32 XSdPs_CardInitialize(XSdPs *InstancePtr)
 	InstancePtr->BusWidth = XSDPS_1_BIT_WIDTH;
 	InstancePtr->CardType = XSDPS_CARD_SD;
 	InstancePtr->Switch1v8 = 0U;
+	InstancePtr->AutoCmd23 = 0U;
 	InstancePtr->BusSpeed = XSDPS_CLK_400_KHZ;
 
 #if defined  (XCLOCKING)
@@ -313,6 +321,7 @@ RETURN_PATH:
 s32 XSdPs_ReadPolled(XSdPs *InstancePtr, u32 Arg, u32 BlkCnt, u8 *Buff)
 {
 	s32 Status;
+	u8 AutoCmd23;
 
 	Xil_AssertNonvoid(InstancePtr != NULL);
 	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
@@ -333,15 +342,25 @@ s32 XSdPs_ReadPolled(XSdPs *InstancePtr, u32 Arg, u32 BlkCnt, u8 *Buff)
 		goto RETURN_PATH;
 	}
 
+	AutoCmd23 = InstancePtr->AutoCmd23;
+
 	/* Read from the card */
 	Status = XSdPs_Read(InstancePtr, Arg, BlkCnt, Buff);
-	if (Status != XST_SUCCESS) {
-		Status = XST_FAILURE;
-		goto RETURN_PATH;
+	if (Status == XST_SUCCESS) {
+		/* Check for transfer done */
+		Status = XSdps_CheckTransferDone(InstancePtr);
 	}
 
-	/* Check for transfer done */
-	Status = XSdps_CheckTransferDone(InstancePtr);
+	/* The card refused Auto CMD23: the retry goes out with Auto CMD12 */
+	if ((Status != XST_SUCCESS) && (BlkCnt > 1U) && (AutoCmd23 != 0U) &&
+	    (InstancePtr->AutoCmd23 == 0U)) {
+		(void)XSdPs_Reset(InstancePtr, XSDPS_SWRST_CMD_LINE_MASK |
+				  XSDPS_SWRST_DAT_LINE_MASK);
+		Status = XSdPs_Read(InstancePtr, Arg, BlkCnt, Buff);
+		if (Status == XST_SUCCESS) {
+			Status = XSdps_CheckTransferDone(InstancePtr);
+		}
+	}
 	if (Status != XST_SUCCESS) {
 		Status = XST_FAILURE;
 		goto RETURN_PATH;
@@ -359,6 +378,167 @@ RETURN_PATH:
 	return Status;
 }
 
+/*****************************************************************************/
+/**
+* @brief
+* Performs a scatter-gather SD read in polled mode.
+*
+* Entries whose card ranges follow each other are merged and read with a
+* single CMD18 whose ADMA2 chain scatters the data into the entry buffers.
+* A new command is only issued where the card range is discontiguous.
+*
+* @param	InstancePtr Pointer to the instance to be worked on.
+* @param	SgList List of (sector, buffer, length) entries.
+* @param	SgCount Number of entries in SgList.
+*
+* @return
+* 		- XST_SUCCESS if all ranges were read
+* 		- XST_FAILURE if failure - could be because another transfer
+* 		is in progress, an entry is not a whole number of blocks, or
+* 		a merged range does not fit in the descriptor table
+*
+* @note		Sector is a block number for both SDHC and SDSC cards; the
+*		byte address conversion for SDSC is done here.
+*
+******************************************************************************/
+s32 XSdPs_ReadSG(XSdPs *InstancePtr, const XSdPs_SgEntry *SgList, u32 SgCount)
+{
+	s32 Status;
+	u32 Index;
+	u32 Count;
+	u32 Entry;
+	u32 BlkCnt;
+	u8 AutoCmd23;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid(SgList != NULL);
+
+	if (InstancePtr->IsBusy == TRUE) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+#if defined  (XCLOCKING)
+	Xil_ClockEnable(InstancePtr->Config.RefClk);
+#endif
+
+	/* Setup the Read Transfer */
+	Status = XSdPs_SetupTransfer(InstancePtr);
+	if (Status != XST_SUCCESS) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	Index = 0U;
+	while (Index < SgCount) {
+		/* Collect the run of entries that are contiguous on the card */
+		BlkCnt = 0U;
+		for (Count = 0U; (Index + Count) < SgCount; Count++) {
+			if ((SgList[Index + Count].Length == 0U) ||
+			    ((SgList[Index + Count].Length % InstancePtr->BlkSize) != 0U)) {
+				Status = XST_FAILURE;
+				goto RETURN_PATH;
+			}
+			if ((Count != 0U) &&
+			    (SgList[Index + Count].Sector != (SgList[Index].Sector + BlkCnt))) {
+				break;
+			}
+			BlkCnt += SgList[Index + Count].Length / InstancePtr->BlkSize;
+		}
+
+		if (BlkCnt > XSDPS_BLK_CNT_MASK) {
+			Status = XST_FAILURE;
+			goto RETURN_PATH;
+		}
+
+		AutoCmd23 = InstancePtr->AutoCmd23;
+		Status = XSdPs_ReadSGRun(InstancePtr, &SgList[Index], Count, BlkCnt);
+
+		/* The card refused Auto CMD23: the retry goes out with Auto CMD12 */
+		if ((Status != XST_SUCCESS) && (BlkCnt > 1U) && (AutoCmd23 != 0U) &&
+		    (InstancePtr->AutoCmd23 == 0U)) {
+			(void)XSdPs_Reset(InstancePtr, XSDPS_SWRST_CMD_LINE_MASK |
+					  XSDPS_SWRST_DAT_LINE_MASK);
+			Status = XSdPs_ReadSGRun(InstancePtr, &SgList[Index], Count, BlkCnt);
+		}
+		if (Status != XST_SUCCESS) {
+			Status = XST_FAILURE;
+			goto RETURN_PATH;
+		}
+
+		if (InstancePtr->Config.IsCacheCoherent == 0U) {
+			for (Entry = Index; Entry < (Index + Count); Entry++) {
+				Xil_DCacheInvalidateRange((INTPTR)SgList[Entry].Buff,
+							  (INTPTR)SgList[Entry].Length);
+			}
+		}
+
+		Index += Count;
+	}
+
+	Status = XST_SUCCESS;
+
+RETURN_PATH:
+#if defined  (XCLOCKING)
+	Xil_ClockDisable(InstancePtr->Config.RefClk);
+#endif
+	return Status;
+}
+
+/*****************************************************************************/
+/**
+* @brief
+* Reads one run of scatter-gather entries that are contiguous on the card
+* with a single CMD17/CMD18 and waits for it.
+*
+* @param	InstancePtr Pointer to the instance to be worked on.
+* @param	SgList First entry of the run.
+* @param	Count Number of entries in the run.
+* @param	BlkCnt Number of blocks the run covers.
+*
+* @return
+* 		- XST_SUCCESS if the run was read
+* 		- XST_FAILURE if the descriptor chain, command or transfer failed
+*
+******************************************************************************/
+static s32 XSdPs_ReadSGRun(XSdPs *InstancePtr, const XSdPs_SgEntry *SgList,
+			   u32 Count, u32 BlkCnt)
+{
+	s32 Status;
+	u32 Arg;
+
+	Status = XSdPs_SetupSgReadDma(InstancePtr, SgList, Count);
+	if (Status != XST_SUCCESS) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	Arg = SgList[0].Sector;
+	if (InstancePtr->HCS == 0U) {
+		Arg *= InstancePtr->BlkSize;
+	}
+
+	if (BlkCnt == 1U) {
+		Status = XSdPs_CmdTransfer(InstancePtr, CMD17, Arg, BlkCnt);
+	} else {
+		Status = XSdPs_CmdTransfer(InstancePtr, CMD18, Arg, BlkCnt);
+	}
+	if (Status != XST_SUCCESS) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	/* Check for transfer done */
+	Status = XSdps_CheckTransferDone(InstancePtr);
+	if (Status != XST_SUCCESS) {
+		Status = XST_FAILURE;
+	}
+
+RETURN_PATH:
+	return Status;
+}
+
 /*****************************************************************************/
 /**
 * @brief
@@ -102,6 +102,13 @@
 * 4.3   ap     11/29/23 Add support for Sanitize feature.
 * 4.3   ap     12/22/23 Add support to read custom HS400 tap delay value from design for eMMC.
 * 4.4   ht     09/30/24 Fix IAR warnings.
+*       mw     10/18/26 Add support for caller-supplied ADMA2 descriptor tables
+*                       so a single transfer is no longer limited to 2MB.
+*       mw     10/18/26 Add XSdPs_ReadSG scatter-gather read API.
+*       mw     10/18/26 Add non-blocking XSdPs_StartReadSG.
+*       mw     10/18/26 Add XSdPs_SelectBusSpeed.
+*       mw     10/18/26 Use Auto CMD23 for multi-block reads when the card
+*                       supports CMD23.
 *
 * </pre>
 *
@@ -178,6 +185,17 @@ extern "C" {
 
 /** @} */
 
+/** @name ADMA2 descriptor table sizes
+ *
+ * Number of entries in the descriptor tables embedded in the instance.
+ * A larger table can be supplied with XSdPs_SetAdma2DescrTbl().
+ * @{
+ */
+
+#define XSDPS_DEF_DESC_LINES	32U	/**< Entries in the default tables */
+
+/** @} */
+
 /**************************** Type Definitions *******************************/
 
 /**
@@ -245,6 +263,16 @@ typedef struct {
 }  __attribute__((__packed__))XSdPs_Adma2Descriptor64;
 #endif
 
+/**
+ * Scatter-gather read list entry. Consecutive entries whose card ranges
+ * follow each other are merged into one multi-block read.
+ */
+typedef struct {
+	u32 Sector;		/**< First card block of the range */
+	UINTPTR Buff;		/**< Destination buffer, 4-byte aligned */
+	u32 Length;		/**< Bytes to read, multiple of the block size */
+} XSdPs_SgEntry;
+
 /**
  * The XSdPs driver instance data. The user is required to allocate a
  * variable of this type for every SD device in the system. A pointer
@@ -276,8 +304,11 @@ typedef struct {
 	u8  IsBusy;			/**< Busy Flag*/
 	u32 BlkSize;		/**< Block Size*/
 	u8  IsTuningDone;	/**< Flag to indicate HS200 tuning complete */
-	XSdPs_Adma2Descriptor32 Adma2_DescrTbl32[32] __attribute__ ((aligned(32)));	/**< ADMA descriptor table 32 Bit */
-	XSdPs_Adma2Descriptor64 Adma2_DescrTbl64[32] __attribute__ ((aligned(32)));	/**< ADMA descriptor table 64 Bit */
+	u8  AutoCmd23;		/**< Multi-block reads use Auto CMD23 instead of Auto CMD12 */
+	XSdPs_Adma2Descriptor32 Adma2_DescrTbl32[XSDPS_DEF_DESC_LINES] __attribute__ ((aligned(32)));	/**< ADMA descriptor table 32 Bit */
+	XSdPs_Adma2Descriptor64 Adma2_DescrTbl64[XSDPS_DEF_DESC_LINES] __attribute__ ((aligned(32)));	/**< ADMA descriptor table 64 Bit */
+	XSdPs_Adma2Descriptor64 *Adma2_UserDescrTbl;	/**< Caller-supplied ADMA descriptor table */
+	u32 Adma2_UserDescrLines;	/**< Number of entries in the caller-supplied table */
 } XSdPs;
 
 /***************** Macros (Inline Functions) Definitions *********************/
@@ -323,9 +354,12 @@ s32 XSdPs_CfgInitialize(XSdPs *InstancePtr, XSdPs_Config *ConfigPtr,
 s32 XSdPs_CardInitialize(XSdPs *InstancePtr);
 s32 XSdPs_ReadPolled(XSdPs *InstancePtr, u32 Arg, u32 BlkCnt, u8 *Buff);
 s32 XSdPs_WritePolled(XSdPs *InstancePtr, u32 Arg, u32 BlkCnt, const u8 *Buff);
+s32 XSdPs_ReadSG(XSdPs *InstancePtr, const XSdPs_SgEntry *SgList, u32 SgCount);
 s32 XSdPs_Idle(XSdPs *InstancePtr);
 
 s32 XSdPs_Change_BusSpeed(XSdPs *InstancePtr);
+s32 XSdPs_SelectBusSpeed(XSdPs *InstancePtr, u32 Arg, u32 BlkCnt, u8 *RefBuff,
+			 u8 *ReadBuff);
 s32 XSdPs_Change_ClkFreq(XSdPs *InstancePtr, u32 SelFreq);
 s32 XSdPs_Pullup(XSdPs *InstancePtr);
 s32 XSdPs_Get_BusWidth(XSdPs *InstancePtr, u8 *ReadBuff);
@@ -334,9 +368,13 @@ s32 XSdPs_Get_BusSpeed(XSdPs *InstancePtr, u8 *ReadBuff);
 s32 XSdPs_Get_Mmc_ExtCsd(XSdPs *InstancePtr, u8 *ReadBuff);
 s32 XSdPs_Set_Mmc_ExtCsd(XSdPs *InstancePtr, u32 Arg);
 s32 XSdPs_SetBlkSize(XSdPs *InstancePtr, u16 BlkSize);
+s32 XSdPs_SetAdma2DescrTbl(XSdPs *InstancePtr, XSdPs_Adma2Descriptor64 *DescrTbl,
+			   u32 DescrLines);
+u32 XSdPs_GetMaxTransferLen(XSdPs *InstancePtr);
 s32 XSdPs_Get_Status(XSdPs *InstancePtr, u8 *SdStatReg);
 s32 XSdPs_Select_Card(XSdPs *InstancePtr);
 s32 XSdPs_StartReadTransfer(XSdPs *InstancePtr, u32 Arg, u32 BlkCnt, u8 *Buff);
+s32 XSdPs_StartReadSG(XSdPs *InstancePtr, const XSdPs_SgEntry *SgList, u32 SgCount);
 s32 XSdPs_CheckReadTransfer(XSdPs *InstancePtr);
 s32 XSdPs_StartWriteTransfer(XSdPs *InstancePtr, u32 Arg, u32 BlkCnt, u8 *Buff);
 s32 XSdPs_CheckWriteTransfer(XSdPs *InstancePtr);
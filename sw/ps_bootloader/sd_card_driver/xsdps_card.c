@@ -40,6 +40,10 @@
 * 	sa     01/25/23 Use instance structure to store DMA descriptor tables.
 * 4.2   ap     08/09/23 reordered function XSdPs_Identify_UhsMode.
 * 4.3   ap     12/22/23 Add support to read custom HS400 tap delay value from design for eMMC.
+* 4.4   mw     10/18/26 Check transfer length against the registered ADMA2
+*                       descriptor table instead of the fixed 2MB limit.
+*       mw     10/18/26 Stop using Auto CMD23 after a non-blocking read
+*                       reports an auto command error.
 * </pre>
 *
 ******************************************************************************/
@@ -76,9 +80,11 @@ s32 XSdPs_Read(XSdPs *InstancePtr, u32 Arg, u32 BlkCnt, u8 *Buff)
 {
 	s32 Status;
 
-	if ((BlkCnt * InstancePtr->BlkSize) > (32U * XSDPS_DESC_MAX_LENGTH)) {
+	if ((BlkCnt > XSDPS_BLK_CNT_MASK) ||
+	    ((BlkCnt * InstancePtr->BlkSize) > XSdPs_GetMaxTransferLen(InstancePtr))) {
 #ifdef XSDPS_DEBUG
-		xil_printf("Max transfer length supported is 2MB\n");
+		xil_printf("Max transfer length supported is %u bytes\n",
+			   XSdPs_GetMaxTransferLen(InstancePtr));
 #endif
 		Status = XST_FAILURE;
 	} else {
@@ -124,9 +130,11 @@ s32 XSdPs_Write(XSdPs *InstancePtr, u32 Arg, u32 BlkCnt, const u8 *Buff)
 {
 	s32 Status;
 
-	if ((BlkCnt * InstancePtr->BlkSize) > (32U * XSDPS_DESC_MAX_LENGTH)) {
+	if ((BlkCnt > XSDPS_BLK_CNT_MASK) ||
+	    ((BlkCnt * InstancePtr->BlkSize) > XSdPs_GetMaxTransferLen(InstancePtr))) {
 #ifdef XSDPS_DEBUG
-		xil_printf("Max transfer length supported is 2MB\n");
+		xil_printf("Max transfer length supported is %u bytes\n",
+			   XSdPs_GetMaxTransferLen(InstancePtr));
 #endif
 		Status = XST_FAILURE;
 	} else {
@@ -180,6 +188,12 @@ s32 XSdPs_CheckTransferComplete(XSdPs *InstancePtr)
 	StatusReg = XSdPs_ReadReg16(InstancePtr->Config.BaseAddress,
 				    XSDPS_NORM_INTR_STS_OFFSET);
 	if ((StatusReg & XSDPS_INTR_ERR_MASK) != 0U) {
+		/* A refused Auto CMD23 leaves later reads on Auto CMD12 */
+		if ((XSdPs_ReadReg16(InstancePtr->Config.BaseAddress,
+				     XSDPS_ERR_INTR_STS_OFFSET) &
+		     XSDPS_INTR_ERR_AUTO_CMD12_MASK) != 0U) {
+			InstancePtr->AutoCmd23 = 0U;
+		}
 		/* Write to clear error bits */
 		XSdPs_WriteReg16(InstancePtr->Config.BaseAddress,
 				 XSDPS_ERR_INTR_STS_OFFSET,
@@ -1221,6 +1235,7 @@ void XSdPs_SetupADMA2DescTbl64Bit(XSdPs *InstancePtr, u32 BlkCnt)
 	u32 TotalDescLines;
 	u32 DescNum;
 	u32 BlkSize;
+	XSdPs_Adma2Descriptor64 *DescrTbl = XSdPs_GetDescrTbl64(InstancePtr);
 
 	/* Setup ADMA2 - Write descriptor table and point ADMA SAR to it */
 	BlkSize = (u32)XSdPs_ReadReg16(InstancePtr->Config.BaseAddress,
@@ -1241,30 +1256,30 @@ void XSdPs_SetupADMA2DescTbl64Bit(XSdPs *InstancePtr, u32 BlkCnt)
 	}
 
 	for (DescNum = 0U; DescNum < (TotalDescLines - 1U); DescNum++) {
-		InstancePtr->Adma2_DescrTbl64[DescNum].Address =
+		DescrTbl[DescNum].Address =
 			InstancePtr->Dma64BitAddr +
 			((u64)DescNum * XSDPS_DESC_MAX_LENGTH);
-		InstancePtr->Adma2_DescrTbl64[DescNum].Attribute =
+		DescrTbl[DescNum].Attribute =
 			XSDPS_DESC_TRAN | XSDPS_DESC_VALID;
-		InstancePtr->Adma2_DescrTbl64[DescNum].Length = 0U;
+		DescrTbl[DescNum].Length = 0U;
 	}
 
-	InstancePtr->Adma2_DescrTbl64[TotalDescLines - 1U].Address =
+	DescrTbl[TotalDescLines - 1U].Address =
 		InstancePtr->Dma64BitAddr +
 		((u64)DescNum * XSDPS_DESC_MAX_LENGTH);
 
-	InstancePtr->Adma2_DescrTbl64[TotalDescLines - 1U].Attribute =
+	DescrTbl[TotalDescLines - 1U].Attribute =
 		XSDPS_DESC_TRAN | XSDPS_DESC_END | XSDPS_DESC_VALID;
 
-	InstancePtr->Adma2_DescrTbl64[TotalDescLines - 1U].Length =
+	DescrTbl[TotalDescLines - 1U].Length =
 		(u16)((BlkCnt * BlkSize) - (u32)(DescNum * XSDPS_DESC_MAX_LENGTH));
 
 	XSdPs_WriteReg(InstancePtr->Config.BaseAddress, XSDPS_ADMA_SAR_OFFSET,
-		       (u32)((UINTPTR) & (InstancePtr->Adma2_DescrTbl64[0]) & ~(u32)0x0U));
+		       (u32)((UINTPTR) & (DescrTbl[0]) & ~(u32)0x0U));
 
 	if (InstancePtr->Config.IsCacheCoherent == 0U) {
-		Xil_DCacheFlushRange((INTPTR) & (InstancePtr->Adma2_DescrTbl64[0]),
-				     (INTPTR)sizeof(XSdPs_Adma2Descriptor64) * (INTPTR)32U);
+		Xil_DCacheFlushRange((INTPTR) & (DescrTbl[0]),
+				     (INTPTR)sizeof(XSdPs_Adma2Descriptor64) * (INTPTR)TotalDescLines);
 	}
 
 	/* Clear the 64-Bit Address variable */
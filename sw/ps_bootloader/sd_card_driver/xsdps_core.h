@@ -28,6 +28,8 @@
 * 4.0   sk     02/25/22 Add support for eMMC5.1.
 * 4.1   sa     01/06/23 Include xil_util.h in this file.
 * 4.2   ap     08/09/23 Add XSdPs_SetTapDelay APIs.
+* 4.4   mw     10/18/26 Add ADMA2 descriptor table accessors.
+*       mw     10/18/26 Add XSdPs_SetupSgReadDma for scatter-gather reads.
 * </pre>
 *
 ******************************************************************************/
@@ -65,6 +67,9 @@ void XSdPs_ConfigTapDelay(XSdPs *InstancePtr);
 s32 XSdPs_Execute_Tuning(XSdPs *InstancePtr);
 void XSdPs_Setup32ADMA2DescTbl(XSdPs *InstancePtr, u32 BlkCnt, const u8 *Buff);
 void XSdPs_Setup64ADMA2DescTbl(XSdPs *InstancePtr, u32 BlkCnt, const u8 *Buff);
+XSdPs_Adma2Descriptor32 *XSdPs_GetDescrTbl32(XSdPs *InstancePtr);
+XSdPs_Adma2Descriptor64 *XSdPs_GetDescrTbl64(XSdPs *InstancePtr);
+u32 XSdPs_GetDescrLines(XSdPs *InstancePtr);
 u32 XSdPs_FrameCmd(XSdPs *InstancePtr, u32 Cmd);
 void XSdPs_SetTapDelay(XSdPs *InstancePtr);
 s32 XSdPs_CheckResetDone(XSdPs *InstancePtr, u8 Value);
@@ -101,6 +106,7 @@ s32 XSdPs_Change_MmcBusSpeed(XSdPs *InstancePtr);
 s32 XSdPs_CalcBusSpeed(XSdPs *InstancePtr, u32 *Arg);
 void XSdPs_SetupReadDma(XSdPs *InstancePtr, u16 BlkCnt, u16 BlkSize, u8 *Buff);
 void XSdPs_SetupWriteDma(XSdPs *InstancePtr, u16 BlkCnt, u16 BlkSize, const u8 *Buff);
+s32 XSdPs_SetupSgReadDma(XSdPs *InstancePtr, const XSdPs_SgEntry *SgList, u32 SgCount);
 s32 XSdPs_SetVoltage18(XSdPs *InstancePtr);
 s32 XSdPs_SendCmd(XSdPs *InstancePtr, u32 Cmd);
 void XSdPs_IdentifyEmmcMode(XSdPs *InstancePtr, const u8 *ExtCsd);
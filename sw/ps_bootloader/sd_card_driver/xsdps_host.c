@@ -41,6 +41,16 @@
 * 	sa     01/25/23 Use instance structure to store DMA descriptor tables.
 * 4.2   ap     08/09/23 Restructured XSdPs_FrameCmd API
 * 4.3   ap     12/22/23 Add support to read custom HS400 tap delay value from design for eMMC.
+* 4.4   mw     10/18/26 Build ADMA2 descriptors in the caller-supplied table when
+*                       one is registered.
+*       mw     10/18/26 Add XSdPs_SetupSgReadDma to scatter one read into
+*                       several buffers.
+*       mw     10/18/26 Allow switching an SD card back to default speed.
+*       mw     10/18/26 Fall back to SDR12 when the UHS mode fails to switch
+*                       during initialization.
+*       mw     10/18/26 Pre-announce multi-block read lengths with Auto CMD23
+*                       when the SCR advertises CMD23; drop back to Auto
+*                       CMD12 if the card rejects it.
 * </pre>
 *
 ******************************************************************************/
@@ -333,6 +343,12 @@ s32 XSdPs_SdModeInit(XSdPs *InstancePtr)
 		goto RETURN_PATH;
 	}
 
+	/* Auto CMD23 needs a v3 host and a card that lists CMD23 in the SCR */
+	if (((SCR[3] & XSDPS_SCR_CMD23_SUPP) != 0U) &&
+	    (InstancePtr->HC_Version == XSDPS_HC_SPEC_V3)) {
+		InstancePtr->AutoCmd23 = 1U;
+	}
+
 	if ((SCR[1] & WIDTH_4_BIT_SUPPORT) != 0U) {
 		InstancePtr->BusWidth = XSDPS_4_BIT_WIDTH;
 		Status = XSdPs_Change_BusWidth(InstancePtr);
@@ -369,6 +385,18 @@ s32 XSdPs_SdModeInit(XSdPs *InstancePtr)
 		XSdPs_Identify_UhsMode(InstancePtr, ReadBuff);
 
 		Status = XSdPs_Change_BusSpeed(InstancePtr);
+		if ((Status != XST_SUCCESS) &&
+		    (InstancePtr->Mode != XSDPS_UHS_SPEED_MODE_SDR12)) {
+			/*
+			 * Tuning failed; SDR12 needs none. The switch back
+			 * is read at its clock, the untuned one may not work.
+			 */
+			(void)XSdPs_Reset(InstancePtr, XSDPS_SWRST_CMD_LINE_MASK |
+					  XSDPS_SWRST_DAT_LINE_MASK);
+			InstancePtr->Mode = XSDPS_UHS_SPEED_MODE_SDR12;
+			(void)XSdPs_Change_ClkFreq(InstancePtr, XSDPS_SD_SDR12_MAX_CLK);
+			Status = XSdPs_Change_BusSpeed(InstancePtr);
+		}
 		if (Status != XST_SUCCESS) {
 			Status = XST_FAILURE;
 			goto RETURN_PATH;
@@ -925,6 +953,10 @@ s32 XSdPs_CalcBusSpeed(XSdPs *InstancePtr, u32 *Arg)
 				*Arg = XSDPS_SWITCH_CMD_HS_SET;
 				InstancePtr->BusSpeed = XSDPS_CLK_50_MHZ;
 				break;
+			case XSDPS_DEFAULT_SPEED_MODE:
+				*Arg = XSDPS_SWITCH_CMD_DEFAULT_SET;
+				InstancePtr->BusSpeed = SD_CLK_25_MHZ;
+				break;
 			default:
 				Status = XST_FAILURE;
 				break;
@@ -962,6 +994,37 @@ s32 XSdPs_CalcBusSpeed(XSdPs *InstancePtr, u32 *Arg)
 	return Status;
 }
 
+/*****************************************************************************/
+/**
+* @brief
+* Selects how a multi-block read is terminated.
+*
+* With Auto CMD23 the controller sends SET_BLOCK_COUNT ahead of CMD18, so
+* the card knows the length, can prefetch, and leaves the data state by
+* itself; no stop command follows the data. Otherwise Auto CMD12 stops
+* the read after the last block.
+*
+* @param	InstancePtr Pointer to the instance to be worked on.
+* @param	BlkCnt Number of blocks in the read.
+*
+* @return	The Transfer Mode auto command bits.
+*
+******************************************************************************/
+static u16 XSdPs_ReadStopMode(XSdPs *InstancePtr, u32 BlkCnt)
+{
+	u16 AutoCmd;
+
+	if (InstancePtr->AutoCmd23 != 0U) {
+		XSdPs_WriteReg(InstancePtr->Config.BaseAddress,
+			       XSDPS_ARGMT2_LO_OFFSET, BlkCnt & XSDPS_BLK_CNT_MASK);
+		AutoCmd = XSDPS_TM_AUTO_CMD23_EN_MASK;
+	} else {
+		AutoCmd = XSDPS_TM_AUTO_CMD12_EN_MASK;
+	}
+
+	return AutoCmd;
+}
+
 /*****************************************************************************/
 /**
 * @brief
@@ -999,7 +1062,7 @@ void XSdPs_SetupReadDma(XSdPs *InstancePtr, u16 BlkCnt, u16 BlkSize, u8 *Buff)
 		InstancePtr->TransferMode = XSDPS_TM_BLK_CNT_EN_MASK |
 					    XSDPS_TM_DAT_DIR_SEL_MASK | XSDPS_TM_DMA_EN_MASK;
 	} else {
-		InstancePtr->TransferMode = XSDPS_TM_AUTO_CMD12_EN_MASK |
+		InstancePtr->TransferMode = XSdPs_ReadStopMode(InstancePtr, BlkCnt) |
 					    XSDPS_TM_BLK_CNT_EN_MASK | XSDPS_TM_DAT_DIR_SEL_MASK |
 					    XSDPS_TM_DMA_EN_MASK | XSDPS_TM_MUL_SIN_BLK_SEL_MASK;
 	}
@@ -1048,6 +1111,119 @@ void XSdPs_SetupWriteDma(XSdPs *InstancePtr, u16 BlkCnt, u16 BlkSize, const u8 *
 	}
 }
 
+/*****************************************************************************/
+/**
+* @brief
+* Builds one ADMA2 descriptor chain that scatters a contiguous card range
+* into the buffers of a scatter-gather list and sets up the transfer mode.
+*
+* @param	InstancePtr Pointer to the instance to be worked on.
+* @param	SgList List of destination buffers, in card order.
+* @param	SgCount Number of entries in SgList.
+*
+* @return
+* 		- XST_SUCCESS if the chain was built
+* 		- XST_FAILURE if a buffer is misaligned or the chain does not
+* 			fit in the active descriptor table
+*
+******************************************************************************/
+s32 XSdPs_SetupSgReadDma(XSdPs *InstancePtr, const XSdPs_SgEntry *SgList, u32 SgCount)
+{
+	XSdPs_Adma2Descriptor32 *DescrTbl32 = XSdPs_GetDescrTbl32(InstancePtr);
+	XSdPs_Adma2Descriptor64 *DescrTbl64 = XSdPs_GetDescrTbl64(InstancePtr);
+	u32 MaxDescLines = XSdPs_GetDescrLines(InstancePtr);
+	u32 DescNum = 0U;
+	u32 BlkCnt = 0U;
+	u32 Index;
+	u32 Offset;
+	u32 Length;
+	s32 Status;
+
+	XSdPs_WriteReg16(InstancePtr->Config.BaseAddress,
+			 XSDPS_BLK_SIZE_OFFSET,
+			 (u16)(InstancePtr->BlkSize & XSDPS_BLK_SIZE_MASK));
+
+	for (Index = 0U; Index < SgCount; Index++) {
+		if ((SgList[Index].Buff & 0x3U) != 0U) {
+			Status = XST_FAILURE;
+			goto RETURN_PATH;
+		}
+
+		for (Offset = 0U; Offset < SgList[Index].Length;
+		     Offset += XSDPS_DESC_MAX_LENGTH) {
+			if (DescNum >= MaxDescLines) {
+				Status = XST_FAILURE;
+				goto RETURN_PATH;
+			}
+
+			Length = SgList[Index].Length - Offset;
+			if (Length > XSDPS_DESC_MAX_LENGTH) {
+				Length = XSDPS_DESC_MAX_LENGTH;
+			}
+
+			/* A length of 0 encodes a full 64KB descriptor */
+			if (InstancePtr->HC_Version == XSDPS_HC_SPEC_V3) {
+				DescrTbl64[DescNum].Address = (u64)(SgList[Index].Buff + Offset);
+				DescrTbl64[DescNum].Attribute = XSDPS_DESC_TRAN | XSDPS_DESC_VALID;
+				DescrTbl64[DescNum].Length = (u16)Length;
+			} else {
+				DescrTbl32[DescNum].Address = (u32)(SgList[Index].Buff + Offset);
+				DescrTbl32[DescNum].Attribute = XSDPS_DESC_TRAN | XSDPS_DESC_VALID;
+				DescrTbl32[DescNum].Length = (u16)Length;
+			}
+			DescNum++;
+		}
+
+		if (InstancePtr->Config.IsCacheCoherent == 0U) {
+			Xil_DCacheInvalidateRange((INTPTR)SgList[Index].Buff,
+						  (INTPTR)SgList[Index].Length);
+		}
+
+		BlkCnt += SgList[Index].Length / InstancePtr->BlkSize;
+	}
+
+	if (DescNum == 0U) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	if (InstancePtr->HC_Version == XSDPS_HC_SPEC_V3) {
+		DescrTbl64[DescNum - 1U].Attribute |= XSDPS_DESC_END;
+#if defined(__aarch64__) || defined(__arch64__)
+		XSdPs_WriteReg(InstancePtr->Config.BaseAddress, XSDPS_ADMA_SAR_EXT_OFFSET,
+			       (u32)((UINTPTR)(DescrTbl64) >> 32U));
+#endif
+		XSdPs_WriteReg(InstancePtr->Config.BaseAddress, XSDPS_ADMA_SAR_OFFSET,
+			       (u32)((UINTPTR) & (DescrTbl64[0]) & ~(u32)0x0U));
+		if (InstancePtr->Config.IsCacheCoherent == 0U) {
+			Xil_DCacheFlushRange((INTPTR) & (DescrTbl64[0]),
+					     (INTPTR)sizeof(XSdPs_Adma2Descriptor64) * (INTPTR)DescNum);
+		}
+	} else {
+		DescrTbl32[DescNum - 1U].Attribute |= XSDPS_DESC_END;
+		XSdPs_WriteReg(InstancePtr->Config.BaseAddress, XSDPS_ADMA_SAR_OFFSET,
+			       (u32)((UINTPTR) & (DescrTbl32[0]) & ~(u32)0x0U));
+		if (InstancePtr->Config.IsCacheCoherent == 0U) {
+			Xil_DCacheFlushRange((INTPTR) & (DescrTbl32[0]),
+					     (INTPTR)sizeof(XSdPs_Adma2Descriptor32) * (INTPTR)DescNum);
+		}
+	}
+
+	if (BlkCnt == 1U) {
+		InstancePtr->TransferMode = XSDPS_TM_BLK_CNT_EN_MASK |
+					    XSDPS_TM_DAT_DIR_SEL_MASK | XSDPS_TM_DMA_EN_MASK;
+	} else {
+		InstancePtr->TransferMode = XSdPs_ReadStopMode(InstancePtr, BlkCnt) |
+					    XSDPS_TM_BLK_CNT_EN_MASK | XSDPS_TM_DAT_DIR_SEL_MASK |
+					    XSDPS_TM_DMA_EN_MASK | XSDPS_TM_MUL_SIN_BLK_SEL_MASK;
+	}
+
+	Status = XST_SUCCESS;
+
+RETURN_PATH:
+	return Status;
+}
+
 /*****************************************************************************/
 /**
 *
@@ -1068,6 +1244,7 @@ void XSdPs_Setup32ADMA2DescTbl(XSdPs *InstancePtr, u32 BlkCnt, const u8 *Buff)
 	u32 TotalDescLines;
 	u32 DescNum;
 	u32 BlkSize;
+	XSdPs_Adma2Descriptor32 *DescrTbl = XSdPs_GetDescrTbl32(InstancePtr);
 
 	/* Setup ADMA2 - Write descriptor table and point ADMA SAR to it */
 	BlkSize = (u32)XSdPs_ReadReg16(InstancePtr->Config.BaseAddress,
@@ -1084,28 +1261,28 @@ void XSdPs_Setup32ADMA2DescTbl(XSdPs *InstancePtr, u32 BlkCnt, const u8 *Buff)
 	}
 
 	for (DescNum = 0U; DescNum < (TotalDescLines - 1U); DescNum++) {
-		InstancePtr->Adma2_DescrTbl32[DescNum].Address =
+		DescrTbl[DescNum].Address =
 			(u32)((UINTPTR)Buff + ((UINTPTR)DescNum * XSDPS_DESC_MAX_LENGTH));
-		InstancePtr->Adma2_DescrTbl32[DescNum].Attribute =
+		DescrTbl[DescNum].Attribute =
 			XSDPS_DESC_TRAN | XSDPS_DESC_VALID;
-		InstancePtr->Adma2_DescrTbl32[DescNum].Length = 0U;
+		DescrTbl[DescNum].Length = 0U;
 	}
 
-	InstancePtr->Adma2_DescrTbl32[TotalDescLines - 1U].Address =
+	DescrTbl[TotalDescLines - 1U].Address =
 		(u32)((UINTPTR)Buff + ((UINTPTR)DescNum * XSDPS_DESC_MAX_LENGTH));
 
-	InstancePtr->Adma2_DescrTbl32[TotalDescLines - 1U].Attribute =
+	DescrTbl[TotalDescLines - 1U].Attribute =
 		XSDPS_DESC_TRAN | XSDPS_DESC_END | XSDPS_DESC_VALID;
 
-	InstancePtr->Adma2_DescrTbl32[TotalDescLines - 1U].Length =
+	DescrTbl[TotalDescLines - 1U].Length =
 		(u16)((BlkCnt * BlkSize) - (u32)(DescNum * XSDPS_DESC_MAX_LENGTH));
 
 	XSdPs_WriteReg(InstancePtr->Config.BaseAddress, XSDPS_ADMA_SAR_OFFSET,
-		       (u32)((UINTPTR) & (InstancePtr->Adma2_DescrTbl32[0]) & ~(u32)0x0U));
+		       (u32)((UINTPTR) & (DescrTbl[0]) & ~(u32)0x0U));
 
 	if (InstancePtr->Config.IsCacheCoherent == 0U) {
-		Xil_DCacheFlushRange((INTPTR) & (InstancePtr->Adma2_DescrTbl32[0]),
-				     (INTPTR)sizeof(XSdPs_Adma2Descriptor32) * (INTPTR)32U);
+		Xil_DCacheFlushRange((INTPTR) & (DescrTbl[0]),
+				     (INTPTR)sizeof(XSdPs_Adma2Descriptor32) * (INTPTR)TotalDescLines);
 	}
 }
 
@@ -1128,6 +1305,7 @@ void XSdPs_Setup64ADMA2DescTbl(XSdPs *InstancePtr, u32 BlkCnt, const u8 *Buff)
 	u32 TotalDescLines;
 	u32 DescNum;
 	u32 BlkSize;
+	XSdPs_Adma2Descriptor64 *DescrTbl = XSdPs_GetDescrTbl64(InstancePtr);
 
 	/* Setup ADMA2 - Write descriptor table and point ADMA SAR to it */
 	BlkSize = (u32)XSdPs_ReadReg16(InstancePtr->Config.BaseAddress,
@@ -1144,36 +1322,104 @@ void XSdPs_Setup64ADMA2DescTbl(XSdPs *InstancePtr, u32 BlkCnt, const u8 *Buff)
 	}
 
 	for (DescNum = 0U; DescNum < (TotalDescLines - 1U); DescNum++) {
-		InstancePtr->Adma2_DescrTbl64[DescNum].Address =
+		DescrTbl[DescNum].Address =
 			((UINTPTR)Buff + ((UINTPTR)DescNum * XSDPS_DESC_MAX_LENGTH));
-		InstancePtr->Adma2_DescrTbl64[DescNum].Attribute =
+		DescrTbl[DescNum].Attribute =
 			XSDPS_DESC_TRAN | XSDPS_DESC_VALID;
-		InstancePtr->Adma2_DescrTbl64[DescNum].Length = 0U;
+		DescrTbl[DescNum].Length = 0U;
 	}
 
-	InstancePtr->Adma2_DescrTbl64[TotalDescLines - 1U].Address =
+	DescrTbl[TotalDescLines - 1U].Address =
 		(u64)((UINTPTR)Buff + ((UINTPTR)DescNum * XSDPS_DESC_MAX_LENGTH));
 
-	InstancePtr->Adma2_DescrTbl64[TotalDescLines - 1U].Attribute =
+	DescrTbl[TotalDescLines - 1U].Attribute =
 		XSDPS_DESC_TRAN | XSDPS_DESC_END | XSDPS_DESC_VALID;
 
-	InstancePtr->Adma2_DescrTbl64[TotalDescLines - 1U].Length =
+	DescrTbl[TotalDescLines - 1U].Length =
 		(u16)((BlkCnt * BlkSize) - (u32)(DescNum * XSDPS_DESC_MAX_LENGTH));
 
 #if defined(__aarch64__) || defined(__arch64__)
 	XSdPs_WriteReg(InstancePtr->Config.BaseAddress, XSDPS_ADMA_SAR_EXT_OFFSET,
-		       (u32)((UINTPTR)(InstancePtr->Adma2_DescrTbl64) >> 32U));
+		       (u32)((UINTPTR)(DescrTbl) >> 32U));
 #endif
 
 	XSdPs_WriteReg(InstancePtr->Config.BaseAddress, XSDPS_ADMA_SAR_OFFSET,
-		       (u32)((UINTPTR) & (InstancePtr->Adma2_DescrTbl64[0]) & ~(u32)0x0U));
+		       (u32)((UINTPTR) & (DescrTbl[0]) & ~(u32)0x0U));
 
 	if (InstancePtr->Config.IsCacheCoherent == 0U) {
-		Xil_DCacheFlushRange((INTPTR) & (InstancePtr->Adma2_DescrTbl64[0]),
-				     (INTPTR)sizeof(XSdPs_Adma2Descriptor64) * (INTPTR)32U);
+		Xil_DCacheFlushRange((INTPTR) & (DescrTbl[0]),
+				     (INTPTR)sizeof(XSdPs_Adma2Descriptor64) * (INTPTR)TotalDescLines);
 	}
 }
 
+/*****************************************************************************/
+/**
+*
+* @brief
+* Returns the ADMA2 descriptor table to be used for 32-bit descriptors.
+*
+*
+* @param	InstancePtr Pointer to the XSdPs instance.
+*
+* @return	Caller-supplied table if one is registered, else the table
+*		embedded in the instance.
+*
+******************************************************************************/
+XSdPs_Adma2Descriptor32 *XSdPs_GetDescrTbl32(XSdPs *InstancePtr)
+{
+	if (InstancePtr->Adma2_UserDescrTbl != NULL) {
+		return (XSdPs_Adma2Descriptor32 *)(void *)InstancePtr->Adma2_UserDescrTbl;
+	}
+
+	return InstancePtr->Adma2_DescrTbl32;
+}
+
+/*****************************************************************************/
+/**
+*
+* @brief
+* Returns the ADMA2 descriptor table to be used for 64-bit descriptors.
+*
+*
+* @param	InstancePtr Pointer to the XSdPs instance.
+*
+* @return	Caller-supplied table if one is registered, else the table
+*		embedded in the instance.
+*
+******************************************************************************/
+XSdPs_Adma2Descriptor64 *XSdPs_GetDescrTbl64(XSdPs *InstancePtr)
+{
+	if (InstancePtr->Adma2_UserDescrTbl != NULL) {
+		return InstancePtr->Adma2_UserDescrTbl;
+	}
+
+	return InstancePtr->Adma2_DescrTbl64;
+}
+
+/*****************************************************************************/
+/**
+*
+* @brief
+* Returns the number of entries in the active ADMA2 descriptor table.
+*
+*
+* @param	InstancePtr Pointer to the XSdPs instance.
+*
+* @return	Number of descriptor lines available for one transfer.
+*
+* @note		A caller-supplied table is sized in 64-bit descriptors, which
+*		are larger than 32-bit ones, so the count is valid for both.
+*
+******************************************************************************/
+u32 XSdPs_GetDescrLines(XSdPs *InstancePtr)
+{
+	if (InstancePtr->Adma2_UserDescrTbl != NULL) {
+		return InstancePtr->Adma2_UserDescrLines;
+	}
+
+	return XSDPS_DEF_DESC_LINES;
+}
+
 /*****************************************************************************/
 /**
 * @brief
@@ -1599,6 +1845,10 @@ s32 XSdPs_CmdTransfer(XSdPs *InstancePtr, u32 Cmd, u32 Arg, u32 BlkCnt)
 	if ((StatusReg & XSDPS_INTR_ERR_MASK) != 0U) {
 		Status = (s32)XSdPs_ReadReg16(InstancePtr->Config.BaseAddress,
 					      XSDPS_ERR_INTR_STS_OFFSET);
+		if (((u32)Status & XSDPS_INTR_ERR_AUTO_CMD12_MASK) != 0U) {
+			/* Auto CMD23 was refused; stop reads with Auto CMD12 from now on */
+			InstancePtr->AutoCmd23 = 0U;
+		}
 		if (((u32)Status & ~XSDPS_INTR_ERR_CT_MASK) == 0U) {
 			Status = XSDPS_CT_ERROR;
 		}
@@ -1650,6 +1900,11 @@ s32 XSdps_CheckTransferDone(XSdPs *InstancePtr)
 	}
 
 	if ((StatusReg & XSDPS_INTR_ERR_MASK) != 0U) {
+		if ((XSdPs_ReadReg16(InstancePtr->Config.BaseAddress,
+				     XSDPS_ERR_INTR_STS_OFFSET) &
+		     XSDPS_INTR_ERR_AUTO_CMD12_MASK) != 0U) {
+			InstancePtr->AutoCmd23 = 0U;
+		}
 		/* Write to clear error bits */
 		XSdPs_WriteReg16(InstancePtr->Config.BaseAddress,
 				 XSDPS_ERR_INTR_STS_OFFSET,
@@ -48,6 +48,8 @@
 * 4.2   ro     06/12/23 Added support for system device-tree flow.
 * 4.3   ap     11/29/23 Add support for Sanitize feature.
 * 4.3   ap     12/22/23 Add support to read custom HS400 tap delay value from design for eMMC.
+* 4.4   mw     10/18/26 Add XSDPS_SWITCH_CMD_DEFAULT_SET.
+*       mw     10/18/26 Add XSDPS_TM_AUTO_CMD23_EN_MASK.
 *
 * </pre>
 *
@@ -330,6 +332,7 @@ extern "C" {
 #define XSDPS_TM_DMA_EN_MASK		0x00000001U /**< DMA Enable */
 #define XSDPS_TM_BLK_CNT_EN_MASK	0x00000002U /**< Block Count Enable */
 #define XSDPS_TM_AUTO_CMD12_EN_MASK	0x00000004U /**< Auto CMD12 Enable */
+#define XSDPS_TM_AUTO_CMD23_EN_MASK	0x00000008U /**< Auto CMD23 Enable */
 #define XSDPS_TM_DAT_DIR_SEL_MASK	0x00000010U /**< Data Transfer
 							Direction Select */
 #define XSDPS_TM_MUL_SIN_BLK_SEL_MASK	0x00000020U /**< Multi/Single
@@ -1112,6 +1115,7 @@ extern "C" {
 #define XSDPS_SWITCH_CMD_SDR50_SET		0x80FFFFF2U /**< SWITCH cmd to Set SDR50 */
 #define XSDPS_SWITCH_CMD_SDR104_SET		0x80FFFFF3U /**< SWITCH cmd to Set SDR104 */
 #define XSDPS_SWITCH_CMD_DDR50_SET		0x80FFFFF4U /**< SWITCH cmd to Set DDR50 */
+#define XSDPS_SWITCH_CMD_DEFAULT_SET	0x80FFFFF0U /**< SWITCH cmd to Set default speed */
 #define XSDPS_EXT_CSD_CMD_BLKCNT	1U	/**< Blk Cnt for EXT CSD */
 #define XSDPS_EXT_CSD_CMD_BLKSIZE	512U	/**< Blk Sz for EXT CSD */
 #define XSDPS_TUNING_CMD_BLKCNT		1U	/**< Blk Cnt for Tuning cmd */
@@ -64,6 +64,10 @@
 * 3.14  mn     11/28/21 Fix MISRA-C violations.
 * 4.0   sk     02/25/22 Add support for eMMC5.1.
 * 4.1   sk     11/10/22 Add SD/eMMC Tap delay support for Versal Net.
+* 4.4   mw     10/18/26 Add APIs to register a larger ADMA2 descriptor table.
+*       mw     10/18/26 Add XSdPs_StartReadSG.
+*       mw     10/18/26 Add XSdPs_SelectBusSpeed to pick the fastest SD bus
+*                       mode that passes a read-back check.
 *
 * </pre>
 *
@@ -71,6 +75,7 @@
 
 /***************************** Include Files *********************************/
 #include "xsdps_core.h"
+#include <string.h>
 /************************** Constant Definitions *****************************/
 /**************************** Type Definitions *******************************/
 
@@ -189,6 +194,93 @@ RETURN_PATH:
 	return Status;
 }
 
+/*****************************************************************************/
+/**
+* @brief
+* Registers a caller-supplied ADMA2 descriptor table.
+*
+* @param	InstancePtr Pointer to the instance to be worked on.
+* @param	DescrTbl Descriptor table, aligned to 32 bytes. NULL restores
+*		the tables embedded in the instance.
+* @param	DescrLines Number of entries in DescrTbl.
+*
+* @return
+*		- XST_SUCCESS if successful.
+*		- XST_FAILURE if the table is misaligned or empty, or a transfer
+*		is in progress.
+*
+* @note		Each descriptor moves up to XSDPS_DESC_MAX_LENGTH bytes, so a
+*		table of N entries allows single transfers of N * 64KB. The
+*		16-bit block count register still limits a transfer to
+*		XSDPS_BLK_CNT_MASK blocks. The table must stay valid for as long
+*		as it is registered.
+*
+******************************************************************************/
+s32 XSdPs_SetAdma2DescrTbl(XSdPs *InstancePtr, XSdPs_Adma2Descriptor64 *DescrTbl,
+			   u32 DescrLines)
+{
+	s32 Status;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	if (InstancePtr->IsBusy == TRUE) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	if (DescrTbl == NULL) {
+		InstancePtr->Adma2_UserDescrTbl = NULL;
+		InstancePtr->Adma2_UserDescrLines = 0U;
+		Status = XST_SUCCESS;
+		goto RETURN_PATH;
+	}
+
+	if ((DescrLines == 0U) || (((UINTPTR)DescrTbl & 0x1FU) != 0U)) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	InstancePtr->Adma2_UserDescrTbl = DescrTbl;
+	InstancePtr->Adma2_UserDescrLines = DescrLines;
+
+	Status = XST_SUCCESS;
+
+RETURN_PATH:
+	return Status;
+}
+
+/*****************************************************************************/
+/**
+* @brief
+* Returns the largest transfer, in bytes, a single read or write can do.
+*
+* @param	InstancePtr Pointer to the instance to be worked on.
+*
+* @return	Maximum transfer length in bytes.
+*
+******************************************************************************/
+u32 XSdPs_GetMaxTransferLen(XSdPs *InstancePtr)
+{
+	u32 MaxLen;
+	u32 Lines;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+
+	/* Clamp first so that Lines * 64KB cannot wrap */
+	Lines = XSdPs_GetDescrLines(InstancePtr);
+	if (Lines > (0xFFFFFFFFU / XSDPS_DESC_MAX_LENGTH)) {
+		Lines = 0xFFFFFFFFU / XSDPS_DESC_MAX_LENGTH;
+	}
+	MaxLen = Lines * XSDPS_DESC_MAX_LENGTH;
+	if ((InstancePtr->BlkSize != 0U) &&
+	    (MaxLen / InstancePtr->BlkSize) > XSDPS_BLK_CNT_MASK) {
+		MaxLen = XSDPS_BLK_CNT_MASK * InstancePtr->BlkSize;
+	}
+
+	return MaxLen;
+}
+
 /*****************************************************************************/
 /**
 *
@@ -546,7 +638,11 @@ s32 XSdPs_Change_BusSpeed(XSdPs *InstancePtr)
 
 	StatusReg = (u32)XSdPs_ReadReg8(InstancePtr->Config.BaseAddress,
 					XSDPS_HOST_CTRL1_OFFSET);
-	StatusReg |= XSDPS_HC_SPEED_MASK;
+	if (InstancePtr->Mode == XSDPS_DEFAULT_SPEED_MODE) {
+		StatusReg &= ~(u32)XSDPS_HC_SPEED_MASK;
+	} else {
+		StatusReg |= XSDPS_HC_SPEED_MASK;
+	}
 	XSdPs_WriteReg8(InstancePtr->Config.BaseAddress,
 			XSDPS_HOST_CTRL1_OFFSET, (u8)StatusReg);
 
@@ -568,6 +664,217 @@ s32 XSdPs_Change_BusSpeed(XSdPs *InstancePtr)
 
 }
 
+/*****************************************************************************/
+/**
+*
+* @brief
+* Switches the card and host to a bus speed mode, falling back to the
+* mode's safe counterpart if the switch or a read-back check fails.
+*
+* @param	InstancePtr Pointer to the XSdPs instance.
+* @param	Mode Bus speed mode to try.
+* @param	Arg Address argument of the blocks used for the check.
+* @param	BlkCnt Number of blocks used for the check.
+* @param	RefBuff Blocks read in the safe mode, or NULL to skip the check.
+* @param	ReadBuff Buffer for the check read.
+*
+* @return
+*		- XST_SUCCESS if the card works in the mode.
+*		- XST_FAILURE if not.
+*
+******************************************************************************/
+static s32 XSdPs_TryBusSpeed(XSdPs *InstancePtr, u32 Mode, u32 Arg, u32 BlkCnt,
+			     const u8 *RefBuff, u8 *ReadBuff)
+{
+	s32 Status;
+	u16 CtrlReg;
+
+	/* Drop the tuned sampling clock left by an earlier SDR104/SDR50 attempt */
+	CtrlReg = XSdPs_ReadReg16(InstancePtr->Config.BaseAddress,
+				  XSDPS_HOST_CTRL2_OFFSET);
+	XSdPs_WriteReg16(InstancePtr->Config.BaseAddress, XSDPS_HOST_CTRL2_OFFSET,
+			 CtrlReg & (u16)~XSDPS_HC2_SAMP_CLK_SEL_MASK);
+
+	/*
+	 * The CMD6 status block of the switch comes in the old mode. Past the
+	 * SDR25 clock it cannot be sampled untuned, so read it at the SDR12
+	 * clock, which every mode accepts.
+	 */
+	if (InstancePtr->BusSpeed > XSDPS_SD_SDR25_MAX_CLK) {
+		Status = XSdPs_Change_ClkFreq(InstancePtr, XSDPS_SD_SDR12_MAX_CLK);
+		if (Status != XST_SUCCESS) {
+			Status = XST_FAILURE;
+			goto RETURN_PATH;
+		}
+	}
+
+	InstancePtr->Mode = Mode;
+	InstancePtr->IsTuningDone = 0U;
+	switch (Mode) {
+		case XSDPS_UHS_SPEED_MODE_SDR104:
+			XSdPs_SetTapDelay_SDR104(InstancePtr);
+			break;
+		case XSDPS_UHS_SPEED_MODE_SDR50:
+			XSdPs_SetTapDelay_SDR50(InstancePtr);
+			break;
+		case XSDPS_UHS_SPEED_MODE_DDR50:
+			XSdPs_SetTapDelay_DDR50(InstancePtr);
+			break;
+		case XSDPS_UHS_SPEED_MODE_SDR25:
+		case XSDPS_HIGH_SPEED_MODE:
+			XSdPs_SetTapDelay_SDR25(InstancePtr);
+			break;
+		default:
+			break;
+	}
+
+	Status = XSdPs_Change_BusSpeed(InstancePtr);
+	if (Status != XST_SUCCESS) {
+		/* Clear any half-finished tuning or CMD6 data phase */
+		(void)XSdPs_Reset(InstancePtr, XSDPS_SWRST_CMD_LINE_MASK |
+				  XSDPS_SWRST_DAT_LINE_MASK);
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	if (RefBuff != NULL) {
+		Status = XSdPs_ReadPolled(InstancePtr, Arg, BlkCnt, ReadBuff);
+		if (Status != XST_SUCCESS) {
+			(void)XSdPs_Reset(InstancePtr, XSDPS_SWRST_CMD_LINE_MASK |
+					  XSDPS_SWRST_DAT_LINE_MASK);
+			Status = XST_FAILURE;
+			goto RETURN_PATH;
+		}
+		if (memcmp(RefBuff, ReadBuff, (size_t)BlkCnt * InstancePtr->BlkSize) != 0) {
+			Status = XST_FAILURE;
+			goto RETURN_PATH;
+		}
+	}
+
+	Status = XST_SUCCESS;
+
+RETURN_PATH:
+	return Status;
+}
+
+/*****************************************************************************/
+/**
+*
+* @brief
+* Selects the fastest bus speed mode that the card, the host clock and the
+* board all handle.
+*
+* The card is first put in a safe mode (SDR12 after a 1.8V switch, default
+* speed otherwise) and the check blocks are read as a reference. The modes
+* the card advertises are then tried from the fastest down (SDR104, SDR50,
+* DDR50, SDR25, or High Speed at 3.3V). A mode is kept if the switch, any
+* tuning and a read-back of the check blocks that matches the reference all
+* succeed; otherwise the card goes back to the safe mode and the next one is
+* tried.
+*
+* @param	InstancePtr Pointer to the XSdPs instance.
+* @param	Arg Address argument of the blocks used for the check.
+* @param	BlkCnt Number of blocks used for the check.
+* @param	RefBuff Buffer of BlkCnt blocks for the reference read.
+* @param	ReadBuff Buffer of BlkCnt blocks for the check reads.
+*
+* @return
+*		- XST_SUCCESS if a mode was selected. InstancePtr->Mode and
+*		  InstancePtr->BusSpeed report which.
+*		- XST_FAILURE if the card does not even work in the safe mode.
+*
+* @note		eMMC devices are left in the mode chosen at initialization.
+*		A card that was not switched to 1.8V during initialization
+*		cannot use the UHS-I modes.
+*
+******************************************************************************/
+s32 XSdPs_SelectBusSpeed(XSdPs *InstancePtr, u32 Arg, u32 BlkCnt, u8 *RefBuff,
+			 u8 *ReadBuff)
+{
+	static const u32 UhsModes[] = {
+		XSDPS_UHS_SPEED_MODE_SDR104, XSDPS_UHS_SPEED_MODE_SDR50,
+		XSDPS_UHS_SPEED_MODE_DDR50, XSDPS_UHS_SPEED_MODE_SDR25
+	};
+	static const u8 UhsSupport[] = {
+		UHS_SDR104_SUPPORT, UHS_SDR50_SUPPORT,
+		UHS_DDR50_SUPPORT, UHS_SDR25_SUPPORT
+	};
+	static const u32 UhsMinClk[] = {
+		XSDPS_SD_INPUT_MAX_CLK, XSDPS_SD_SDR50_MAX_CLK,
+		XSDPS_SD_DDR50_MAX_CLK, XSDPS_SD_SDR25_MAX_CLK
+	};
+#ifdef __ICCARM__
+#pragma data_alignment = 32
+	static u8 SwitchBuff[64];
+#else
+	static u8 SwitchBuff[64] __attribute__ ((aligned(32)));
+#endif
+	u32 SafeMode;
+	u32 Index;
+	s32 Status;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid(RefBuff != NULL);
+	Xil_AssertNonvoid(ReadBuff != NULL);
+
+	if (InstancePtr->CardType != XSDPS_CARD_SD) {
+		Status = XST_SUCCESS;
+		goto RETURN_PATH;
+	}
+
+	Status = XSdPs_Get_BusSpeed(InstancePtr, SwitchBuff);
+	if (Status != XST_SUCCESS) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	SafeMode = (InstancePtr->Switch1v8 != 0U) ? XSDPS_UHS_SPEED_MODE_SDR12 :
+		   XSDPS_DEFAULT_SPEED_MODE;
+	Status = XSdPs_TryBusSpeed(InstancePtr, SafeMode, Arg, BlkCnt, NULL, NULL);
+	if (Status != XST_SUCCESS) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+	Status = XSdPs_ReadPolled(InstancePtr, Arg, BlkCnt, RefBuff);
+	if (Status != XST_SUCCESS) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	if (InstancePtr->Switch1v8 != 0U) {
+		for (Index = 0U; Index < (u32)(sizeof(UhsModes) / sizeof(UhsModes[0])); Index++) {
+			if (((SwitchBuff[13] & UhsSupport[Index]) == 0U) ||
+			    (InstancePtr->Config.InputClockHz < UhsMinClk[Index])) {
+				continue;
+			}
+			Status = XSdPs_TryBusSpeed(InstancePtr, UhsModes[Index], Arg,
+						   BlkCnt, RefBuff, ReadBuff);
+			if (Status == XST_SUCCESS) {
+				goto RETURN_PATH;
+			}
+			(void)XSdPs_TryBusSpeed(InstancePtr, SafeMode, Arg, BlkCnt,
+						NULL, NULL);
+		}
+	} else if (((SwitchBuff[13] & HIGH_SPEED_SUPPORT) != 0U) &&
+		   (InstancePtr->BusWidth >= XSDPS_4_BIT_WIDTH)) {
+		Status = XSdPs_TryBusSpeed(InstancePtr, XSDPS_HIGH_SPEED_MODE, Arg,
+					   BlkCnt, RefBuff, ReadBuff);
+		if (Status == XST_SUCCESS) {
+			goto RETURN_PATH;
+		}
+	}
+
+	/* Nothing faster passed; settle in the safe mode the reference came from */
+	Status = XSdPs_TryBusSpeed(InstancePtr, SafeMode, Arg, BlkCnt, RefBuff, ReadBuff);
+	if (Status != XST_SUCCESS) {
+		Status = XST_FAILURE;
+	}
+
+RETURN_PATH:
+	return Status;
+}
+
 /*****************************************************************************/
 /**
 *
@@ -793,6 +1100,93 @@ RETURN_PATH:
 	return Status;
 }
 
+/*****************************************************************************/
+/**
+* @brief
+* Starts a scatter-gather SD read without waiting for it to complete.
+*
+* All entries must follow each other on the card; they are read with one
+* CMD17/CMD18 whose ADMA2 chain scatters the data into the entry buffers.
+* Completion is polled with XSdPs_CheckReadTransfer().
+*
+* @param	InstancePtr Pointer to the instance to be worked on.
+* @param	SgList List of (sector, buffer, length) entries.
+* @param	SgCount Number of entries in SgList.
+*
+* @return
+* 		- XST_SUCCESS if the transfer was started
+* 		- XST_FAILURE if failure - could be because another transfer
+* 		is in progress, the entries are not contiguous on the card or
+* 		not whole blocks, or they do not fit in the descriptor table
+*
+* @note		The data cache is not invalidated on completion; callers on
+*		non-coherent configurations must do so before using the data.
+*
+******************************************************************************/
+s32 XSdPs_StartReadSG(XSdPs *InstancePtr, const XSdPs_SgEntry *SgList, u32 SgCount)
+{
+	s32 Status;
+	u32 Index;
+	u32 BlkCnt = 0U;
+	u32 Arg;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+	Xil_AssertNonvoid(SgList != NULL);
+
+	if ((InstancePtr->IsBusy == TRUE) || (SgCount == 0U)) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	for (Index = 0U; Index < SgCount; Index++) {
+		if ((SgList[Index].Length == 0U) ||
+		    ((SgList[Index].Length % InstancePtr->BlkSize) != 0U) ||
+		    (SgList[Index].Sector != (SgList[0].Sector + BlkCnt))) {
+			Status = XST_FAILURE;
+			goto RETURN_PATH;
+		}
+		BlkCnt += SgList[Index].Length / InstancePtr->BlkSize;
+	}
+	if (BlkCnt > XSDPS_BLK_CNT_MASK) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	/* Setup the Read Transfer */
+	Status = XSdPs_SetupTransfer(InstancePtr);
+	if (Status != XST_SUCCESS) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	Status = XSdPs_SetupSgReadDma(InstancePtr, SgList, SgCount);
+	if (Status != XST_SUCCESS) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	Arg = SgList[0].Sector;
+	if (InstancePtr->HCS == 0U) {
+		Arg *= InstancePtr->BlkSize;
+	}
+
+	if (BlkCnt == 1U) {
+		Status = XSdPs_CmdTransfer(InstancePtr, CMD17, Arg, BlkCnt);
+	} else {
+		Status = XSdPs_CmdTransfer(InstancePtr, CMD18, Arg, BlkCnt);
+	}
+	if (Status != XST_SUCCESS) {
+		Status = XST_FAILURE;
+		goto RETURN_PATH;
+	}
+
+	InstancePtr->IsBusy = TRUE;
+
+RETURN_PATH:
+	return Status;
+}
+
 /*****************************************************************************/
 /**
 * @brief